@@ -60,6 +60,7 @@ void Adafruit_I2CDevice::end(void) {
  *    @return True if I2C initialized and a device with the addr found
  */
 bool Adafruit_I2CDevice::detected(void) {
+  I2CBusLock lock(_wire);
   // Init I2C if not done yet
   if (!_begun && !begin()) {
     return false;
@@ -95,6 +96,7 @@ bool Adafruit_I2CDevice::detected(void) {
 bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
                                const uint8_t *prefix_buffer,
                                size_t prefix_len) {
+  I2CBusLock lock(_wire);
   if ((len + prefix_len) > maxBufferSize()) {
     // currently not guaranteed to work if more than 32 bytes!
     // we will need to find out if some platforms have larger
@@ -174,6 +176,7 @@ bool Adafruit_I2CDevice::write(const uint8_t *buffer, size_t len, bool stop,
  *    @return True if read was successful, otherwise false.
  */
 bool Adafruit_I2CDevice::read(uint8_t *buffer, size_t len, bool stop) {
+  I2CBusLock lock(_wire);
   size_t pos = 0;
   while (pos < len) {
     size_t read_len =
@@ -240,6 +243,7 @@ bool Adafruit_I2CDevice::_read(uint8_t *buffer, size_t len, bool stop) {
 bool Adafruit_I2CDevice::write_then_read(const uint8_t *write_buffer,
                                          size_t write_len, uint8_t *read_buffer,
                                          size_t read_len, bool stop) {
+  I2CBusLock lock(_wire);
   if (!write(write_buffer, write_len, stop)) {
     return false;
   }
@@ -117,6 +117,16 @@ Adafruit_NeoPixel::Adafruit_NeoPixel()
   @brief   Deallocate Adafruit_NeoPixel object, set data pin back to INPUT.
 */
 Adafruit_NeoPixel::~Adafruit_NeoPixel() {
+#if defined(NEO_SAMD21_DMA)
+  if (dmaSercom) {
+    noInterrupts();
+    DMAC->CHID.reg = DMAC_CHID_ID(dmaChannel);
+    DMAC->CHCTRLA.reg = 0;
+    interrupts();
+    dmaSercom->SPI.CTRLA.bit.ENABLE = 0;
+  }
+  free(dmaBuf);
+#endif
   free(pixels);
   if (pin >= 0)
     pinMode(pin, INPUT);
@@ -227,6 +237,133 @@ void  Adafruit_NeoPixel::rp2040Show(uint8_t pin, uint8_t *pixels, uint32_t numBy
 
 #endif
 
+// SAMD21 SERCOM-SPI + DMA driver
+#if defined(NEO_SAMD21_DMA)
+#include "wiring_private.h" // pinPeripheral()
+#include "samd21_spi.h"      // samd21SpiEncode()
+
+// DMAC descriptors for channels 0 to NEO_DMA_CHANNELS-1
+static DmacDescriptor neoDmaDesc[NEO_DMA_CHANNELS] __attribute__((aligned(16)));
+static DmacDescriptor neoDmaWb[NEO_DMA_CHANNELS] __attribute__((aligned(16)));
+static uint8_t neoDmaUsed = 0;
+
+/*!
+  @brief   Drive this strip from a SERCOM in SPI master mode fed by DMA
+           instead of bit-banging. show() then encodes the frame, starts
+           the transfer and returns while the data is still being sent,
+           interrupts stay enabled the whole time.
+  @param   sercom  SERCOM that can output on the data pin, e.g. SERCOM3.
+  @param   pad     SERCOM pad of the data pin: 0, 2 or 3.
+  @param   mux     Pin function of that pad, PIO_SERCOM or PIO_SERCOM_ALT.
+  @return  true on success. false if no DMA channel or memory is left, or
+           if the DMAC was already set up by other code; the strip then
+           keeps using the bit-bang output.
+  @note    Call after begin(). Don't call setPin() afterwards.
+*/
+bool Adafruit_NeoPixel::setDMA(Sercom *sercom, uint8_t pad, EPioType mux) {
+  static const uint8_t dopo[4] = {0, 0xFF, 1, 2}; // Data out on PAD0/2/3
+  uint32_t id = ((uint32_t)sercom - (uint32_t)SERCOM0) / 0x400;
+
+  if ((pin < 0) || (pad > 3) || (dopo[pad] == 0xFF) || (id > 5) ||
+      dmaSercom || (neoDmaUsed >= NEO_DMA_CHANNELS))
+    return false;
+  if (DMAC->CTRL.bit.DMAENABLE &&
+      (DMAC->BASEADDR.reg != (uint32_t)neoDmaDesc))
+    return false;
+  if (!(dmaBuf = (uint8_t *)malloc(NEO_SPI_BYTES(numBytes))))
+    return false;
+  dmaBytes = numBytes;
+
+  // SERCOM clock from GCLK0 (48 MHz)
+  PM->APBCMASK.reg |= PM_APBCMASK_SERCOM0 << id;
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID(GCLK_CLKCTRL_ID_SERCOM0_CORE_Val + id) |
+                      GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_CLKEN;
+  while (GCLK->STATUS.bit.SYNCBUSY)
+    ;
+
+  // SPI master, MSB first, transmit only
+  sercom->SPI.CTRLA.bit.SWRST = 1;
+  while (sercom->SPI.CTRLA.bit.SWRST || sercom->SPI.SYNCBUSY.bit.SWRST)
+    ;
+  sercom->SPI.CTRLA.reg =
+      SERCOM_SPI_CTRLA_MODE_SPI_MASTER | SERCOM_SPI_CTRLA_DOPO(dopo[pad]);
+  sercom->SPI.CTRLB.reg = 0;
+  while (sercom->SPI.SYNCBUSY.bit.CTRLB)
+    ;
+#if defined(NEO_KHZ400)
+  sercom->SPI.BAUD.reg = F_CPU / (2 * (is800KHz ? NEO_SPI_HZ : NEO_SPI_HZ / 2)) - 1;
+#else
+  sercom->SPI.BAUD.reg = F_CPU / (2 * NEO_SPI_HZ) - 1;
+#endif
+  sercom->SPI.CTRLA.bit.ENABLE = 1;
+  while (sercom->SPI.SYNCBUSY.bit.ENABLE)
+    ;
+
+  // One beat (byte) per SERCOM TX request
+  PM->AHBMASK.reg |= PM_AHBMASK_DMAC;
+  PM->APBBMASK.reg |= PM_APBBMASK_DMAC;
+  if (!DMAC->CTRL.bit.DMAENABLE) {
+    DMAC->BASEADDR.reg = (uint32_t)neoDmaDesc;
+    DMAC->WRBADDR.reg = (uint32_t)neoDmaWb;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+  }
+  dmaChannel = neoDmaUsed++;
+  noInterrupts();
+  DMAC->CHID.reg = DMAC_CHID_ID(dmaChannel);
+  DMAC->CHCTRLA.reg = 0;
+  DMAC->CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+  while (DMAC->CHCTRLA.bit.SWRST)
+    ;
+  DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) |
+                      DMAC_CHCTRLB_TRIGSRC(SERCOM0_DMAC_ID_TX + 2 * id) |
+                      DMAC_CHCTRLB_TRIGACT_BEAT;
+  interrupts();
+
+  dmaSercom = sercom;
+  pinPeripheral(pin, mux);
+
+  return true;
+}
+
+// Not a user API
+void Adafruit_NeoPixel::samd21DmaShow(void) {
+  DmacDescriptor *desc = &neoDmaDesc[dmaChannel];
+  uint32_t len;
+  bool busy;
+
+  // Previous frame (and its latch) may still be going out
+  do {
+    noInterrupts();
+    DMAC->CHID.reg = DMAC_CHID_ID(dmaChannel);
+    busy = DMAC->CHCTRLA.bit.ENABLE;
+    interrupts();
+  } while (busy);
+
+  if (dmaBytes != numBytes) { // Strip length changed
+    free(dmaBuf);
+    if (!(dmaBuf = (uint8_t *)malloc(NEO_SPI_BYTES(numBytes)))) {
+      dmaBytes = 0;
+      return;
+    }
+    dmaBytes = numBytes;
+  }
+
+  len = samd21SpiEncode(dmaBuf, pixels, numBytes);
+
+  desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BEATSIZE_BYTE |
+                     DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BLOCKACT_NOACT;
+  desc->BTCNT.reg = len;
+  desc->SRCADDR.reg = (uint32_t)dmaBuf + len; // End address with SRCINC
+  desc->DSTADDR.reg = (uint32_t)&dmaSercom->SPI.DATA.reg;
+  desc->DESCADDR.reg = 0;
+
+  noInterrupts();
+  DMAC->CHID.reg = DMAC_CHID_ID(dmaChannel);
+  DMAC->CHCTRLA.reg = DMAC_CHCTRLA_ENABLE;
+  interrupts();
+}
+#endif
+
 #if defined(ESP8266)
 // ESP8266 show() is external to enforce ICACHE_RAM_ATTR execution
 extern "C" IRAM_ATTR void espShow(uint16_t pin, uint8_t *pixels,
@@ -254,12 +391,21 @@ extern "C" void k210Show(uint8_t pin, uint8_t *pixels, uint32_t numBytes,
            RGBW pixels). There's no easy fix for this, but a few
            specialized alternative or companion libraries exist that use
            very device-specific peripherals to work around it.
+           On SAMD21, a strip switched to setDMA() keeps interrupts enabled
+           and show() returns before the frame has been sent.
 */
 void Adafruit_NeoPixel::show(void) {
 
   if (!pixels)
     return;
 
+#if defined(NEO_SAMD21_DMA)
+  if (dmaSercom) { // SERCOM-SPI + DMA, latch is part of the transfer
+    samd21DmaShow();
+    return;
+  }
+#endif
+
   // Data latch = 300+ microsecond pause in the output stream. Rather than
   // put a delay at the end of the function, the ending time is noted and
   // the function will simply hold off (if needed) on issuing the
@@ -61,6 +61,16 @@
 #include "rp2040_pio.h"
 #endif
 
+#if defined(__SAMD21E17A__) || defined(__SAMD21G18A__) ||                    \
+    defined(__SAMD21E18A__) || defined(__SAMD21J18A__)
+// SAMD21 can alternatively drive a strip from a SERCOM in SPI mode fed by
+// DMA, see setDMA(). Each such strip needs its own SERCOM and DMA channel.
+#define NEO_SAMD21_DMA
+#ifndef NEO_DMA_CHANNELS
+#define NEO_DMA_CHANNELS 1 ///< DMA channels reserved for setDMA() strips
+#endif
+#endif
+
 // The order of primary colors in the NeoPixel data stream can vary among
 // device types, manufacturers and even different revisions of the same
 // item.  The third parameter to the Adafruit_NeoPixel constructor encodes
@@ -370,12 +380,18 @@ public:
   void rainbow(uint16_t first_hue = 0, int8_t reps = 1,
                uint8_t saturation = 255, uint8_t brightness = 255,
                bool gammify = true);
+#if defined(NEO_SAMD21_DMA)
+  bool setDMA(Sercom *sercom, uint8_t pad, EPioType mux);
+#endif
 
 private:
 #if defined(ARDUINO_ARCH_RP2040)
   void  rp2040Init(uint8_t pin, bool is800KHz);
   void  rp2040Show(uint8_t pin, uint8_t *pixels, uint32_t numBytes, bool is800KHz);
 #endif
+#if defined(NEO_SAMD21_DMA)
+  void samd21DmaShow(void);
+#endif
 
 protected:
 #ifdef NEO_KHZ400 // If 400 KHz NeoPixel support enabled...
@@ -405,6 +421,12 @@ protected:
   int sm = 0;
   bool init = true;
 #endif
+#if defined(NEO_SAMD21_DMA)
+  Sercom *dmaSercom = NULL; ///< SPI output SERCOM (NULL = bit-bang)
+  uint8_t *dmaBuf = NULL;   ///< SPI-encoded frame followed by latch
+  uint16_t dmaBytes = 0;    ///< numBytes that dmaBuf is sized for
+  uint8_t dmaChannel = 0;   ///< DMAC channel
+#endif
 };
 
 #endif // ADAFRUIT_NEOPIXEL_H
@@ -0,0 +1,23 @@
+// WS2812 bit expansion for the SAMD21 SERCOM-SPI + DMA output, see
+// samd21_spi.h. Not tied to the SAMD21, the host test in
+// CO2-Ampel/extras/test decodes its output.
+
+#include <string.h>
+#include "samd21_spi.h"
+
+uint32_t samd21SpiEncode(uint8_t *out, const uint8_t *pixels,
+                         uint32_t numBytes) {
+  const uint8_t *ptr = pixels, *end = pixels + numBytes;
+
+  for (; ptr < end; ptr++) {
+    uint32_t bits = 0;
+    for (uint8_t bitMask = 0x80; bitMask; bitMask >>= 1)
+      bits = (bits << 3) | ((*ptr & bitMask) ? 0b110 : 0b100);
+    *out++ = bits >> 16;
+    *out++ = bits >> 8;
+    *out++ = bits;
+  }
+  memset(out, 0, NEO_SPI_LATCH);
+
+  return NEO_SPI_BYTES(numBytes);
+}
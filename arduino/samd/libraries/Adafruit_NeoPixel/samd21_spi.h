@@ -0,0 +1,32 @@
+// WS2812 bit expansion for the SAMD21 SERCOM-SPI + DMA output (setDMA()).
+// Plain C without hardware access, so it can also be checked on a host.
+//
+// Every NeoPixel bit is sent as 3 SPI bits, 1 = 110 and 0 = 100, so the SPI
+// clock runs at 3x the NeoPixel bitrate. At 2.4 MHz this gives T0H 417 ns,
+// T1H 833 ns and 1.25 us per bit. The frame is followed by zero bytes that
+// hold the line low for the latch, so a finished transfer means the strip
+// is ready for the next frame.
+
+#ifndef SAMD21_SPI_H
+#define SAMD21_SPI_H
+
+#include <stdint.h>
+
+#define NEO_SPI_HZ 2400000UL // SPI clock for 800 kHz strips
+#define NEO_SPI_LATCH 96     // Zero bytes after the frame, 320 us at 2.4 MHz
+#define NEO_SPI_BYTES(n) ((uint32_t)(n) * 3 + NEO_SPI_LATCH)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Encodes numBytes pixel bytes plus the latch into out, which must hold
+// NEO_SPI_BYTES(numBytes) bytes. Returns the number of bytes to send.
+uint32_t samd21SpiEncode(uint8_t *out, const uint8_t *pixels,
+                         uint32_t numBytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMD21_SPI_H
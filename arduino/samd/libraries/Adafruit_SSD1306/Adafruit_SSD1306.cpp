@@ -495,6 +495,7 @@ bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr, bool reset,
     return false;
 
   clearDisplay();
+  markAllDirty(); // Display RAM content is unknown
 
 #ifndef SSD1306_NO_SPLASH
   if (HEIGHT > 32) {
@@ -621,6 +622,35 @@ bool Adafruit_SSD1306::begin(uint8_t vcs, uint8_t addr, bool reset,
 
 // DRAWING FUNCTIONS -------------------------------------------------------
 
+/*!
+    @brief  Extend the changed column range of a page, display() sends only
+            these ranges.
+    @param  page
+            Page (8-pixel row) of the display buffer.
+    @param  x0
+            First changed column.
+    @param  x1
+            Last changed column.
+    @return None (void).
+*/
+void Adafruit_SSD1306::markDirty(uint8_t page, uint8_t x0, uint8_t x1) {
+  if (x0 < dirtyMin[page])
+    dirtyMin[page] = x0;
+  if (x1 > dirtyMax[page])
+    dirtyMax[page] = x1;
+}
+
+/*!
+    @brief  Mark the whole display buffer as changed, so the next display()
+            call sends all of it. Needed after writing to the buffer
+            directly or whenever the display RAM may differ from the buffer.
+    @return None (void).
+*/
+void Adafruit_SSD1306::markAllDirty(void) {
+  memset(dirtyMin, 0, sizeof(dirtyMin));
+  memset(dirtyMax, WIDTH - 1, sizeof(dirtyMax));
+}
+
 /*!
     @brief  Set/clear/invert a single pixel. This is also invoked by the
             Adafruit_GFX library in generating many higher-level graphics
@@ -654,17 +684,20 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
       y = HEIGHT - y - 1;
       break;
     }
+    uint8_t *pBuf = &buffer[x + (y / 8) * WIDTH], old = *pBuf;
     switch (color) {
     case SSD1306_WHITE:
-      buffer[x + (y / 8) * WIDTH] |= (1 << (y & 7));
+      *pBuf |= (1 << (y & 7));
       break;
     case SSD1306_BLACK:
-      buffer[x + (y / 8) * WIDTH] &= ~(1 << (y & 7));
+      *pBuf &= ~(1 << (y & 7));
       break;
     case SSD1306_INVERSE:
-      buffer[x + (y / 8) * WIDTH] ^= (1 << (y & 7));
+      *pBuf ^= (1 << (y & 7));
       break;
     }
+    if (*pBuf != old)
+      markDirty(y / 8, x, x);
   }
 }
 
@@ -676,6 +709,17 @@ void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
             commands as needed by one's own application.
 */
 void Adafruit_SSD1306::clearDisplay(void) {
+  // Only columns that were set need to be sent again
+  for (uint8_t page = 0; page < ((HEIGHT + 7) / 8); page++) {
+    uint8_t *pBuf = &buffer[page * WIDTH];
+    int16_t x0 = 0, x1 = WIDTH - 1;
+    while ((x0 <= x1) && !pBuf[x0])
+      x0++;
+    while ((x1 > x0) && !pBuf[x1])
+      x1--;
+    if (x0 <= x1)
+      markDirty(page, x0, x1);
+  }
   memset(buffer, 0, WIDTH * ((HEIGHT + 7) / 8));
 }
 
@@ -757,24 +801,30 @@ void Adafruit_SSD1306::drawFastHLineInternal(int16_t x, int16_t y, int16_t w,
     }
     if (w > 0) { // Proceed only if width is positive
       uint8_t *pBuf = &buffer[(y / 8) * WIDTH + x], mask = 1 << (y & 7);
+      uint8_t changed = 0;
+      int16_t n = w;
       switch (color) {
       case SSD1306_WHITE:
-        while (w--) {
+        while (n--) {
+          changed |= ~*pBuf & mask;
           *pBuf++ |= mask;
         };
         break;
       case SSD1306_BLACK:
-        mask = ~mask;
-        while (w--) {
-          *pBuf++ &= mask;
+        while (n--) {
+          changed |= *pBuf & mask;
+          *pBuf++ &= ~mask;
         };
         break;
       case SSD1306_INVERSE:
-        while (w--) {
+        changed = 1;
+        while (n--) {
           *pBuf++ ^= mask;
         };
         break;
       }
+      if (changed)
+        markDirty(y / 8, x, x + w - 1);
     }
   }
 }
@@ -859,6 +909,7 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
       // use local byte registers for faster juggling
       uint8_t y = __y, h = __h;
       uint8_t *pBuf = &buffer[(y / 8) * WIDTH + x];
+      uint8_t page = y / 8, old;
 
       // do the first partial byte, if necessary - this requires some masking
       uint8_t mod = (y & 7);
@@ -875,6 +926,7 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
         if (h < mod)
           mask &= (0XFF >> (mod - h));
 
+        old = *pBuf;
         switch (color) {
         case SSD1306_WHITE:
           *pBuf |= mask;
@@ -886,7 +938,10 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
           *pBuf ^= mask;
           break;
         }
+        if (*pBuf != old)
+          markDirty(page, x, x);
         pBuf += WIDTH;
+        page++;
       }
 
       if (h >= mod) { // More to go?
@@ -898,6 +953,7 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
             // black/white write version with an extra comparison per loop
             do {
               *pBuf ^= 0xFF; // Invert byte
+              markDirty(page++, x, x);
               pBuf += WIDTH; // Advance pointer 8 rows
               h -= 8;        // Subtract 8 rows from height
             } while (h >= 8);
@@ -905,7 +961,11 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
             // store a local value to work with
             uint8_t val = (color != SSD1306_BLACK) ? 255 : 0;
             do {
-              *pBuf = val;   // Set byte
+              if (*pBuf != val) {
+                *pBuf = val; // Set byte
+                markDirty(page, x, x);
+              }
+              page++;
               pBuf += WIDTH; // Advance pointer 8 rows
               h -= 8;        // Subtract 8 rows from height
             } while (h >= 8);
@@ -922,6 +982,7 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
           static const uint8_t PROGMEM postmask[8] = {0x00, 0x01, 0x03, 0x07,
                                                       0x0F, 0x1F, 0x3F, 0x7F};
           uint8_t mask = pgm_read_byte(&postmask[mod]);
+          old = *pBuf;
           switch (color) {
           case SSD1306_WHITE:
             *pBuf |= mask;
@@ -933,6 +994,8 @@ void Adafruit_SSD1306::drawFastVLineInternal(int16_t x, int16_t __y,
             *pBuf ^= mask;
             break;
           }
+          if (*pBuf != old)
+            markDirty(page, x, x);
         }
       }
     } // endif positive height
@@ -976,28 +1039,76 @@ bool Adafruit_SSD1306::getPixel(int16_t x, int16_t y) {
     @brief  Get base address of display buffer for direct reading or writing.
     @return Pointer to an unsigned 8-bit array, column-major, columns padded
             to full byte boundary if needed.
+    @note   Changes made through this pointer are not tracked, the whole
+            buffer is sent on the next display() call.
 */
-uint8_t *Adafruit_SSD1306::getBuffer(void) { return buffer; }
+uint8_t *Adafruit_SSD1306::getBuffer(void) {
+  markAllDirty();
+  return buffer;
+}
 
 // REFRESH DISPLAY ---------------------------------------------------------
 
 /*!
-    @brief  Push data currently in RAM to SSD1306 display.
+    @brief  Get the next address window of changed columns and mark it as
+            sent. Following changed pages are joined into one window as
+            long as the extra (unchanged) columns cost less than a new
+            address window. Used by display(), or to send the buffer with
+            another (e.g. interrupt driven) I2C driver.
+    @param  p0  First page.
+    @param  p1  Last page.
+    @param  x0  First column.
+    @param  x1  Last column, horizontal addressing mode wraps from x1 to x0
+                of the next page.
+    @return true if a window was returned, false if nothing changed.
+*/
+bool Adafruit_SSD1306::nextWindow(uint8_t *p0, uint8_t *p1, uint8_t *x0,
+                                  uint8_t *x1) {
+  uint8_t pages = (HEIGHT + 7) / 8;
+  uint8_t p = 0;
+
+  while ((p < pages) && (dirtyMin[p] > dirtyMax[p]))
+    p++; // Page unchanged
+  if (p >= pages)
+    return false;
+
+  uint8_t a = dirtyMin[p], b = dirtyMax[p], q = p;
+  while ((q + 1 < pages) && (dirtyMin[q + 1] <= dirtyMax[q + 1])) {
+    uint8_t n0 = min(a, dirtyMin[q + 1]), n1 = max(b, dirtyMax[q + 1]);
+    uint16_t joined = (n1 - n0 + 1) * (q - p + 2);
+    uint16_t split = (b - a + 1) * (q - p + 1) +
+                     (dirtyMax[q + 1] - dirtyMin[q + 1] + 1) + 8;
+    if (joined > split)
+      break;
+    a = n0;
+    b = n1;
+    q++;
+  }
+
+  for (uint8_t i = p; i <= q; i++) {
+    dirtyMin[i] = 0xFF;
+    dirtyMax[i] = 0;
+  }
+  *p0 = p;
+  *p1 = q;
+  *x0 = a;
+  *x1 = b;
+  return true;
+}
+
+/*!
+    @brief  Push data currently in RAM to SSD1306 display. Only the columns
+            changed since the last call are sent, each run of changed pages
+            as one page/column address window (see nextWindow()).
     @return None (void).
     @note   Drawing operations are not visible until this function is
             called. Call after each graphics command, or after a whole set
             of graphics commands, as best needed by one's own application.
 */
 void Adafruit_SSD1306::display(void) {
-  TRANSACTION_START
-  static const uint8_t PROGMEM dlist1[] = {
-      SSD1306_PAGEADDR,
-      0,                      // Page start address
-      0xFF,                   // Page end (not really, but works here)
-      SSD1306_COLUMNADDR, 0}; // Column start address
-  ssd1306_commandList(dlist1, sizeof(dlist1));
-  ssd1306_command1(WIDTH - 1); // Column end address
+  uint8_t p0, p1, x0, x1;
 
+  TRANSACTION_START
 #if defined(ESP8266)
   // ESP8266 needs a periodic yield() call to avoid watchdog reset.
   // With the limited size of SSD1306 displays, and the fast bitrate
@@ -1007,27 +1118,44 @@ void Adafruit_SSD1306::display(void) {
   // 32-byte transfer condition below.
   yield();
 #endif
-  uint16_t count = WIDTH * ((HEIGHT + 7) / 8);
-  uint8_t *ptr = buffer;
-  if (wire) { // I2C
-    wire->beginTransmission(i2caddr);
-    WIRE_WRITE((uint8_t)0x40);
-    uint16_t bytesOut = 1;
-    while (count--) {
-      if (bytesOut >= WIRE_MAX) {
-        wire->endTransmission();
-        wire->beginTransmission(i2caddr);
-        WIRE_WRITE((uint8_t)0x40);
-        bytesOut = 1;
+  while (nextWindow(&p0, &p1, &x0, &x1)) {
+    uint8_t dlist[] = {SSD1306_PAGEADDR, p0, p1, SSD1306_COLUMNADDR, x0, x1};
+    if (wire) { // I2C
+      wire->beginTransmission(i2caddr);
+      WIRE_WRITE((uint8_t)0x00); // Co = 0, D/C = 0
+      for (uint8_t i = 0; i < sizeof(dlist); i++)
+        WIRE_WRITE(dlist[i]);
+      wire->endTransmission();
+      // Data in bursts of up to WIRE_MAX bytes, one page fits if the Wire
+      // buffer is large enough (SAMD: 255 bytes)
+      wire->beginTransmission(i2caddr);
+      WIRE_WRITE((uint8_t)0x40);
+      uint16_t bytesOut = 1;
+      for (uint8_t p = p0; p <= p1; p++) {
+        uint8_t *ptr = &buffer[p * WIDTH + x0];
+        for (uint8_t x = x0; x <= x1; x++) {
+          if (bytesOut >= WIRE_MAX) {
+            wire->endTransmission();
+            wire->beginTransmission(i2caddr);
+            WIRE_WRITE((uint8_t)0x40);
+            bytesOut = 1;
+          }
+          WIRE_WRITE(*ptr++);
+          bytesOut++;
+        }
+      }
+      wire->endTransmission();
+    } else { // SPI
+      SSD1306_MODE_COMMAND
+      for (uint8_t i = 0; i < sizeof(dlist); i++)
+        SPIwrite(dlist[i]);
+      SSD1306_MODE_DATA
+      for (uint8_t p = p0; p <= p1; p++) {
+        uint8_t *ptr = &buffer[p * WIDTH + x0];
+        for (uint8_t x = x0; x <= x1; x++)
+          SPIwrite(*ptr++);
       }
-      WIRE_WRITE(*ptr++);
-      bytesOut++;
     }
-    wire->endTransmission();
-  } else { // SPI
-    SSD1306_MODE_DATA
-    while (count--)
-      SPIwrite(*ptr++);
   }
   TRANSACTION_END
 #if defined(ESP8266)
@@ -1143,6 +1271,7 @@ void Adafruit_SSD1306::stopscroll(void) {
   TRANSACTION_START
   ssd1306_command1(SSD1306_DEACTIVATE_SCROLL);
   TRANSACTION_END
+  markAllDirty(); // Scrolling has moved the display RAM content
 }
 
 // OTHER HARDWARE SETTINGS -------------------------------------------------
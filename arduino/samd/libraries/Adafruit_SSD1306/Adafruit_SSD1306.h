@@ -145,6 +145,7 @@ public:
   bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t i2caddr = 0,
              bool reset = true, bool periphBegin = true);
   void display(void);
+  bool nextWindow(uint8_t *p0, uint8_t *p1, uint8_t *x0, uint8_t *x1);
   void clearDisplay(void);
   void invertDisplay(bool i);
   void dim(bool dim);
@@ -159,6 +160,7 @@ public:
   void ssd1306_command(uint8_t c);
   bool getPixel(int16_t x, int16_t y);
   uint8_t *getBuffer(void);
+  void markAllDirty(void);
 
 protected:
   inline void SPIwrite(uint8_t d) __attribute__((always_inline));
@@ -166,6 +168,8 @@ protected:
   void drawFastVLineInternal(int16_t x, int16_t y, int16_t h, uint16_t color);
   void ssd1306_command1(uint8_t c);
   void ssd1306_commandList(const uint8_t *c, uint8_t n);
+  inline void markDirty(uint8_t page, uint8_t x0, uint8_t x1)
+      __attribute__((always_inline));
 
   SPIClass *spi;   ///< Initialized during construction when using SPI. See
                    ///< SPI.cpp, SPI.h
@@ -193,6 +197,8 @@ protected:
   uint32_t restoreClk; ///< Wire speed following SSD1306 transfers
 #endif
   uint8_t contrast; ///< normal contrast setting for this device
+  uint8_t dirtyMin[8]; ///< First changed column per page since display()
+  uint8_t dirtyMax[8]; ///< Last changed column per page, min > max = clean
 #if defined(SPI_HAS_TRANSACTION)
 protected:
   // Allow sub-class to change
@@ -30,9 +30,57 @@
 
 #include "BearSSLTrustAnchors.h"
 #include "utility/eccX08_asn1.h"
+#include "utility/eccX08_ec.h"
 
 #include "BearSSLClient.h"
 
+#if BEAR_SSL_CLIENT_LOW_MEMORY
+// cipher suites of the low-memory profile, most preferred first
+static constexpr uint16_t lowMemorySuites[] = {
+  BR_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+  BR_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+  BR_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+  BR_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256
+};
+
+// SHA-256 for the PRF and signatures, SHA-384 for certificates only
+static constexpr const br_hash_class* lowMemoryHashes[] = {
+  &br_sha256_vtable,
+  &br_sha384_vtable
+};
+
+// br_ssl_client_init_full() without the unused suites, hashes and ciphers
+static void lowMemoryInit(br_ssl_client_context* cc, br_x509_minimal_context* xc,
+  const br_x509_trust_anchor* trustAnchors, size_t trustAnchorsNum)
+{
+  br_ssl_client_zero(cc);
+  br_ssl_engine_set_versions(&cc->eng, BR_TLS12, BR_TLS12);
+
+  br_x509_minimal_init(xc, &br_sha256_vtable, trustAnchors, trustAnchorsNum);
+
+  br_ssl_engine_set_suites(&cc->eng, lowMemorySuites, sizeof(lowMemorySuites) / sizeof(lowMemorySuites[0]));
+  br_ssl_engine_set_default_rsavrfy(&cc->eng);
+  br_ssl_engine_set_default_ecdsa(&cc->eng);
+  br_x509_minimal_set_rsa(xc, br_ssl_engine_get_rsavrfy(&cc->eng));
+  br_x509_minimal_set_ecdsa(xc, br_ssl_engine_get_ec(&cc->eng), br_ssl_engine_get_ecdsa(&cc->eng));
+
+  for (size_t i = 0; i < sizeof(lowMemoryHashes) / sizeof(lowMemoryHashes[0]); i++) {
+    const br_hash_class* hc = lowMemoryHashes[i];
+    int id = (hc->desc >> BR_HASHDESC_ID_OFF) & BR_HASHDESC_ID_MASK;
+
+    br_ssl_engine_set_hash(&cc->eng, id, hc);
+    br_x509_minimal_set_hash(xc, id, hc);
+  }
+
+  br_ssl_engine_set_x509(&cc->eng, &xc->vtable);
+
+  br_ssl_engine_set_prf_sha256(&cc->eng, &br_tls12_sha256_prf);
+
+  br_ssl_engine_set_default_aes_gcm(&cc->eng);
+  br_ssl_engine_set_default_chapol(&cc->eng);
+}
+#endif
+
 BearSSLClient::BearSSLClient(Client& client) :
   BearSSLClient(&client, TAs, TAs_NUM)
 {
@@ -48,6 +96,10 @@ BearSSLClient::BearSSLClient(Client* client, const br_x509_trust_anchor* myTAs,
   _TAs(myTAs),
   _numTAs(myNumTAs),
   _noSNI(false),
+  _sessionCache(NULL),
+  _sessionKey(0),
+  _sessionResumed(false),
+  _ec(br_ec_get_default()),
   _skeyDecoder(NULL),
   _ecChainLen(0)
 {
@@ -89,6 +141,8 @@ int BearSSLClient::connect(IPAddress ip, uint16_t port)
     return 0;
   }
 
+  _sessionKey = BearSSLSessionCache::key(ip, port);
+
   return connectSSL(NULL);
 }
 
@@ -98,6 +152,8 @@ int BearSSLClient::connect(const char* host, uint16_t port)
     return 0;
   }
 
+  _sessionKey = BearSSLSessionCache::key(host, port);
+
   return connectSSL(_noSNI ? NULL : host);
 }
 
@@ -212,6 +268,22 @@ void BearSSLClient::setInsecure(SNI insecure)
   }
 }
 
+void BearSSLClient::setCryptoProvider(CryptoProvider provider)
+{
+  _ecVrfy = br_ecdsa_vrfy_asn1_get_default();
+  _ecSign = br_ecdsa_sign_asn1_get_default();
+  _ec = br_ec_get_default();
+
+#ifndef ARDUINO_DISABLE_ECCX08
+  if (provider == CryptoProvider::ECCX08) {
+    _ecSign = eccX08_sign_asn1;
+    _ec = &eccX08_ec;
+  }
+#else
+  (void)provider;
+#endif
+}
+
 void BearSSLClient::setEccVrfy(br_ecdsa_vrfy vrfy)
 {
   _ecVrfy = vrfy;
@@ -429,6 +501,16 @@ void BearSSLClient::setEccCertParent(const char cert[])
   }
 }
 
+void BearSSLClient::setSessionCache(BearSSLSessionCache* cache)
+{
+  _sessionCache = cache;
+}
+
+bool BearSSLClient::sessionResumed()
+{
+  return _sessionResumed;
+}
+
 int BearSSLClient::errorCode()
 {
   return br_ssl_engine_last_error(&_sc.eng);
@@ -436,10 +518,18 @@ int BearSSLClient::errorCode()
 
 int BearSSLClient::connectSSL(const char* host)
 {
+#if BEAR_SSL_CLIENT_LOW_MEMORY
+  // initialize client context with the low-memory profile, the buffer size
+  // sets the announced max. fragment length
+  lowMemoryInit(&_sc, &_xc, _TAs, _numTAs);
+
+  br_ssl_engine_set_buffer(&_sc.eng, _iobuf, sizeof(_iobuf), 0);
+#else
   // initialize client context with all algorithms and hardcoded trust anchors
   br_ssl_client_init_full(&_sc, &_xc, _TAs, _numTAs);
 
   br_ssl_engine_set_buffers_bidi(&_sc.eng, _ibuf, sizeof(_ibuf), _obuf, sizeof(_obuf));
+#endif
 
   // inject entropy in engine
   unsigned char entropy[32];
@@ -456,9 +546,10 @@ int BearSSLClient::connectSSL(const char* host)
 #endif
   br_ssl_engine_inject_entropy(&_sc.eng, entropy, sizeof(entropy));
 
-  // add custom ECDSA vfry and EC sign
+  // add custom ECDSA vfry, EC sign and EC implementation (ECDHE)
+  br_ssl_engine_set_ec(&_sc.eng, _ec);
   br_ssl_engine_set_ecdsa(&_sc.eng, _ecVrfy);
-  br_x509_minimal_set_ecdsa(&_xc, br_ssl_engine_get_ec(&_sc.eng), br_ssl_engine_get_ecdsa(&_sc.eng));
+  br_x509_minimal_set_ecdsa(&_xc, br_ec_get_default(), br_ssl_engine_get_ecdsa(&_sc.eng));
 
   // enable client auth
   if (_ecCert[0].data_len) {
@@ -475,8 +566,19 @@ int BearSSLClient::connectSSL(const char* host)
     }
   }
 
+  // offer a cached session, the server decides whether to resume it
+  const br_ssl_session_parameters* session = NULL;
+
+  if (_sessionCache) {
+    session = _sessionCache->get(_sessionKey);
+  }
+  if (session) {
+    br_ssl_engine_set_session_parameters(&_sc.eng, session);
+  }
+  _sessionResumed = false;
+
   // set the hostname used for SNI
-  br_ssl_client_reset(&_sc, host, 0);
+  br_ssl_client_reset(&_sc, host, session != NULL);
 
   // get the current time and set it for X.509 validation
   uint32_t now = ArduinoBearSSL.getTime();
@@ -496,10 +598,26 @@ int BearSSLClient::connectSSL(const char* host)
     if (state & BR_SSL_SENDAPP) {
       break;
     } else if (state & BR_SSL_CLOSED) {
+      if (session) {
+        // don't offer it again, e.g. after a server restart
+        _sessionCache->remove(_sessionKey);
+      }
       return 0;
     }
   }
 
+  if (_sessionCache) {
+    br_ssl_session_parameters params;
+
+    br_ssl_engine_get_session_parameters(&_sc.eng, &params);
+
+    // a resumed session keeps the offered session ID
+    _sessionResumed = session && (params.session_id_len == session->session_id_len) &&
+                      (memcmp(params.session_id, session->session_id, params.session_id_len) == 0);
+
+    _sessionCache->put(_sessionKey, &params);
+  }
+
   return 1;
 }
 
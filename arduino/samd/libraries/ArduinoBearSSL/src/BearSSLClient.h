@@ -25,6 +25,16 @@
 #ifndef _BEAR_SSL_CLIENT_H_
 #define _BEAR_SSL_CLIENT_H_
 
+// Low-memory profile: one shared, half-duplex record buffer for this
+// fragment length (512, 1024, 2048 or 4096 bytes), which is announced with
+// the max_fragment_length extension, and TLS 1.2 with ECDHE and AES-GCM or
+// ChaCha20+Poly1305 only. The server must honour the extension and the
+// protocol must not send while data from the server is still unread
+// (request/response). 0 = separate input and output buffers.
+#ifndef BEAR_SSL_CLIENT_LOW_MEMORY
+#define BEAR_SSL_CLIENT_LOW_MEMORY 0
+#endif
+
 #ifndef BEAR_SSL_CLIENT_OBUF_SIZE
 #define BEAR_SSL_CLIENT_OBUF_SIZE 512 + 85
 #endif
@@ -41,6 +51,7 @@
 #include <Client.h>
 
 #include "bearssl/bearssl.h"
+#include "BearSSLSessionCache.h"
 
 class BearSSLClient : public Client {
 
@@ -75,6 +86,15 @@ public:
 
   void setInsecure(SNI insecure) __attribute__((deprecated("INSECURE. DO NOT USE IN PRODUCTION")));
 
+  enum class CryptoProvider {
+    Software, // BearSSL only
+    ECCX08    // client certificate signatures and P-256 ECDHE on the ECCX08
+  };
+
+  // select the ECDSA sign/verify and EC implementations, signature
+  // verification stays in BearSSL, call after setEccSlot()
+  void setCryptoProvider(CryptoProvider provider);
+
   void setEccVrfy(br_ecdsa_vrfy vrfy);
   void setEccSign(br_ecdsa_sign sign);
 
@@ -86,6 +106,10 @@ public:
   void setKey(const char key[], const char cert[]);
   void setEccCertParent(const char cert[]);
 
+  // offer cached sessions on connect and store the negotiated ones
+  void setSessionCache(BearSSLSessionCache* cache);
+  bool sessionResumed();
+
   int errorCode();
 
 private:
@@ -103,8 +127,13 @@ private:
 
   bool _noSNI;
 
+  BearSSLSessionCache* _sessionCache;
+  uint32_t _sessionKey;
+  bool _sessionResumed;
+
   br_ecdsa_vrfy _ecVrfy;
   br_ecdsa_sign _ecSign;
+  const br_ec_impl* _ec;
 
   br_ec_private_key _ecKey;
   br_skey_decoder_context* _skeyDecoder;
@@ -114,8 +143,12 @@ private:
 
   br_ssl_client_context _sc;
   br_x509_minimal_context _xc;
+#if BEAR_SSL_CLIENT_LOW_MEMORY
+  unsigned char _iobuf[BEAR_SSL_CLIENT_LOW_MEMORY + 325];
+#else
   unsigned char _ibuf[BEAR_SSL_CLIENT_IBUF_SIZE];
   unsigned char _obuf[BEAR_SSL_CLIENT_OBUF_SIZE];
+#endif
   br_sslio_context _ioc;
 };
 
@@ -0,0 +1,143 @@
+/*
+ * TLS client session cache for BearSSLClient
+ */
+
+#include "BearSSLSessionCache.h"
+
+#define SESSION_CACHE_MAGIC 0x42535331 // "BSS1"
+
+BearSSLSessionCache::BearSSLSessionCache()
+{
+  clear();
+}
+
+uint32_t BearSSLSessionCache::key(const char* host, uint16_t port)
+{
+  // FNV-1a, a collision only costs a full handshake
+  uint32_t hash = 2166136261UL;
+
+  while (*host) {
+    hash = (hash ^ (uint8_t)tolower(*host++)) * 16777619UL;
+  }
+  hash = (hash ^ (port & 0xff)) * 16777619UL;
+  hash = (hash ^ (port >> 8)) * 16777619UL;
+
+  return hash ? hash : 1;
+}
+
+uint32_t BearSSLSessionCache::key(IPAddress ip, uint16_t port)
+{
+  char host[16];
+
+  sprintf(host, "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+
+  return key(host, port);
+}
+
+BearSSLSessionCache::Entry* BearSSLSessionCache::find(uint32_t key)
+{
+  for (size_t i = 0; i < BEAR_SSL_SESSION_CACHE_SIZE; i++) {
+    if (_entries[i].key == key) {
+      return &_entries[i];
+    }
+  }
+
+  return NULL;
+}
+
+const br_ssl_session_parameters* BearSSLSessionCache::get(uint32_t key)
+{
+  Entry* e = find(key);
+
+  if (e == NULL) {
+    return NULL;
+  }
+  e->lastUse = ++_useCounter;
+
+  return &e->params;
+}
+
+void BearSSLSessionCache::put(uint32_t key, const br_ssl_session_parameters* params)
+{
+  Entry* e = find(key);
+
+  // the server did not assign a session ID, nothing to resume
+  if (params->session_id_len == 0) {
+    remove(key);
+    return;
+  }
+
+  // replace the least recently used entry
+  if (e == NULL) {
+    e = &_entries[0];
+    for (size_t i = 1; i < BEAR_SSL_SESSION_CACHE_SIZE; i++) {
+      if (_entries[i].lastUse < e->lastUse) {
+        e = &_entries[i];
+      }
+    }
+  }
+
+  e->key = key;
+  e->lastUse = ++_useCounter;
+  memcpy(&e->params, params, sizeof(e->params));
+}
+
+void BearSSLSessionCache::remove(uint32_t key)
+{
+  Entry* e = find(key);
+
+  if (e) {
+    memset(e, 0, sizeof(*e));
+  }
+}
+
+void BearSSLSessionCache::clear()
+{
+  memset(_entries, 0, sizeof(_entries));
+  _useCounter = 0;
+}
+
+size_t BearSSLSessionCache::storageSize() const
+{
+  return sizeof(uint32_t) + sizeof(_entries);
+}
+
+size_t BearSSLSessionCache::save(void* buf, size_t size) const
+{
+  uint32_t magic = SESSION_CACHE_MAGIC;
+
+  if (size < storageSize()) {
+    return 0;
+  }
+
+  memcpy(buf, &magic, sizeof(magic));
+  memcpy((uint8_t*)buf + sizeof(magic), _entries, sizeof(_entries));
+
+  return storageSize();
+}
+
+bool BearSSLSessionCache::restore(const void* buf, size_t size)
+{
+  uint32_t magic;
+
+  if (size != storageSize()) {
+    return false;
+  }
+
+  memcpy(&magic, buf, sizeof(magic));
+  if (magic != SESSION_CACHE_MAGIC) {
+    return false;
+  }
+
+  memcpy(_entries, (const uint8_t*)buf + sizeof(magic), sizeof(_entries));
+
+  // continue counting after the newest restored entry
+  _useCounter = 0;
+  for (size_t i = 0; i < BEAR_SSL_SESSION_CACHE_SIZE; i++) {
+    if (_entries[i].lastUse > _useCounter) {
+      _useCounter = _entries[i].lastUse;
+    }
+  }
+
+  return true;
+}
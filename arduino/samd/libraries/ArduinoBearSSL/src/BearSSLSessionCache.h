@@ -0,0 +1,55 @@
+/*
+ * TLS client session cache for BearSSLClient
+ *
+ * Keeps the parameters of the last sessions (session ID, cipher suite and
+ * master secret) per server, so that a reconnect can resume the session
+ * with an abbreviated handshake instead of a full ECDHE key exchange.
+ * BearSSL clients support session ID resumption only (no tickets).
+ */
+
+#ifndef _BEAR_SSL_SESSION_CACHE_H_
+#define _BEAR_SSL_SESSION_CACHE_H_
+
+#ifndef BEAR_SSL_SESSION_CACHE_SIZE
+#define BEAR_SSL_SESSION_CACHE_SIZE 2
+#endif
+
+#include <Arduino.h>
+
+#include "bearssl/bearssl_ssl.h"
+
+class BearSSLSessionCache {
+
+public:
+  BearSSLSessionCache();
+
+  // lookup key of a server: host name or IP address plus port
+  static uint32_t key(const char* host, uint16_t port);
+  static uint32_t key(IPAddress ip, uint16_t port);
+
+  const br_ssl_session_parameters* get(uint32_t key);
+  void put(uint32_t key, const br_ssl_session_parameters* params);
+  void remove(uint32_t key);
+  void clear();
+
+  // raw copy for persistent storage, e.g. flash
+  // NOTE: contains the master secrets of the cached sessions
+  size_t storageSize() const;
+  size_t save(void* buf, size_t size) const;
+  bool restore(const void* buf, size_t size);
+
+private:
+  struct Entry {
+    uint32_t key;     // 0 = unused
+    uint32_t lastUse;
+    br_ssl_session_parameters params;
+  };
+
+  Entry* find(uint32_t key);
+
+private:
+  Entry _entries[BEAR_SSL_SESSION_CACHE_SIZE];
+  uint32_t _useCounter;
+};
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2016 Thomas Pornin <pornin@bolet.org>
+ * Copyright (c) 2018 Arduino SA. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining 
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND 
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ArduinoBearSSL.h"
+
+#ifndef ARDUINO_DISABLE_ECCX08
+#include "eccX08_ec.h"
+
+#include <ArduinoECCX08.h>
+
+#ifndef BEAR_SSL_ECCX08_ECDH_SLOT
+#define BEAR_SSL_ECCX08_ECDH_SLOT ECCX08_TEMPKEY // volatile, no EEPROM wear (ATECC608)
+#endif
+
+/*
+ * The client calls mul() with a fresh random scalar for the shared secret,
+ * then mulgen() with the same scalar for its public key. The scalar only
+ * pairs the two calls, the private key never leaves the chip.
+ */
+static unsigned char ecdh_scalar[32];
+static size_t ecdh_scalar_len = 0;
+static unsigned char ecdh_pub[64];
+
+static const unsigned char *
+api_generator(int curve, size_t *len)
+{
+  return br_ec_get_default()->generator(curve, len);
+}
+
+static const unsigned char *
+api_order(int curve, size_t *len)
+{
+  return br_ec_get_default()->order(curve, len);
+}
+
+static size_t
+api_xoff(int curve, size_t *len)
+{
+  return br_ec_get_default()->xoff(curve, len);
+}
+
+static uint32_t
+api_mul(unsigned char *G, size_t Glen,
+  const unsigned char *kb, size_t kblen, int curve)
+{
+  unsigned char secret[32];
+
+  ecdh_scalar_len = 0;
+
+  if (curve == BR_EC_secp256r1 && Glen == 65 && G[0] == 0x04 && kblen <= sizeof(ecdh_scalar)) {
+    if (ECCX08.generatePrivateKey(BEAR_SSL_ECCX08_ECDH_SLOT, ecdh_pub) &&
+        ECCX08.ecdh(BEAR_SSL_ECCX08_ECDH_SLOT, &G[1], secret)) {
+      // the chip checks the peer point, the engine only reads X
+      memcpy(&G[1], secret, sizeof(secret));
+      memset(secret, 0, sizeof(secret));
+
+      memcpy(ecdh_scalar, kb, kblen);
+      ecdh_scalar_len = kblen;
+
+      return 1;
+    }
+  }
+
+  return br_ec_get_default()->mul(G, Glen, kb, kblen, curve);
+}
+
+static size_t
+api_mulgen(unsigned char *R,
+  const unsigned char *x, size_t xlen, int curve)
+{
+  if (ecdh_scalar_len != 0 && curve == BR_EC_secp256r1 &&
+      xlen == ecdh_scalar_len && memcmp(x, ecdh_scalar, xlen) == 0) {
+    memset(ecdh_scalar, 0, sizeof(ecdh_scalar));
+    ecdh_scalar_len = 0;
+
+    R[0] = 0x04;
+    memcpy(&R[1], ecdh_pub, sizeof(ecdh_pub));
+    return 65;
+  }
+
+  return br_ec_get_default()->mulgen(R, x, xlen, curve);
+}
+
+static uint32_t
+api_muladd(unsigned char *A, const unsigned char *B, size_t len,
+  const unsigned char *x, size_t xlen,
+  const unsigned char *y, size_t ylen, int curve)
+{
+  return br_ec_get_default()->muladd(A, B, len, x, xlen, y, ylen, curve);
+}
+
+const br_ec_impl eccX08_ec = {
+  (uint32_t)1 << BR_EC_secp256r1, // the server must not pick X25519 for ECDHE
+  &api_generator,
+  &api_order,
+  &api_xoff,
+  &api_mul,
+  &api_mulgen,
+  &api_muladd
+};
+#endif
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2016 Thomas Pornin <pornin@bolet.org>
+ * Copyright (c) 2018 Arduino SA. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining 
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND 
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ECCX08_EC_H_
+#define _ECCX08_EC_H_
+
+#include "bearssl/bearssl.h"
+
+/*
+ * EC implementation for the SSL engine: ECDHE runs on the ECCX08 with a
+ * key generated in the chip, ECDSA verification and the fallback on chip
+ * errors go to br_ec_get_default().
+ *
+ * Only P-256 is announced, so the server key (if ECDSA) must be on P-256
+ * too. Certificate chains are verified with br_ec_get_default().
+ *
+ * Only meant for br_ssl_engine_set_ec(), mul() returns just the X
+ * coordinate of the shared point, which is all the engine uses. One
+ * handshake at a time.
+ */
+extern const br_ec_impl eccX08_ec;
+
+#endif
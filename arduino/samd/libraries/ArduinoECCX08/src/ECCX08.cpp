@@ -22,7 +22,9 @@
 #include "ECCX08.h"
 
 const uint32_t ECCX08Class::_wakeupFrequency = 100000u;  // 100 kHz
-#ifdef __AVR__
+#if defined(CRYPTO_WIRE_CLOCK)
+const uint32_t ECCX08Class::_normalFrequency = CRYPTO_WIRE_CLOCK; // shared bus
+#elif defined(__AVR__)
 const uint32_t ECCX08Class::_normalFrequency = 400000u;  // 400 kHz
 #else
 const uint32_t ECCX08Class::_normalFrequency = 1000000u; // 1 MHz
@@ -249,6 +251,36 @@ int ECCX08Class::ecSign(int slot, const byte message[], byte signature[])
   return 1;
 }
 
+int ECCX08Class::ecdh(int slot, const byte publicKey[], byte sharedSecret[])
+{
+  if (!wakeup()) {
+    return 0;
+  }
+
+  // shared secret in the clear, source key in a slot (mode 0x00, ReadKey bit 3
+  // of the slot must be 0) or in TempKey (mode 0x0D, ATECC608 only)
+  if (slot == ECCX08_TEMPKEY) {
+    if (!sendCommand(0x43, 0x0D, 0x0000, publicKey, 64)) {
+      return 0;
+    }
+  } else {
+    if (!sendCommand(0x43, 0x00, slot, publicKey, 64)) {
+      return 0;
+    }
+  }
+
+  delay(58);
+
+  if (!receiveResponse(sharedSecret, 32)) {
+    return 0;
+  }
+
+  delay(1);
+  idle();
+
+  return 1;
+}
+
 int ECCX08Class::beginSHA256()
 {
   uint8_t status;
@@ -442,6 +474,8 @@ int ECCX08Class::lock()
 
 int ECCX08Class::wakeup()
 {
+  I2CBusLock lock(_wire);
+
   _wire->setClock(_wakeupFrequency);
   _wire->beginTransmission(0x00);
   _wire->endTransmission();
@@ -461,6 +495,8 @@ int ECCX08Class::wakeup()
 
 int ECCX08Class::sleep()
 {
+  I2CBusLock lock(_wire);
+
   _wire->beginTransmission(_address);
   _wire->write(0x01);
 
@@ -475,6 +511,8 @@ int ECCX08Class::sleep()
 
 int ECCX08Class::idle()
 {
+  I2CBusLock lock(_wire);
+
   _wire->beginTransmission(_address);
   _wire->write(0x02);
 
@@ -712,6 +750,7 @@ int ECCX08Class::sendCommand(uint8_t opcode, uint8_t param1, uint16_t param2, co
   uint16_t crc = crc16(&command[1], 8 - 3 + dataLength);
   memcpy(&command[6 + dataLength], &crc, sizeof(crc));
 
+  I2CBusLock lock(_wire);
   _wire->beginTransmission(_address);
   _wire->write(command, commandLength);
   if (_wire->endTransmission() != 0) {
@@ -727,6 +766,7 @@ int ECCX08Class::receiveResponse(void* response, size_t length)
   size_t responseSize = length + 3; // 1 for length header, 2 for CRC
   byte responseBuffer[responseSize];
 
+  I2CBusLock lock(_wire);
   while (_wire->requestFrom((uint8_t)_address, (size_t)responseSize, (bool)true) != responseSize && retries--);
 
   responseBuffer[0] = _wire->read();
@@ -23,6 +23,9 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+// key ID of the volatile TempKey register (ATECC608), e.g. for ephemeral ECDH keys
+#define ECCX08_TEMPKEY 0xFFFF
+
 class ECCX08Class
 {
 public:
@@ -45,6 +48,7 @@ public:
 
   int ecdsaVerify(const byte message[], const byte signature[], const byte pubkey[]);
   int ecSign(int slot, const byte message[], byte signature[]);
+  int ecdh(int slot, const byte publicKey[], byte sharedSecret[]);
 
   int beginSHA256();
   int updateSHA256(const byte data[]); // 64 bytes
@@ -69,6 +69,7 @@ MqttClient::MqttClient(Client* client) :
   _cleanSession(true),
   _keepAliveInterval(60 * 1000L),
   _connectionTimeout(30 * 1000L),
+  _connectStart(0),
   _connectError(MQTT_SUCCESS),
   _connected(false),
   _subscribeQos(0x00),
@@ -807,12 +808,13 @@ int MqttClient::subscribeQoS() const
 
 int MqttClient::connect(IPAddress ip, const char* host, uint16_t port)
 {
+  int result;
+
   if (clientConnected()) {
     _client->stop();
   }
   _rxState = MQTT_CLIENT_RX_STATE_READ_TYPE;
   _connected = false;
-  _txPacketId = 0x0000;
 
   if (host) {
     if (!_client->connect(host, port)) {
@@ -826,6 +828,21 @@ int MqttClient::connect(IPAddress ip, const char* host, uint16_t port)
     }
   }
 
+  if (!beginConnect()) {
+    return 0;
+  }
+
+  while ((result = connectResult()) == 0);
+
+  return (result > 0);
+}
+
+int MqttClient::beginConnect()
+{
+  _rxState = MQTT_CLIENT_RX_STATE_READ_TYPE;
+  _connected = false;
+  _txPacketId = 0x0000;
+
   _lastRx = millis();
 
   String id = _id;
@@ -906,12 +923,18 @@ int MqttClient::connect(IPAddress ip, const char* host, uint16_t port)
   }
 
   _returnCode = MQTT_CONNECTION_TIMEOUT;
+  _connectStart = millis();
 
-  for (unsigned long start = millis(); ((millis() - start) < _connectionTimeout) && clientConnected();) {
+  return 1;
+}
+
+int MqttClient::connectResult()
+{
+  if (((millis() - _connectStart) < _connectionTimeout) && clientConnected()) {
     poll();
 
-    if (_returnCode != MQTT_CONNECTION_TIMEOUT) {
-      break;
+    if (_returnCode == MQTT_CONNECTION_TIMEOUT) {
+      return 0;
     }
   }
 
@@ -925,7 +948,7 @@ int MqttClient::connect(IPAddress ip, const char* host, uint16_t port)
 
   _client->stop();
 
-  return 0;
+  return -1;
 }
 
 int MqttClient::publishHeader(size_t length)
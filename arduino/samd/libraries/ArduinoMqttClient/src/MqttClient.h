@@ -86,6 +86,12 @@ public:
   virtual uint8_t connected();
   virtual operator bool();
 
+  // split-phase connect() over a client the caller has already connected:
+  // beginConnect() sends CONNECT, connectResult() polls for CONNACK
+  // (1 = connected, 0 = waiting, -1 = refused or connection timeout, see connectError())
+  int beginConnect();
+  int connectResult();
+
   void setId(const char* id);
   void setId(const String& id);
 
@@ -142,6 +148,7 @@ private:
 
   unsigned long _keepAliveInterval;
   unsigned long _connectionTimeout;
+  unsigned long _connectStart;
 
   int _connectError;
   bool _connected;
@@ -10,6 +10,8 @@
     R=1      - Remote/Fernsteuerung an
     R=R      - Reset
     V?       - Firmwareversion abfragen
+    P?       - Laufzeitmessung abfragen und zuruecksetzen
+    X?       - Ablaufverfolgung (Trace) ausgeben, Chrome Trace Event Format
     S=1      - Save/Speichern
     L=RRGGBB - LED-Farbe (000000-FFFFFF)
     H=X      - LED-Helligkeit (0-FF)
@@ -25,6 +27,13 @@
     3=X      - Range/Bereich 3 Start (400-10000) - rot
     4=X      - Range/Bereich 4 Start (400-10000) - rot blinken
     5=X      - Range/Bereich 5 Start (400-10000) - rot + Buzzer
+    Y=X,X,X,X,X - Hysterese der Bereiche 1-5 in ppm (0-500)
+    Y?       - Hysterese abfragen
+    W=X      - Trendwarnung: gelb blinken, wenn rot beim aktuellen Anstieg in X min erreicht wird (0=aus, 1-60)
+    W?       - Trendwarnung und Anstieg in ppm/min abfragen
+
+  HTTP
+    /ampel?h1=X&..&h5=X&w=X - Hysterese und Trendwarnung setzen (wird gespeichert) und als JSON abfragen
 */
 
 #define VERSION "26"
@@ -62,6 +71,7 @@
 #define HELLIGKEIT         180 //1-255 (255=100%, 179=70%)
 #define HELLIGKEIT_DUNKEL  20  //1-255 (255=100%, 25=10%)
 #define NUM_LEDS           4   //Anzahl der LEDs
+#define LEDS_DMA           1   //1 = LEDs ueber SERCOM3-SPI mit DMA ansteuern (Interrupts bleiben an), 0 = Bit-Banging
 
 //--- Lichtsensor ---
 #define LICHT_DUNKEL       20   //<20 -> dunkel
@@ -69,7 +79,7 @@
 
 //--- Allgemein ---
 #define INTERVALL          2 //2-1800s Messintervall (nur SCD30, SCD4X immer 5s)
-#define AMPEL_DURCHSCHNITT 1 //1 = CO2 Durchschnitt fuer Ampel verwenden
+#define AMPEL_DURCHSCHNITT 1 //1 = gefilterten CO2-Wert (co2_average) fuer Ampel verwenden
 #define AUTO_KALIBRIERUNG  0 //1 = automatische Kalibrierung (ASC) an (erfordert 7 Tage Dauerbetrieb mit 1h Frischluft pro Tag)
 #define BUZZER             1 //Buzzer aktivieren
 #define BUZZER_DELAY     300 //300s, Buzzer Startverzögerung
@@ -79,6 +89,88 @@
 #define DRUCK_DIFF         5 //Druckunterschied in hPa (5-20)
 #define BAUDRATE           9600 //9600 Baud
 #define STARTWERT          500 //500ppm, CO2-Startwert
+#define LOOP_BUDGET        5 //5ms, max. Dauer eines loop()-Durchlaufs (Laufzeitmessung)
+#define SENSOR_TIMEOUT     3 //3 Messintervalle ohne neue CO2-Werte = Sensorfehler (/metrics)
+#define SENSOR_POLL     1000 //ms, SCD30/SCD4X auf neue Messwerte pruefen
+
+//--- CO2-Filter (co2_average, nur bei neuen Messwerten) ---
+#define FILTER_MEDIAN      3    //Median ueber 3 Messwerte gegen Ausreisser (1 = aus, 1-9)
+#define FILTER_MITTEL      1    //gleitender Mittelwert ueber N Werte (1 = aus, 1-16)
+#define FILTER_TAU         5    //5s, Zeitkonstante des EMA (0 = aus), gewichtet mit dem Abstand der Messwerte
+
+//--- Ampel: Hysterese und Trendwarnung (Standardwerte, per Seriell/HTTP einstellbar) ---
+#define AMPEL_HYSTERESE    25   //25ppm, Rueckschaltung in die niedrigere Stufe erst unterhalb Schwelle-Hysterese (je Bereich)
+#define TREND_WARNUNG      0    //0 = aus, 1-60min: gelb blinken, wenn rot beim aktuellen Anstieg innerhalb dieser Zeit erreicht wird
+#define TREND_TAU          120  //120s, Zeitkonstante fuer die Glaettung des Anstiegs (ppm/min)
+
+//--- Batteriebetrieb (Standby zwischen den Messungen) ---
+#define LOW_POWER          0    //1 = Standby-Betrieb, nur mit SCD41 (Einzelmessung) und ohne USB-Verbindung beim Start, WiFi bleibt aus
+#define LOW_POWER_INTERVALL 60  //60s, Messintervall (min. 10s), millis() wird um die Standby-Zeit nachgefuehrt
+#define LOW_POWER_ANZEIGE  2    //2s, Ampel und Display nach jeder Messung anzeigen, 0 = LEDs und Display bleiben aus
+#define LOW_POWER_SCD4X    0    //1 = SCD4X zwischen den Messungen abschalten (lohnt erst ab ca. 6min Intervall, eine zusaetzliche Messung nach dem Aufwachen, siehe extras/test/test_energy.cpp)
+
+//--- Aenderungserkennung (Display, Serielle Ausgabe, MQTT) ---
+#define TOTBAND_CO2        10   //10ppm, kleinere Aenderungen werden nicht ausgegeben
+#define TOTBAND_TEMP       0.2  //0.2 Grad C
+#define TOTBAND_HUMI       1.0  //1%
+#define TOTBAND_PRES       0.5  //0.5hPa
+#define TOTBAND_LIGHT      20   //Lichtsensor
+#define AUSGABE_MAX        300  //300s, spaetestens dann auch ohne Aenderung ausgeben
+
+//--- Webserver ---
+#define HTTP_MTU           1400 //1400 Bytes, Sendepuffer = max. TCP-Paket des WINC1500 (SOCKET_BUFFER_MAX_LENGTH)
+#define HTTP_CLIENTS       4    //gleichzeitige Verbindungen (1-6, WINC1500: 7 TCP-Sockets inkl. Server)
+#define HTTP_TIMEOUT       5    //5s, Verbindung ohne Daten schliessen (Keep-Alive)
+
+//--- MQTT (Messwerte senden statt abfragen) ---
+#define MQTT               0    //1 = Messwerte per MQTT an einen Broker senden (nur WiFi)
+#define MQTT_BROKER        ""   //Hostname oder IP-Adresse des Brokers
+#define MQTT_PORT          1883 //1883
+#define MQTT_USER          ""   //Benutzername, "" = ohne Anmeldung
+#define MQTT_PASS          ""   //Passwort
+#define MQTT_TOPIC         "co2ampel" //Topic, wird um /<MAC-Adresse> ergaenzt
+#define MQTT_INTERVALL     60   //60s, min. Sendeintervall bei Aenderung (bei Ampelwechsel sofort, ohne Aenderung nach AUSGABE_MAX)
+#define MQTT_KEEPALIVE     60   //60s, Keep-Alive der Verbindung zum Broker
+#define MQTT_TIMEOUT       2    //2s, max. Wartezeit je Schritt des Verbindungsaufbaus (DNS, TCP, CONNACK)
+#define MQTT_RETRY         10   //10s, Wartezeit nach Verbindungsfehler, verdoppelt sich bis 16x
+#define MQTT_PUFFER        60   //Messwerte puffern, solange keine Verbindung besteht (20 Bytes pro Eintrag)
+#define MQTT_BATCH         10   //max. Messwerte pro Nachricht, JSON-Array: n = laufende Nummer seit dem Start, u = Unix-Zeit (sobald bekannt),
+                                //s = Alter in s, ... Ohne PUBACK werden Messwerte nach dem Neuverbinden evtl. doppelt gesendet, dann mit denselben n und u
+#define MQTT_TLS           0    //1 = TLS-Verbindung (BearSSL), MQTT_PORT dann meist 8883
+                                //RAM sparen: MQTT_TLS_LOW_MEMORY in src/ArduinoBearSSLConfig.h (1kB statt 8kB Empfangspuffer), nur fuer Broker mit
+                                //max_fragment_length, ignoriert der Broker die Erweiterung, bricht die Verbindung beim ersten Datensatz ueber 1kB ab
+#define MQTT_TLS_ATECC     1    //1 = Signatur (Client-Zertifikat) und ECDH im ATECC608, falls vorhanden, 0 = nur Software
+#define MQTT_TLS_SLOT      0    //Schluessel-Slot des Client-Zertifikats im ATECC608
+#define MQTT_TLS_CERT      ""   //Client-Zertifikat (PEM) zum Schluessel in MQTT_TLS_SLOT, "" = ohne
+
+//--- LoRaWAN (Messwerte per RFM9X senden, nur Pro-Version) ---
+#define LORA               0    //1 = Messwerte per LoRaWAN (ABP, EU868) senden
+#define LORA_DEVADDR       0x00000000 //Device Address (TTN Console)
+#define LORA_NWKSKEY       0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 //Network Session Key (MSB)
+#define LORA_APPSKEY       0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00 //App Session Key (MSB)
+#define LORA_PORT          1    //FPort der Messwerte
+#define LORA_DR            DR_SF7 //Datenrate (DR_SF7-DR_SF12)
+#define LORA_INTERVALL_MIN 120  //120s, min. Abstand der Nachrichten (bei starker Aenderung oder Ampelwechsel)
+#define LORA_INTERVALL_MAX 900  //900s, max. Abstand der Nachrichten (ohne Aenderung)
+#define LORA_DELTA_CO2     100  //100ppm, Aenderung seit der letzten Nachricht fuer vorzeitiges Senden
+#define LORA_AIRTIME       30   //30s, Sendezeit pro Tag (TTN Fair Use), ungenutzte Zeit wird max. 3h angespart (SF12: 1.3s pro Nachricht)
+
+//--- Messwertverlauf (/history) ---
+#define HISTORY            WIFI_AMPEL //1 = Messwertverlauf im RAM speichern (6 Bytes pro Eintrag, 1176 Eintraege = 7056 Bytes)
+#define HISTORY_INTERVALL  5    //5s, Abstand der Werte in Stufe 1
+#define HISTORY_1_ANZAHL   720  //Stufe 1: 5s-Werte, 720 = 1 Stunde
+#define HISTORY_2_ANZAHL   288  //Stufe 2: 5min-Mittelwerte, 288 = 1 Tag
+#define HISTORY_3_ANZAHL   168  //Stufe 3: 1h-Mittelwerte, 168 = 1 Woche
+#define HISTORY_FLASH      1    //1 = 1h-Mittelwerte zusaetzlich im Flash-Log sichern (ueberstehen einen Neustart)
+#define HISTORY_FLASH_BLOCK 4   //1h-Werte pro Flash-Eintrag (4*6+12 Bytes = 1 Page), 8kB Flash-Log = ca. 90 Eintraege = 15 Tage,
+                                //die Werte seit dem letzten vollen Eintrag (max. 4h) gehen beim Neustart verloren
+
+//--- Ablaufverfolgung (/trace) ---
+#define TRACE              1    //1 = Beginn und Ende der Ablaeufe mit Zeitstempel (us) im RAM aufzeichnen
+#define TRACE_ANZAHL       128  //Eintraege im Ringpuffer (8 Bytes pro Eintrag)
+
+//--- Flash-Log (Einstellungen, Messwerte) ---
+#define FLASH_LOG_SIZE     8192 //8kB, Groesse des Flash-Logs (min. 3kB), wird reihum beschrieben
 
 //--- Farben ---
 #define FARBE_BLAU         0x007CB0 //0x0000FF, Himmelblau: 0x007CB0
@@ -107,18 +199,154 @@ enum Features
   FEATURE_BMP280   = (1<<4),
   FEATURE_WINC1500 = (1<<5),
   FEATURE_SSD1306  = (1<<6),
+  FEATURE_RFM9X    = (1<<7),
+  FEATURE_ATECC608 = (1<<8),
+};
+
+//--- Ablaufsteuerung ohne delay(), wird aus loop() fortgesetzt ---
+typedef struct
+{
+  unsigned int state;   //aktueller Schritt, 0=inaktiv
+  unsigned long t_wait; //Startzeit der Wartezeit
+  unsigned long wait;   //Wartezeit in ms
+} TASK;
+
+//--- Messwertverlauf ---
+typedef struct
+{
+  uint16_t co2;  //ppm
+  int8_t temp;   //0.5 Grad C
+  uint8_t humi;  //0.5 %
+  uint8_t pres;  //2 hPa, ab 600 hPa
+  uint8_t light; //Lichtsensor/4
+} HISTORY_ENTRY;
+
+typedef struct
+{
+  HISTORY_ENTRY *entry;  //Ringpuffer
+  unsigned int size;     //Anzahl Eintraege im Ringpuffer
+  unsigned int head;     //naechster Schreibindex
+  unsigned int count;    //Anzahl gespeicherter Eintraege
+  unsigned int interval; //Abstand der Eintraege in s
+  unsigned int n;        //Anzahl Werte der vorherigen Stufe in sum
+  long sum[5];           //Summen fuer den Mittelwert aus der vorherigen Stufe
+  unsigned int restored; //davon die aeltesten Eintraege aus dem Flash-Log, Alter unbekannt (vor dem Neustart)
+} HISTORY_TIER;
+
+//--- CO2-Filter ---
+typedef struct
+{
+  uint16_t median[FILTER_MEDIAN]; //letzte Rohwerte (Ringpuffer)
+  uint16_t mittel[FILTER_MITTEL]; //letzte Medianwerte (Ringpuffer)
+  uint32_t sum;                   //Summe ueber mittel
+  int32_t ema;                    //EMA in 1/256 ppm
+  unsigned long t;                //Zeitpunkt des letzten Messwerts (millis)
+  unsigned int pos_median;        //naechster Schreibindex in median
+  unsigned int pos_mittel;        //naechster Schreibindex in mittel
+  unsigned int valid;             //0 = noch kein Messwert
+} CO2_FILTER;
+
+//--- Ampel-Einstellungen (eigener Flash-Log Eintrag) ---
+typedef struct
+{
+  uint16_t hysterese[5]; //ppm je Bereich, Rueckschaltung erst unterhalb range-hysterese
+  uint16_t warnung;      //min, Vorwarnzeit der Trendwarnung, 0 = aus
+} AMPEL_SETTINGS;
+
+//--- MQTT-Sendepuffer ---
+typedef struct
+{
+  unsigned long t;  //Zeitpunkt der Messung (millis)
+  uint32_t n;       //laufende Nummer seit dem Start
+  uint16_t co2;     //ppm
+  int16_t temp;     //0.1 Grad C
+  uint16_t humi;    //0.1 %
+  uint16_t pres;    //0.1 hPa, 0 = kein Drucksensor
+  uint16_t light;   //Lichtsensor
+  uint16_t level;   //Ampelstufe 0-4 (blau, gruen, gelb, rot, rot blinken)
+} MQTT_ENTRY;
+
+//--- Aenderungserkennung ---
+enum Value
+{
+  VALUE_CO2 = 0, //co2_value
+  VALUE_TEMP,    //temp_value
+  VALUE_HUMI,    //humi_value
+  VALUE_PRES,    //pres_value
+  VALUE_LIGHT,   //light_value
+  VALUE_NUM
+};
+
+typedef struct
+{
+  float value[VALUE_NUM]; //zuletzt ausgegebene Werte
+  unsigned long t;        //Zeitpunkt der letzten Ausgabe (millis)
+  unsigned int valid;     //0 = noch nie ausgegeben
+} OUTPUT_STATE;
+
+//--- Flash-Log Eintragstypen ---
+enum Log
+{
+  LOG_SETTINGS = 0,  //SETTINGS
+  LOG_AMPEL,         //AMPEL_SETTINGS
+  LOG_HISTORY,       //HISTORY_ENTRY[HISTORY_FLASH_BLOCK] (1h-Mittelwerte)
+};
+
+//--- Laufzeitmessung ---
+enum Profile
+{
+  PROFILE_SERIAL = 0, //serial_service()
+  PROFILE_WEB,        //webserver_service()
+  PROFILE_MQTT,       //mqtt_service()
+  PROFILE_MQTT_CONNECT, //mqtt_reconnect()
+  PROFILE_LORA,       //os_runloop_once()
+  PROFILE_SENSORS,    //check_sensors()
+  PROFILE_AMPEL,      //ampel()
+  PROFILE_NUM
 };
 
+//--- Ablaufverfolgung ---
+enum Trace
+{
+  TRACE_SENSORS = 0, //check_sensors(), I2C
+  TRACE_LEDS,        //ws2812.show()
+  TRACE_DISPLAY,     //display.display(), I2C
+  TRACE_FLASH,       //flash_log.write()
+  TRACE_HTTP,        //http_request()
+  TRACE_MQTT,        //MQTT senden
+  TRACE_WINC_ISR,    //WiFi101 hif_handle_isr(), SPI
+  TRACE_WINC_SEND,   //WiFi101 hif_send(), SPI
+  TRACE_NUM
+};
+
+typedef struct
+{
+  uint32_t t;    //micros()
+  uint8_t scope; //Trace
+  uint8_t begin; //1 = Beginn, 0 = Ende
+} TRACE_EVENT;
+
 
 #include <Wire.h>
+#include <I2CQueue.h>
 #include <SPI.h>
 #include <FlashStorage.h>
+#include <FlashLog.h>
 #include <SparkFun_SCD30_Arduino_Library.h>
 #include <SensirionI2CScd4x.h>
 #include <Adafruit_BMP280.h>
 #include <Arduino_LPS22HB.h>
 #include <Adafruit_NeoPixel.h>
 #include <WiFi101.h>
+#include <ArduinoMqttClient.h>
+#if MQTT && MQTT_TLS
+  #include <ArduinoBearSSL.h>
+  #include <ArduinoECCX08.h>
+#endif
+#if LORA
+  #include <lmic.h>
+  #include <hal/hal.h>
+#endif
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 
@@ -140,939 +368,3305 @@ typedef struct
   IPAddress ip_dns;
 } SETTINGS;
 
+//--- HTTP-Verbindung, Zustand bleibt ueber loop()-Durchlaeufe erhalten ---
+enum HttpState
+{
+  HTTP_FREE = 0, //Slot frei
+  HTTP_METHOD,   //Anfragezeile: Methode
+  HTTP_PATH,     //Anfragezeile: Pfad
+  HTTP_QUERY,    //Anfragezeile: Parameter nach '?'
+  HTTP_VERSION,  //Anfragezeile: HTTP-Version
+  HTTP_HEADER,   //Headerzeilen
+  HTTP_BODY,     //POST-Daten (Content-Length)
+};
+
+enum HttpMethod
+{
+  HTTP_OTHER = 0,
+  HTTP_GET,
+  HTTP_POST,
+};
+
+typedef struct
+{
+  WiFiClient client;
+  unsigned int state;     //HttpState
+  unsigned long t_last;   //letzte Aktivitaet
+  unsigned int close;     //1 = Verbindung nach der Antwort schliessen
+  unsigned int method;    //HttpMethod
+  unsigned int length;    //Content-Length (restliche POST-Daten)
+  unsigned int pos;       //Schreibposition in path, query bzw. line
+  char path[32+1];        //Pfad ohne Parameter
+  char query[32+1];       //Parameter, z.B. s=2
+  char line[32+1];        //Methode, Version und Headerzeilen
+  unsigned int body;      //1 = POST-Daten empfangen
+  unsigned int field, i;  //POST: aktuelles Feld (1-2, 0=Name lesen) und Position
+  unsigned int hex, esc;  //POST: %xx dekodieren, hex=Anzahl gelesener Ziffern
+  char form[2][64+1];     //POST: 1=SSID, 2=Code (dekodiert)
+} HTTP_CONN;
+
+typedef struct
+{
+  unsigned int method;            //HttpMethod
+  const char *path;               //exakter Pfad
+  void (*handler)(HTTP_CONN *c);  //Antwort erzeugen
+} HTTP_ROUTE;
+
 SETTINGS settings;
-FlashStorage(flash_settings, SETTINGS);
+AMPEL_SETTINGS ampel_settings;
+FlashStorage(flash_settings, SETTINGS); //alter Speicherort, nur noch lesen
+FlashLog(flash_log, FLASH_LOG_SIZE);
 SCD30 scd30;
 SensirionI2CScd4x scd4x;
 Adafruit_BMP280 bmp280(&Wire1);
 LPS22HBClass lps22(Wire1);
 Adafruit_NeoPixel ws2812 = Adafruit_NeoPixel(NUM_LEDS, PIN_WS2812, NEO_GRB + NEO_KHZ800);
 Adafruit_SSD1306 display(128, 64); //128x64 Pixel
+I2CQueue i2c0(SERCOM0, &Wire);  //Interrupt-Transfers Wire
+I2CQueue i2c1(SERCOM2, &Wire1); //Interrupt-Transfers Wire1
 WiFiServer server(80); //Webserver Port 80
 
 unsigned int features=0, remote_on=0, buzzer_timer=BUZZER_DELAY;
+unsigned int settings_deferred=0; //1 = settings_save() waehrend LoRa-Empfangsfenster, wird in loop() nachgeholt
 unsigned int co2_value=STARTWERT, co2_average=STARTWERT, light_value=1024;
 float temp_value=20, temp_offset=TEMP_OFFSET, humi_value=50, pres_value=1013, pres_last=1013, temp2_value=20;
+uint32_t light_color=0;
+int32_t co2_trend=0; //Anstieg von co2_average in 1/16 ppm/min
+uint8_t leds_shown[NUM_LEDS*3]; //zuletzt an die LEDs gesendete Daten
+OUTPUT_STATE out_serial, out_display;
+Print *http_client; //WiFiClient, Serial oder NULL (nur Puffer)
+unsigned int http_len=0, http_chunk=0, http_close=1; //http_chunk: Beginn der Daten im Chunk, 0 = ohne Chunks
+HTTP_CONN http_conn[HTTP_CLIENTS];
+unsigned int http_next=0; //Verbindung, die webserver_service() zuerst bedient
+char http_buf[HTTP_MTU]; //Sendepuffer fuer HTTP-Antworten
+I2CTransfer display_xfer[16]; //je Fenster 1 Befehl + 1 je Page, max. 8+8
+uint8_t display_cmd[8][7], *display_buf;
+const uint8_t display_data = 0x40; //Co=0, D/C=1
+I2CTransfer sensor_xfer; //SCD30/SCD4X: Befehl oder Messwerte, per Interrupt
+uint8_t sensor_cmd[2], sensor_rx[18]; //18 Bytes = SCD30 Messwerte (6 Woerter mit CRC)
+#if HISTORY
+HISTORY_ENTRY history_1[HISTORY_1_ANZAHL], history_2[HISTORY_2_ANZAHL], history_3[HISTORY_3_ANZAHL];
+HISTORY_TIER history[3] =
+{
+  { history_1, HISTORY_1_ANZAHL, 0, 0, HISTORY_INTERVALL },
+  { history_2, HISTORY_2_ANZAHL, 0, 0, 5*60 },   //5min
+  { history_3, HISTORY_3_ANZAHL, 0, 0, 60*60 },  //1h
+};
+  #if HISTORY_FLASH
+HISTORY_ENTRY history_flash[HISTORY_FLASH_BLOCK]; //1h-Werte fuer den naechsten Flash-Eintrag
+unsigned int history_flash_n=0;
+  #endif
+#endif
+#if MQTT
+WiFiClient mqtt_net;
+  #if MQTT_TLS
+BearSSLClient mqtt_tls(mqtt_net);
+BearSSLSessionCache mqtt_tls_cache;
+MqttClient mqtt(mqtt_tls);
+  #else
+MqttClient mqtt(mqtt_net);
+  #endif
+MQTT_ENTRY mqtt_queue[MQTT_PUFFER];
+unsigned int mqtt_head=0, mqtt_count=0, mqtt_sent=0; //mqtt_head: naechster Schreibindex, mqtt_sent: gesendete, noch unbestaetigte Eintraege (die aeltesten)
+unsigned long mqtt_t_sent=0; //Zeitpunkt der letzten Nachricht
+uint32_t mqtt_n=0; //Nummer des letzten Messwerts
+unsigned long mqtt_unix=0, mqtt_unix_ms=0; //Unix-Zeit zum Zeitpunkt mqtt_unix_ms (millis), 0 = unbekannt
+char mqtt_topic[sizeof(MQTT_TOPIC)+7]; //MQTT_TOPIC/xxxxxx
+TASK mqtt_task; //Verbindungsaufbau: 1 = DNS, 2 = TCP, 3 = CONNACK
+#endif
+#if LORA
+u1_t lora_nwkskey[16] = { LORA_NWKSKEY };
+u1_t lora_appskey[16] = { LORA_APPSKEY };
+const lmic_pinmap lmic_pins =
+{
+  .nss  = 20, //PA21 RFM9X CS
+  .rxtx = LMIC_UNUSED_PIN,
+  .rst  = LMIC_UNUSED_PIN,
+  .dio  = {21, 22, LMIC_UNUSED_PIN}, //DIO0, DIO1
+};
+unsigned long lora_budget=LORA_AIRTIME*1000000UL/8, lora_tx=0; //lora_budget: angesparte Sendezeit in us
+#endif
+#if TRACE
+TRACE_EVENT trace_buf[TRACE_ANZAHL];
+unsigned int trace_head=0, trace_count=0, trace_pause=0; //trace_head: naechster Schreibindex
+#endif
+unsigned int low_power_on=0; //1 = Standby-Betrieb aktiv
+#if LOW_POWER
+volatile unsigned int rtc_wakeup=0; //vom RTC-Interrupt gesetzt
+#endif
+CO2_FILTER co2_filter_state;
+TASK light_task, pressure_task, status_task, sensor_task, scd4x_task;
+int scd4x_cmd=0, scd4x_val=0; //SCD4X-Befehl von serial_service(): T/A/C setzen, t/a lesen
+uint16_t scd4x_err=0;
+unsigned long profile_sum[PROFILE_NUM], profile_max[PROFILE_NUM], profile_loops=0, profile_loop_max=0, profile_over=0, profile_start=0;
+const unsigned long loop_bucket[] = { 100, 500, 1000, 5000, 10000, 50000, 100000, 1000000 }; //us, Histogramm der loop()-Dauer
+unsigned long loop_hist[sizeof(loop_bucket)/sizeof(loop_bucket[0])+1]; //Anzahl je Grenze, letzter Eintrag = groesser
+uint64_t loop_hist_sum=0; //us
+unsigned long err_co2=0, err_pres=0, wifi_reconnects=0; //Zaehler fuer /metrics, werden nie zurueckgesetzt
+
+
+void profile_add(unsigned int p, unsigned long t_start) //Laufzeit in us aufaddieren
+{
+  unsigned long t = micros()-t_start;
 
+  profile_sum[p] += t;
+  if(t > profile_max[p])
+  {
+    profile_max[p] = t;
+  }
 
-void leds(uint32_t color)
-{
-  ws2812.fill(color, 0, NUM_LEDS);
-  ws2812.show();
+  return;
 }
 
 
-void status_led(unsigned int on)
+void profile_loop(void) //loop()-Durchlauf zaehlen und Latenz messen
 {
-  if(on == 0)
-  {
-    digitalWrite(PIN_LED, LOW); //Status-LED aus
-  }
-  else if(on == 1)
+  static unsigned long t_loop=0;
+  unsigned long t = micros();
+
+  if(profile_loops != 0)
   {
-    digitalWrite(PIN_LED, HIGH); //Status-LED an
+    if((t-t_loop) > profile_loop_max)
+    {
+      profile_loop_max = t-t_loop;
+    }
+    if((t-t_loop) > (LOOP_BUDGET*1000UL))
+    {
+      profile_over++;
+    }
+    unsigned int b;
+    for(b=0; (b < sizeof(loop_bucket)/sizeof(loop_bucket[0])) && ((t-t_loop) > loop_bucket[b]); b++);
+    loop_hist[b]++;
+    loop_hist_sum += t-t_loop;
   }
-  else if(on < 2000)
+  else
   {
-    on = on/2;
-    digitalWrite(PIN_LED, HIGH); //Status-LED an
-    delay(on); //ms warten
-    digitalWrite(PIN_LED, LOW); //Status-LED aus
-    delay(on); //ms warten
+    profile_start = millis();
   }
+  profile_loops++;
+  t_loop = t;
 
   return;
 }
 
 
-void buzzer(unsigned int on)
+void trace(unsigned int scope, unsigned int begin) //Beginn/Ende eines Ablaufs aufzeichnen, SysTick-Zeit ueber micros()
 {
-  if(on == 0)
-  {
-    analogWrite(PIN_BUZZER, 0); //Buzzer aus
-  }
-  else if(on == 1)
+  #if TRACE
+    if(trace_pause)
+    {
+      return;
+    }
+    TRACE_EVENT *e = &trace_buf[trace_head];
+    e->t     = micros();
+    e->scope = scope;
+    e->begin = begin;
+    trace_head = (trace_head + 1) % TRACE_ANZAHL;
+    if(trace_count < TRACE_ANZAHL)
+    {
+      trace_count++;
+    }
+  #endif
+
+  return;
+}
+
+
+extern "C" void hif_trace(uint8_t id, uint8_t begin) //WiFi101: SPI-Zugriffe auf den WINC1500, id 0=hif_handle_isr(), 1=hif_send()
+{
+  trace(TRACE_WINC_ISR + id, begin);
+
+  return;
+}
+
+
+unsigned long uptime(void) //Laufzeit in s, zaehlt ueber den Ueberlauf von millis() (49 Tage) hinaus
+{
+  static unsigned long t_last=0, wraps=0;
+  unsigned long t = millis();
+
+  if(t < t_last)
   {
-    analogWrite(PIN_BUZZER, 255/2); //Buzzer an
+    wraps++;
   }
-  else if(on < 2000)
+  t_last = t;
+
+  return (unsigned long)((((uint64_t)wraps << 32) + t) / 1000);
+}
+
+
+extern "C" char *sbrk(int i);
+#define MEM_MUSTER 0xA5
+
+void mem_paint(void) //freien RAM zwischen Heap und Stack markieren (Stack-Wasserzeichen)
+{
+  char top, *p = sbrk(0);
+  uintptr_t n;
+
+  //Heap und Stack sind verschiedene Objekte: Zeigervergleich ist undefiniert, daher als Zahl rechnen
+  n = ((uintptr_t)&top - 64) - (uintptr_t)p;
+  if(n < ((uintptr_t)&top - (uintptr_t)p)) //kein Unterlauf
   {
-    analogWrite(PIN_BUZZER, 255/2); //Buzzer an
-    delay(on); //ms warten
-    analogWrite(PIN_BUZZER, 0); //Buzzer aus
+    memset(p, MEM_MUSTER, n);
   }
 
   return;
 }
 
 
-unsigned int light_sensor(void) //Auslesen des Lichtsensors
+unsigned int mem_free(void) //aktuell freier RAM zwischen Heap und Stack
 {
-  unsigned int i;
-  uint32_t color = ws2812.getPixelColor(0); //aktuelle Farbe speichern
+  char top;
 
-  //ws2812.setPixelColor(2, FARBE_AUS); //LED 3 aus
-  ws2812.fill(FARBE_AUS, 0, 4); //alle 4 LEDs aus
-  ws2812.show();
+  return (uintptr_t)&top - (uintptr_t)sbrk(0);
+}
 
-  digitalWrite(PIN_LSENSOR_PWR, HIGH); //Lichtsensor an
-  delay(40); //40ms warten
-  i = analogRead(PIN_LSENSOR); //0...1024
-  delay(10); //10ms warten
-  i += analogRead(PIN_LSENSOR); //0...1024
-  i /= 2;
-  digitalWrite(PIN_LSENSOR_PWR, LOW); //Lichtsensor aus
 
-  //ws2812.setPixelColor(2, color); //LED 3 an
-  leds(color);
+unsigned int mem_headroom(void) //kleinster freier RAM seit mem_paint(): unberuehrte Bytes ueber dem Heap
+{
+  char top, *p = sbrk(0);
+  uintptr_t i, n = (uintptr_t)&top - (uintptr_t)p;
+
+  for(i = 0; (i < n) && (p[i] == (char)MEM_MUSTER); i++);
 
   return i;
 }
 
 
-float co2_sensor(void)
+void profile_show(void) //Laufzeitmessung ausgeben und zuruecksetzen
 {
-  return co2_value;
+  static const char *name[PROFILE_NUM] = { "serial", "web", "mqtt", "mqtt_con", "lora", "sensors", "ampel" };
+  unsigned long t = millis()-profile_start;
+
+  if(t == 0)
+  {
+    t = 1;
+  }
+  Serial.print("time (ms): ");
+  Serial.println(t);
+  Serial.print("loops/s: ");
+  Serial.println((profile_loops*1000UL)/t);
+  Serial.print("loop max (us): ");
+  Serial.println(profile_loop_max);
+  Serial.print("loops > ");
+  Serial.print(LOOP_BUDGET);
+  Serial.print("ms: ");
+  Serial.println(profile_over);
+  for(unsigned int p=0; p < PROFILE_NUM; p++)
+  {
+    Serial.print(name[p]);
+    Serial.print(" (us): ");
+    Serial.print(profile_sum[p]);
+    Serial.print(" max ");
+    Serial.println(profile_max[p]);
+    profile_sum[p] = 0;
+    profile_max[p] = 0;
+  }
+  profile_loops    = 0;
+  profile_loop_max = 0;
+  profile_over     = 0;
+
+  return;
 }
 
 
-float temp_sensor(void)
+void task_wait(TASK *task, unsigned int state, unsigned long ms) //naechsten Schritt nach Wartezeit ausfuehren
 {
-  return temp_value;
+  task->state  = state;
+  task->t_wait = millis();
+  task->wait   = ms;
+
+  return;
 }
 
 
-float humi_sensor(void)
+void task_stop(TASK *task)
 {
-  return humi_value;
+  task->state = 0;
+
+  return;
 }
 
 
-float pres_sensor(void)
+unsigned int task_ready(TASK *task) //1=Wartezeit abgelaufen
 {
-  return pres_value;
+  return (task->state != 0) && ((millis()-task->t_wait) >= task->wait);
 }
 
 
-unsigned int check_sensors(void) //Sensoren auslesen
+void settings_save(void) //geaenderte Einstellungen (SETTINGS, AMPEL_SETTINGS) als neue Eintraege ins Flash-Log schreiben
 {
-  if(features & FEATURE_SCD30)
+  if(lora_pending()) //Flash-Schreiben haelt die CPU an, RX-Fenster nicht verpassen
   {
-    if(scd30.dataAvailable())
-    {
-      co2_value  = scd30.getCO2();
-      temp_value = scd30.getTemperature();
-      humi_value = scd30.getHumidity();
-      if(features & FEATURE_LPS22HB)
-      {
-        pres_value  = lps22.readPressure()*10; //kPa -> hPa
-        temp2_value = lps22.readTemperature()-temp_offset;
-      }
-      if(features & FEATURE_BMP280)
-      {
-        pres_value  = bmp280.readPressure()/100; //Pa -> hPa
-        temp2_value = bmp280.readTemperature()-temp_offset;
-      }
-      if((pres_value < (pres_last-DRUCK_DIFF)) || (pres_value > (pres_last+DRUCK_DIFF)))
-      {
-        pres_last = pres_value;
-        scd30.setAmbientPressure(pres_value); //hPa=mBar
-      }
-      if(humi_value < 0)
-      {
-        humi_value = 0;
-      }
-      else if(humi_value > 100)
-      {
-        humi_value = 100;
-      }
-      return 1;
-    }
+    settings_deferred = 1;
+    return;
   }
-  else if(features & FEATURE_SCD4X)
+  settings_deferred = 0;
+  trace(TRACE_FLASH, 1);
+  if(flash_log.equals(LOG_SETTINGS, &settings, sizeof(settings)) == false)
   {
-    uint16_t v_co2;
-    float v_temp;
-    float v_humi;
-    if(scd4x.readMeasurement(v_co2, v_temp, v_humi) == 0)
-    {
-      co2_value  = v_co2;
-      temp_value = v_temp;
-      humi_value = v_humi;
-      if(features & FEATURE_LPS22HB)
-      {
-        pres_value  = lps22.readPressure()*10; //kPa -> hPa
-        temp2_value = lps22.readTemperature()-temp_offset;
-      }
-      if(features & FEATURE_BMP280)
-      {
-        pres_value  = bmp280.readPressure()/100; //Pa -> hPa
-        temp2_value = bmp280.readTemperature()-temp_offset;
-      }
-      if((pres_value < (pres_last-DRUCK_DIFF)) || (pres_value > (pres_last+DRUCK_DIFF)))
-      {
-        pres_last = pres_value;
-        scd4x.stopPeriodicMeasurement();
-        delay(1000);
-        scd4x.setAmbientPressure(pres_value); //hPa=mBar
-        delay(500);
-        scd4x.startPeriodicMeasurement();
-      }
-      if(humi_value < 0)
-      {
-        humi_value = 0;
-      }
-      else if(humi_value > 100)
-      {
-        humi_value = 100;
-      }
-      return 1;
-    }
+    flash_log.write(LOG_SETTINGS, &settings, sizeof(settings));
+  }
+  if(flash_log.equals(LOG_AMPEL, &ampel_settings, sizeof(ampel_settings)) == false)
+  {
+    flash_log.write(LOG_AMPEL, &ampel_settings, sizeof(ampel_settings));
   }
+  trace(TRACE_FLASH, 0);
 
-  return 0;
+  return;
 }
 
 
-void show_data(void) //Daten anzeigen
+#if HISTORY
+void history_add(unsigned int tier, const HISTORY_ENTRY *e) //Eintrag speichern, Mittelwert fuer naechste Stufe bilden
 {
-  if(features & FEATURE_USB)
+  HISTORY_TIER *h = &history[tier];
+
+  if((h->count == h->size) && (h->restored > 0)) //aeltester Eintrag wird ueberschrieben
   {
-    Serial.print("c: ");           //CO2
-    Serial.println(co2_value);     //Wert in ppm
-    Serial.print("t: ");           //Temperatur
-    Serial.println(temp_value, 1); //Wert in °C
-    Serial.print("h: ");           //Humidity/Luftfeuchte
-    Serial.println(humi_value, 1); //Wert in %
-    Serial.print("l: ");           //Licht
-    Serial.println(light_value);
-    if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
+    h->restored--;
+  }
+  h->entry[h->head] = *e;
+  h->head = (h->head+1) % h->size;
+  if(h->count < h->size)
+  {
+    h->count++;
+  }
+
+  if(++tier < 3)
+  {
+    h = &history[tier];
+    h->sum[0] += e->co2;
+    h->sum[1] += e->temp;
+    h->sum[2] += e->humi;
+    h->sum[3] += e->pres;
+    h->sum[4] += e->light;
+    h->n++;
+    if(h->n >= (h->interval / history[tier-1].interval))
     {
-      Serial.print("p: ");         //Druck
-      Serial.println(pres_value);  //Wert in hPa
-      Serial.print("u: ");         //Temperatur
-      Serial.println(temp2_value); //Wert in °C
+      HISTORY_ENTRY avg;
+      avg.co2   = h->sum[0] / (long)h->n;
+      avg.temp  = h->sum[1] / (long)h->n;
+      avg.humi  = h->sum[2] / (long)h->n;
+      avg.pres  = h->sum[3] / (long)h->n;
+      avg.light = h->sum[4] / (long)h->n;
+      memset(h->sum, 0, sizeof(h->sum));
+      h->n = 0;
+      history_add(tier, &avg);
+      #if HISTORY_FLASH
+        if((tier == 2) && (history_flash_n < HISTORY_FLASH_BLOCK)) //schreiben in history_save()
+        {
+          history_flash[history_flash_n++] = avg;
+        }
+      #endif
     }
-    Serial.println();
   }
 
-  if(features & FEATURE_SSD1306)
+  return;
+}
+
+
+#if HISTORY_FLASH
+void history_save(void) //1h-Werte blockweise sichern, 1 Page pro Eintrag
+{
+  if(history_flash_n >= HISTORY_FLASH_BLOCK)
   {
-    display.clearDisplay();
-    display.setTextSize(5);
-    display.setCursor(5,5);
-    display.println(co2_value);
-    display.setTextSize(1);
-    display.setCursor(5,56);
-    display.println("CO2 Level in ppm");
-    display.display();
+    trace(TRACE_FLASH, 1);
+    flash_log.write(LOG_HISTORY, history_flash, sizeof(history_flash));
+    trace(TRACE_FLASH, 0);
+    history_flash_n = 0;
   }
 
   return;
 }
 
 
-void serial_service(void)
+void history_restore(void) //gesicherte 1h-Werte aus dem Flash-Log laden
 {
-  static int calibration_done=0;
-  int i, cmd, val;
-  char tmp[32];
+  uint32_t seq=0;
 
-  if((features & FEATURE_USB) == 0)
+  while((seq = flash_log.readNext(LOG_HISTORY, seq, history_flash, sizeof(history_flash))) != 0)
   {
-    return;
+    for(unsigned int i=0; i < HISTORY_FLASH_BLOCK; i++)
+    {
+      history_add(2, &history_flash[i]);
+    }
   }
+  history_flash_n = 0;
+  history[2].restored = history[2].count; //Luecke bis zum Neustart ist unbekannt
 
-  if(Serial.available() == 0)
-  {
-    return;
-  }
+  return;
+}
+#endif
 
-  cmd = Serial.read(); //Befehl
-  if((cmd != 'R') && (remote_on == 0))
+
+void history_sample(void) //aktuelle Messwerte in Stufe 1 speichern
+{
+  HISTORY_ENTRY e;
+  float v;
+
+  e.co2 = co2_value;
+  v = temp_value*2;
+  e.temp = (v < -128) ? -128 : (v > 127) ? 127 : (int8_t)v;
+  e.humi = humi_value*2; //0...100% -> 0...200
+  v = (pres_value-600)/2;
+  e.pres = (v < 0) ? 0 : (v > 255) ? 255 : (uint8_t)v;
+  e.light = light_value/4;
+  history_add(0, &e);
+
+  return;
+}
+#endif
+
+
+void leds_show(void) //LEDs aktualisieren, alle Aufrufe von ws2812.show() laufen hierueber
+{
+  memcpy(leds_shown, ws2812.getPixels(), sizeof(leds_shown));
+  trace(TRACE_LEDS, 1);
+  ws2812.show();
+  trace(TRACE_LEDS, 0);
+
+  return;
+}
+
+
+void leds(uint32_t color)
+{
+  ws2812.fill(color, 0, NUM_LEDS);
+  if(memcmp(leds_shown, ws2812.getPixels(), sizeof(leds_shown)) == 0) //Farbe und Helligkeit unveraendert
   {
     return;
   }
+  leds_show();
 
-  val = Serial.read(); //schreiben/lesen
-  if(val == '=') //=
-  {
+  return;
+}
+
+
+unsigned int output_changed(OUTPUT_STATE *o, unsigned int mask, unsigned long t_min) //1=ausgeben: Aenderung eines Wertes aus mask ueber das Totband (fruehestens t_min ms nach der letzten Ausgabe) oder AUSGABE_MAX abgelaufen
+{
+  static const float totband[VALUE_NUM] = { TOTBAND_CO2, TOTBAND_TEMP, TOTBAND_HUMI, TOTBAND_PRES, TOTBAND_LIGHT };
+  float value[VALUE_NUM] = { (float)co2_value, temp_value, humi_value, pres_value, (float)light_value };
+  unsigned int change=0;
+
+  for(unsigned int v=0; v < VALUE_NUM; v++)
+  {
+    if((mask & (1<<v)) && (fabsf(value[v]-o->value[v]) >= totband[v]))
+    {
+      change = 1;
+    }
+  }
+  if(o->valid && ((millis()-o->t) < (AUSGABE_MAX*1000UL)) && ((change == 0) || ((millis()-o->t) < t_min)))
+  {
+    return 0;
+  }
+  memcpy(o->value, value, sizeof(value));
+  o->t = millis();
+  o->valid = 1;
+
+  return 1;
+}
+
+
+void status_led(unsigned int on) //0=aus, 1=an, 2-1999: on/2 ms an, wartet nicht (aus per status_service())
+{
+  if(on == 0)
+  {
+    task_stop(&status_task);
+    digitalWrite(PIN_LED, LOW); //Status-LED aus
+  }
+  else if(on == 1)
+  {
+    task_stop(&status_task);
+    digitalWrite(PIN_LED, HIGH); //Status-LED an
+  }
+  else if(on < 2000)
+  {
+    status_blink(on/2);
+  }
+
+  return;
+}
+
+
+void status_wait(unsigned int ms) //Status-LED blinken und ms warten, nur in setup() und den Menues
+{
+  unsigned long t = millis();
+
+  status_led(ms);
+  while((millis()-t) < ms)
+  {
+    status_service();
+  }
+
+  return;
+}
+
+
+void status_blink(unsigned int ms) //Status-LED fuer ms an, ohne zu warten
+{
+  digitalWrite(PIN_LED, HIGH); //Status-LED an
+  task_wait(&status_task, 1, ms);
+
+  return;
+}
+
+
+void status_service(void)
+{
+  if(task_ready(&status_task))
+  {
+    task_stop(&status_task);
+    digitalWrite(PIN_LED, LOW); //Status-LED aus
+  }
+
+  return;
+}
+
+
+void buzzer(unsigned int on)
+{
+  if(on == 0)
+  {
+    analogWrite(PIN_BUZZER, 0); //Buzzer aus
+  }
+  else if(on == 1)
+  {
+    analogWrite(PIN_BUZZER, 255/2); //Buzzer an
+  }
+  else if(on < 2000)
+  {
+    analogWrite(PIN_BUZZER, 255/2); //Buzzer an
+    delay(on); //ms warten
+    analogWrite(PIN_BUZZER, 0); //Buzzer aus
+  }
+
+  return;
+}
+
+
+void light_start(void) //Messung des Lichtsensors starten
+{
+  light_color = ws2812.getPixelColor(0); //aktuelle Farbe speichern
+
+  //ws2812.setPixelColor(2, FARBE_AUS); //LED 3 aus
+  ws2812.fill(FARBE_AUS, 0, 4); //alle 4 LEDs aus
+  leds_show();
+
+  digitalWrite(PIN_LSENSOR_PWR, HIGH); //Lichtsensor an
+  task_wait(&light_task, 1, 40); //40ms warten
+
+  return;
+}
+
+
+unsigned int light_sensor(void) //Auslesen des Lichtsensors, 1=Messung fertig
+{
+  static unsigned int i;
+
+  if(task_ready(&light_task) == 0)
+  {
+    return 0;
+  }
+
+  if(light_task.state == 1)
+  {
+    i = analogRead(PIN_LSENSOR); //0...1024
+    task_wait(&light_task, 2, 10); //10ms warten
+    return 0;
+  }
+
+  i += analogRead(PIN_LSENSOR); //0...1024
+  light_value = i/2;
+  digitalWrite(PIN_LSENSOR_PWR, LOW); //Lichtsensor aus
+  task_stop(&light_task);
+
+  //ws2812.setPixelColor(2, color); //LED 3 an
+  leds(light_color);
+
+  return 1;
+}
+
+
+float co2_sensor(void)
+{
+  return co2_value;
+}
+
+
+float temp_sensor(void)
+{
+  return temp_value;
+}
+
+
+float humi_sensor(void)
+{
+  return humi_value;
+}
+
+
+float pres_sensor(void)
+{
+  return pres_value;
+}
+
+
+unsigned int co2_filter(unsigned int co2) //neuen Messwert filtern (Festkomma): Median gegen Ausreisser, gleitender Mittelwert, EMA
+{
+  CO2_FILTER *f = &co2_filter_state;
+  uint16_t sorted[FILTER_MEDIAN];
+  unsigned long dt;
+  unsigned int i, j, x;
+
+  x = (co2 > 16383) ? 16383 : co2; //EMA-Produkt bleibt unter 2^31
+  if(f->valid == 0) //erster Wert: Puffer fuellen, kein Einschwingen
+  {
+    for(i=0; i < FILTER_MEDIAN; i++)
+    {
+      f->median[i] = x;
+    }
+    for(i=0; i < FILTER_MITTEL; i++)
+    {
+      f->mittel[i] = x;
+    }
+    f->sum = (uint32_t)x * FILTER_MITTEL;
+    f->ema = (int32_t)x << 8;
+    f->t = millis();
+    f->valid = 1;
+    return x;
+  }
+
+  //Median: sortierte Kopie der letzten Werte (Insertion Sort)
+  f->median[f->pos_median] = x;
+  f->pos_median = (f->pos_median + 1) % FILTER_MEDIAN;
+  for(i=0; i < FILTER_MEDIAN; i++)
+  {
+    for(j=i; (j > 0) && (sorted[j-1] > f->median[i]); j--)
+    {
+      sorted[j] = sorted[j-1];
+    }
+    sorted[j] = f->median[i];
+  }
+  x = sorted[FILTER_MEDIAN/2];
+
+  //gleitender Mittelwert: laufende Summe
+  f->sum = f->sum - f->mittel[f->pos_mittel] + x;
+  f->mittel[f->pos_mittel] = x;
+  f->pos_mittel = (f->pos_mittel + 1) % FILTER_MITTEL;
+  x = (f->sum + FILTER_MITTEL/2) / FILTER_MITTEL;
+
+  //EMA: Gewicht a = dt/(tau+dt) in 1/256, passt sich an 2s (SCD30), 5s (SCD4X) oder den Standby-Betrieb an
+  dt = millis() - f->t;
+  f->t = millis();
+  #if FILTER_TAU > 0
+    if(dt > 3600000UL)
+    {
+      dt = 3600000UL; //1h, dt*256 bleibt unter 2^32
+    }
+    int32_t a = (dt*256UL) / (dt + (FILTER_TAU*1000UL));
+    f->ema += (a * (((int32_t)x << 8) - f->ema)) / 256;
+    x = (f->ema + 128) >> 8;
+  #else
+    f->ema = (int32_t)x << 8;
+  #endif
+
+  return x;
+}
+
+
+void trend_update(unsigned int co2) //Anstieg in 1/16 ppm/min als EMA der Differenzen (Ganzzahl), nur bei neuen Messwerten
+{
+  static unsigned int co2_last=0;
+  static unsigned long t_last=0;
+  unsigned long dt = millis()-t_last;
+  int32_t d, a;
+
+  t_last = millis();
+  if(co2_last == 0) //erster Wert
+  {
+    co2_last = co2;
+    return;
+  }
+  if(dt < 1000)
+  {
+    dt = 1000; //1s, begrenzt d
+  }
+  else if(dt > 3600000UL)
+  {
+    dt = 3600000UL; //1h, dt*256 bleibt unter 2^32
+  }
+
+  d = (int32_t)co2 - (int32_t)co2_last;
+  co2_last = co2;
+  if(d > 2000)
+  {
+    d = 2000; //d*960000 bleibt unter 2^31
+  }
+  else if(d < -2000)
+  {
+    d = -2000;
+  }
+  d = (d * 960000L) / (int32_t)dt; //ppm/ms -> 1/16 ppm/min
+  a = (dt*256UL) / (dt + (TREND_TAU*1000UL)); //Gewicht in 1/256
+  co2_trend += (a * (d - co2_trend)) / 256;
+
+  return;
+}
+
+
+unsigned int trend_warning(unsigned int co2) //1 = rot (Bereich 3) wird beim aktuellen Anstieg innerhalb der Vorwarnzeit erreicht
+{
+  if((ampel_settings.warnung == 0) || (co2_trend <= 0) || (co2 >= settings.range[2]))
+  {
+    return 0;
+  }
+
+  //(Schwelle-co2) / Anstieg <= Vorwarnzeit, ohne Division
+  return (((uint32_t)(settings.range[2] - co2) * 16) <= ((uint32_t)co2_trend * ampel_settings.warnung));
+}
+
+
+void pressure_service(void) //SCD4X Druckkompensation fortsetzen
+{
+  if((task_ready(&pressure_task) == 0) || (scd4x.pollCommand() == false))
+  {
+    return;
+  }
+
+  if(pressure_task.state == 1)
+  {
+    scd4x.beginSetAmbientPressure(pres_last); //hPa=mBar
+    task_wait(&pressure_task, 2, 500); //500ms warten
+  }
+  else
+  {
+    scd4x.startPeriodicMeasurement();
+    task_stop(&pressure_task);
+  }
+
+  return;
+}
+
+
+uint8_t sensor_crc(const uint8_t *data) //Sensirion CRC-8 ueber ein 16-Bit-Wort (Polynom 0x31, Startwert 0xFF)
+{
+  uint8_t crc = 0xFF;
+
+  for(unsigned int i=0; i < 2; i++)
+  {
+    crc ^= data[i];
+    for(unsigned int b=0; b < 8; b++)
+    {
+      crc = (crc & 0x80) ? ((crc << 1) ^ 0x31) : (crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+
+unsigned int sensor_words(uint16_t *words, unsigned int n) //n Woerter aus sensor_rx pruefen, 1=Transfer und CRC ok
+{
+  if(sensor_xfer.status != I2C_OK)
+  {
+    return 0;
+  }
+  for(unsigned int i=0; i < n; i++)
+  {
+    const uint8_t *p = &sensor_rx[i*3];
+    if(sensor_crc(p) != p[2])
+    {
+      return 0;
+    }
+    words[i] = (p[0] << 8) | p[1];
+  }
+
+  return 1;
+}
+
+
+void sensor_transfer(uint8_t addr, uint16_t cmd, unsigned int rx) //SCD30/SCD4X: Befehl (rx=0) oder Antwort mit rx Bytes lesen, per Interrupt
+{
+  sensor_cmd[0]     = cmd >> 8;
+  sensor_cmd[1]     = cmd & 0xFF;
+  sensor_xfer.addr  = addr;
+  sensor_xfer.head  = NULL;
+  sensor_xfer.headLen = 0;
+  sensor_xfer.tx    = (rx == 0) ? sensor_cmd : NULL;
+  sensor_xfer.txLen = (rx == 0) ? 2 : 0;
+  sensor_xfer.rx    = sensor_rx;
+  sensor_xfer.rxLen = rx;
+  sensor_xfer.done  = NULL;
+  i2c0.submit(&sensor_xfer);
+
+  return;
+}
+
+
+float sensor_float(const uint16_t *words) //SCD30: Float aus 2 Woertern (Big-Endian)
+{
+  uint32_t u = ((uint32_t)words[0] << 16) | words[1];
+  float f;
+
+  memcpy(&f, &u, sizeof(f));
+
+  return f;
+}
+
+
+void sensor_values(void) //neue CO2-Werte: Druck lesen, Druckkompensation, Feuchte begrenzen
+{
+  if(features & FEATURE_LPS22HB)
+  {
+    pres_value  = lps22.readPressure()*10; //kPa -> hPa
+    temp2_value = lps22.readTemperature()-temp_offset;
+  }
+  if(features & FEATURE_BMP280)
+  {
+    pres_value  = bmp280.readPressure()/100; //Pa -> hPa
+    temp2_value = bmp280.readTemperature()-temp_offset;
+  }
+  if((features & (FEATURE_LPS22HB|FEATURE_BMP280)) && !((pres_value >= 300) && (pres_value <= 1100))) //Lesefehler oder NaN
+  {
+    err_pres++;
+    pres_value = pres_last;
+  }
+  if((pres_value < (pres_last-DRUCK_DIFF)) || (pres_value > (pres_last+DRUCK_DIFF)))
+  {
+    pres_last = pres_value;
+    if(features & FEATURE_SCD30)
+    {
+      scd30.setAmbientPressure(pres_value); //hPa=mBar
+    }
+    else if(low_power_on == 0) //SCD4X, Standby-Betrieb: wird vor jeder Einzelmessung gesetzt
+    {
+      scd4x.beginStopPeriodicMeasurement();
+      task_wait(&pressure_task, 1, 1000); //1s warten, weiter in pressure_service()
+    }
+  }
+  if(humi_value < 0)
+  {
+    humi_value = 0;
+  }
+  else if(humi_value > 100)
+  {
+    humi_value = 100;
+  }
+
+  return;
+}
+
+
+void scd4x_start(int cmd, int val) //SCD4X-Befehl ohne Warten ausfuehren, Antwort in scd4x_service()
+{
+  if(scd4x_task.state != 0) //vorheriger Befehl laeuft noch
+  {
+    Serial.println("ERROR");
+    return;
+  }
+  scd4x_cmd = cmd;
+  scd4x_val = val;
+  task_wait(&scd4x_task, 1, 0);
+
+  return;
+}
+
+
+void scd4x_service(void) //SCD4X-Befehl fortsetzen: Messung stoppen, Befehl senden, Antwort ausgeben, Messung starten
+{
+  uint16_t w=0;
+  float f=0;
+
+  if((task_ready(&scd4x_task) == 0) || (scd4x.pollCommand() == false))
+  {
+    return;
+  }
+
+  if(scd4x_task.state == 1)
+  {
+    if((pressure_task.state != 0) || (sensor_task.state > 1)) //Druckkompensation oder Messwert-Transfer laeuft
+    {
+      task_wait(&scd4x_task, 1, 10);
+      return;
+    }
+    scd4x.beginStopPeriodicMeasurement();
+    task_wait(&scd4x_task, 2, 500); //500ms warten
+  }
+  else if(scd4x_task.state == 2)
+  {
+    switch(scd4x_cmd)
+    {
+      case 'T': scd4x_err = scd4x.beginSetTemperatureOffset(scd4x_val); break;
+      case 'A': scd4x_err = scd4x.beginSetSensorAltitude(scd4x_val); break;
+      case 'C': scd4x_err = scd4x.beginPerformForcedRecalibration(scd4x_val); break;
+      case 't': scd4x_err = scd4x.beginGetTemperatureOffset(); break;
+      case 'a': scd4x_err = scd4x.beginGetSensorAltitude(); break;
+    }
+    task_wait(&scd4x_task, 3, 0); //weiter nach der Ausfuehrungszeit (pollCommand)
+  }
+  else
+  {
+    if(scd4x_err == 0)
+    {
+      switch(scd4x_cmd)
+      {
+        case 'C': scd4x_err = scd4x.readForcedRecalibrationResult(w); break;
+        case 't': scd4x_err = scd4x.readTemperatureOffsetResult(f); break;
+        case 'a': scd4x_err = scd4x.readSensorAltitudeResult(w); break;
+      }
+    }
+    if(scd4x_err != 0)
+    {
+      Serial.println("ERROR");
+    }
+    else if(scd4x_cmd == 't')
+    {
+      Serial.println((int)f, DEC);
+    }
+    else if(scd4x_cmd == 'a')
+    {
+      Serial.println(w, DEC);
+    }
+    else
+    {
+      Serial.println("OK");
+    }
+    scd4x.startPeriodicMeasurement();
+    task_stop(&scd4x_task);
+  }
+
+  return;
+}
+
+
+unsigned int check_sensors(void) //Sensoren auslesen ohne zu warten, I2C-Transfers per Interrupt (i2c0), aus loop() aufrufen, 1=neue Messwerte
+{
+  uint16_t w[6];
+  unsigned int ret=0;
+
+  if(sensor_task.state == 0) //erster Aufruf
+  {
+    task_wait(&sensor_task, 1, 0);
+  }
+  if(sensor_xfer.status == I2C_PENDING)
+  {
+    i2c0.service(); //Timeout
+    return 0;
+  }
+  if(task_ready(&sensor_task) == 0)
+  {
+    return 0;
+  }
+
+  trace(TRACE_SENSORS, 1);
+  switch(sensor_task.state)
+  {
+    case 1: //Messwerte bereit?
+      if(features & FEATURE_SCD30)
+      {
+        sensor_transfer(ADDR_SCD30, 0x0202, 0); //get data ready
+        task_wait(&sensor_task, 2, 3); //SCD30: 3ms bis zum Lesen
+      }
+      else if(features & FEATURE_SCD4X)
+      {
+        pressure_service();
+        if((pressure_task.state != 0) || (scd4x_task.state != 0)) //Messung gestoppt
+        {
+          task_wait(&sensor_task, 1, SENSOR_POLL);
+        }
+        else
+        {
+          sensor_transfer(ADDR_SCD4X, 0xEC05, 0); //read_measurement, NACK = keine neuen Werte
+          task_wait(&sensor_task, 6, 1); //1ms Ausfuehrungszeit
+        }
+      }
+      else
+      {
+        task_wait(&sensor_task, 1, SENSOR_POLL);
+      }
+      break;
+
+    case 2: //SCD30 data ready lesen
+    case 4: //SCD30 Messwerte lesen
+    case 6: //SCD4X Messwerte lesen
+      if(sensor_xfer.status != I2C_OK)
+      {
+        task_wait(&sensor_task, 1, SENSOR_POLL);
+        break;
+      }
+      sensor_transfer((sensor_task.state == 6) ? ADDR_SCD4X : ADDR_SCD30, 0, (sensor_task.state == 2) ? 3 : ((sensor_task.state == 4) ? 18 : 9));
+      task_wait(&sensor_task, sensor_task.state+1, 0);
+      break;
+
+    case 3: //SCD30 read measurement
+      if(sensor_words(w, 1) && (w[0] == 1))
+      {
+        sensor_transfer(ADDR_SCD30, 0x0300, 0);
+        task_wait(&sensor_task, 4, 3); //3ms bis zum Lesen
+      }
+      else
+      {
+        task_wait(&sensor_task, 1, SENSOR_POLL);
+      }
+      break;
+
+    case 5: //SCD30 Messwerte: CO2, Temperatur, Feuchte als Float
+      if(sensor_words(w, 6))
+      {
+        co2_value  = sensor_float(&w[0]);
+        temp_value = sensor_float(&w[2]);
+        humi_value = sensor_float(&w[4]);
+        sensor_values();
+        ret = 1;
+      }
+      task_wait(&sensor_task, 1, SENSOR_POLL);
+      break;
+
+    case 7: //SCD4X Messwerte: CO2, Temperatur, Feuchte als Rohwerte
+      if(sensor_words(w, 3))
+      {
+        co2_value  = w[0];
+        temp_value = -45 + ((175 * (float)w[1]) / 65536);
+        humi_value = (100 * (float)w[2]) / 65536;
+        sensor_values();
+        ret = 1;
+      }
+      task_wait(&sensor_task, 1, SENSOR_POLL);
+      break;
+
+    default:
+      task_stop(&sensor_task);
+      break;
+  }
+  trace(TRACE_SENSORS, 0);
+
+  return ret;
+}
+
+
+unsigned int check_sensors_wait(void) //Sensoren sofort auslesen und warten (Test, Kalibrierung, Standby-Betrieb), 1=neue Messwerte
+{
+  unsigned int ret;
+
+  task_wait(&sensor_task, 1, 0);
+  do
+  {
+    ret = check_sensors();
+    status_service(); //Status-LED der Menues
+  } while((ret == 0) && ((sensor_task.state != 1) || (sensor_task.wait == 0))); //bis zur naechsten Abfrage nach SENSOR_POLL
+
+  return ret;
+}
+
+
+void show_data(void) //Daten anzeigen, nur bei Aenderung ueber das Totband (oder nach AUSGABE_MAX)
+{
+  if((features & FEATURE_USB) && output_changed(&out_serial, ~0U, 0))
+  {
+    Serial.print("c: ");           //CO2
+    Serial.println(co2_value);     //Wert in ppm
+    Serial.print("t: ");           //Temperatur
+    Serial.println(temp_value, 1); //Wert in °C
+    Serial.print("h: ");           //Humidity/Luftfeuchte
+    Serial.println(humi_value, 1); //Wert in %
+    Serial.print("l: ");           //Licht
+    Serial.println(light_value);
+    if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
+    {
+      Serial.print("p: ");         //Druck
+      Serial.println(pres_value);  //Wert in hPa
+      Serial.print("u: ");         //Temperatur
+      Serial.println(temp2_value); //Wert in °C
+    }
+    Serial.println();
+  }
+
+  if((features & FEATURE_SSD1306) && !display_busy() && output_changed(&out_display, (1<<VALUE_CO2), 0)) //Puffer nicht aendern solange gesendet wird
+  {
+    static unsigned int display_init=0;
+    char tmp[8];
+    if(display_init == 0) //Startbild loeschen
+    {
+      display_init = 1;
+      display.clearDisplay();
+    }
+    //ueberschreiben statt loeschen (Text mit Hintergrund), display() sendet dann nur geaenderte Spalten
+    sprintf(tmp, "%-4u", co2_value);
+    display.setTextColor(WHITE, BLACK);
+    display.setTextSize(5);
+    display.setCursor(5,5);
+    display.print(tmp);
+    display.setTextSize(1);
+    display.setCursor(5,56);
+    display.print("CO2 Level in ppm");
+    trace(TRACE_DISPLAY, 1);
+    display_send();
+    trace(TRACE_DISPLAY, 0);
+  }
+
+  return;
+}
+
+
+unsigned int display_busy(void) //1=Transfers laufen noch
+{
+  for(unsigned int i=0; i < (sizeof(display_xfer)/sizeof(display_xfer[0])); i++)
+  {
+    if(display_xfer[i].status == I2C_PENDING)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+void display_queue(I2CTransfer *t, const uint8_t *head, const uint8_t *data, unsigned int len)
+{
+  t->addr    = ADDR_SSD1306;
+  t->head    = head;
+  t->headLen = (head != NULL) ? 1 : 0;
+  t->tx      = data;
+  t->txLen   = len;
+  t->rx      = NULL;
+  t->rxLen   = 0;
+  i2c0.submit(t);
+
+  return;
+}
+
+
+void display_send(void) //geaenderte Fenster per Interrupt senden, wie display.display()
+{
+  uint8_t p0, p1, x0, x1, *cmd;
+  unsigned int n=0, w=0;
+
+  while(display.nextWindow(&p0, &p1, &x0, &x1)) //max. 8 Fenster mit zusammen max. 8 Pages
+  {
+    cmd = display_cmd[w++];
+    cmd[0] = 0x00; //Co=0, D/C=0
+    cmd[1] = SSD1306_PAGEADDR;
+    cmd[2] = p0;
+    cmd[3] = p1;
+    cmd[4] = SSD1306_COLUMNADDR;
+    cmd[5] = x0;
+    cmd[6] = x1;
+    display_queue(&display_xfer[n++], NULL, cmd, 7);
+    for(unsigned int p=p0; p <= p1; p++) //eine Page je Transfer
+    {
+      display_queue(&display_xfer[n++], &display_data, &display_buf[(p*128)+x0], x1-x0+1);
+    }
+  }
+
+  return;
+}
+
+
+void serial_service(void)
+{
+  static int calibration_done=0;
+  int i, cmd, val;
+  char tmp[32];
+
+  if((features & FEATURE_USB) == 0)
+  {
+    return;
+  }
+
+  if(Serial.available() == 0)
+  {
+    return;
+  }
+
+  cmd = Serial.read(); //Befehl
+  if((cmd != 'R') && (remote_on == 0))
+  {
+    return;
+  }
+
+  val = Serial.read(); //schreiben/lesen
+  if(val == '=') //=
+  {
+    switch(toupper(cmd))
+    {
+      case 'R': //Fernsteuerung
+        cmd = Serial.read();
+        if(cmd == '1') //ein
+        {
+          remote_on = 1;
+          buzzer(0); //Buzzer aus
+          ws2812.setBrightness(30); //0...255
+          leds(FARBE_VIOLETT); //LEDs violett
+          Serial.println("OK");
+        }
+        else if(cmd == '0') //aus
+        {
+          remote_on = 0;
+          calibration_done = 0;
+          ws2812.setBrightness(settings.brightness);
+          Serial.println("OK");
+        }
+        else if(cmd == 'R' && remote_on) //Reset
+        {
+          Serial.println("OK");
+          leds(0); //LEDs aus
+          Serial.flush();
+          Serial.end();
+          delay(20); //20ms warten
+          NVIC_SystemReset();
+          while(1);
+        }
+        break;
+
+      case 'S': //Save/Speichern
+        cmd = Serial.read();
+        if(cmd == '1')
+        {
+          settings.valid = true;
+          settings_save(); //Einstellungen speichern
+          Serial.println("OK");
+        }
+        break;
+
+      case 'H': //LED Helligkeit
+        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
+        if(i >= 0)
+        {
+          tmp[i] = 0;
+          sscanf(tmp, "%X", &val);
+          if(val < 0)
+          {
+            val = 0;
+          }
+          else if(val > 255)
+          {
+            val = 255;
+          }
+          settings.brightness = val;
+          ws2812.setBrightness(val);
+          leds_show();
+          Serial.println("OK");
+        }
+        break;
+
+      case 'L': //LED Farbe
+        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
+        if(i > 0)
+        {
+          tmp[i] = 0;
+          sscanf(tmp, "%X", &val);
+          leds(val);
+          Serial.println("OK");
+        }
+        break;
+
+      case 'B': //Buzzer
+        cmd = Serial.read();
+        if(cmd == '1')
+        {
+          buzzer(500); //500ms Buzzer an
+          settings.buzzer = 1;
+          Serial.println("OK");
+        }
+        else if(cmd == '0')
+        {
+          settings.buzzer = 0;
+          Serial.println("OK");
+        }
+        break;
+
+      case 'T': //Temperaturoffset
+        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
+        if(i > 0)
+        {
+          tmp[i] = 0;
+          sscanf(tmp, "%d", &val);
+          if((val >= 0) && (val <= 20))
+          {
+            temp_offset = val;
+            if(features & FEATURE_SCD30)
+            {
+              scd30.setTemperatureOffset(val); //Temperaturoffset
+              Serial.println("OK");
+            }
+            else if(features & FEATURE_SCD4X)
+            {
+              scd4x_start('T', val); //Temperaturoffset, Antwort in scd4x_service()
+            }
+          }
+        }
+        break;
+
+      case 'A': //Altitude/Hoehe ueber dem Meeresspiegel
+        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
+        if(i > 0)
+        {
+          tmp[i] = 0;
+          sscanf(tmp, "%d", &val);
+          if((val >= 0) && (val <= 3000))
+          {
+            if(features & FEATURE_SCD30)
+            {
+              scd30.setAltitudeCompensation(val); //Meter ueber dem Meeresspiegel
+              Serial.println("OK");
+            }
+            else if(features & FEATURE_SCD4X)
+            {
+              scd4x_start('A', val); //Meter ueber dem Meeresspiegel
+            }
+          }
+        }
+        break;
+
+      case 'C': //Calibration/Kalibrierung
+        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
+        if((i > 0) && (calibration_done == 0))
+        {
+          tmp[i] = 0;
+          sscanf(tmp, "%d", &val);
+          if((val > 0) && (val < 400))
+          {
+            val = 400;
+          }
+          if((val >= 400) || (val <= 2000))
+          {
+            calibration_done = 1;
+            if(features & FEATURE_SCD30)
+            {
+              scd30.setForcedRecalibrationFactor(val);
+              Serial.println("OK");
+            }
+            else if(features & FEATURE_SCD4X)
+            {
+              scd4x_start('C', val); //400ms Ausfuehrungszeit
+            }
+          }
+        }
+        break;
+
+      case '1': //Range/Bereich 1
+      case '2': //Range/Bereich 2
+      case '3': //Range/Bereich 3
+      case '4': //Range/Bereich 4
+      case '5': //Range/Bereich 5
+        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
+        if(i > 0)
+        {
+          tmp[i] = 0;
+          sscanf(tmp, "%d", &val);
+          if((val >= 400) && (val <= 10000))
+          {
+            settings.range[cmd-'1'] = val;
+            Serial.println("OK");
+          }
+        }
+        break;
+
+      case 'Y': //Hysterese der Bereiche 1-5
+        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
+        if(i > 0)
+        {
+          int h[5];
+          tmp[i] = 0;
+          if(sscanf(tmp, "%d,%d,%d,%d,%d", &h[0], &h[1], &h[2], &h[3], &h[4]) == 5)
+          {
+            for(i=0; (i < 5) && (h[i] >= 0) && (h[i] <= 500); i++);
+            if(i == 5)
+            {
+              for(i=0; i < 5; i++)
+              {
+                ampel_settings.hysterese[i] = h[i];
+              }
+              Serial.println("OK");
+            }
+          }
+        }
+        break;
+
+      case 'W': //Trendwarnung
+        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
+        if(i > 0)
+        {
+          tmp[i] = 0;
+          sscanf(tmp, "%d", &val);
+          if((val >= 0) && (val <= 60))
+          {
+            ampel_settings.warnung = val;
+            Serial.println("OK");
+          }
+        }
+        break;
+    }
+  }
+  else if(val == '?') //?
+  {
     switch(toupper(cmd))
     {
-      case 'R': //Fernsteuerung
-        cmd = Serial.read();
-        if(cmd == '1') //ein
-        {
-          remote_on = 1;
-          buzzer(0); //Buzzer aus
-          ws2812.setBrightness(30); //0...255
-          leds(FARBE_VIOLETT); //LEDs violett
-          Serial.println("OK");
-        }
-        else if(cmd == '0') //aus
-        {
-          remote_on = 0;
-          calibration_done = 0;
-          ws2812.setBrightness(settings.brightness);
-          Serial.println("OK");
-        }
-        else if(cmd == 'R' && remote_on) //Reset
-        {
-          Serial.println("OK");
-          leds(0); //LEDs aus
-          Serial.flush();
-          Serial.end();
-          delay(20); //20ms warten
-          NVIC_SystemReset();
-          while(1);
-        }
-        break;
+      case 'V': //Version
+        Serial.println(VERSION);
+        break;
+      case 'P': //Laufzeitmessung
+        profile_show();
+        break;
+      #if TRACE
+        case 'X': //Ablaufverfolgung
+          http_begin(&Serial, 1); //Ausgabe wie /trace, aber ohne HTTP-Header
+          http_trace();
+          http_end();
+          break;
+      #endif
+      case 'H': //LED Helligkeit
+        Serial.println(settings.brightness, HEX);
+        break;
+      case 'B': //Buzzer
+        Serial.println(settings.buzzer, DEC);
+        break;
+      case 'T': //Temperaturoffset
+        if(features & FEATURE_SCD30)
+        {
+          val = scd30.getTemperatureOffset();
+        }
+        else if(features & FEATURE_SCD4X)
+        {
+          scd4x_start('t', 0); //Antwort in scd4x_service()
+          break;
+        }
+        Serial.println(val, DEC);
+        break;
+      case 'A': //Altitude/Hoehe ueber dem Meeresspiegel
+        if(features & FEATURE_SCD30)
+        {
+          val = scd30.getAltitudeCompensation();
+        }
+        else if(features & FEATURE_SCD4X)
+        {
+          scd4x_start('a', 0);
+          break;
+        }
+        Serial.println(val, DEC);
+        break;
+      case '1': //Range/Bereich 1
+      case '2': //Range/Bereich 2
+      case '3': //Range/Bereich 3
+      case '4': //Range/Bereich 4
+      case '5': //Range/Bereich 5
+        Serial.println(settings.range[cmd-'1'], DEC);
+        break;
+      case 'Y': //Hysterese
+        for(i=0; i < 5; i++)
+        {
+          Serial.print(ampel_settings.hysterese[i], DEC);
+          Serial.print((i < 4) ? "," : "\n");
+        }
+        break;
+      case 'W': //Trendwarnung, Anstieg
+        Serial.print(ampel_settings.warnung, DEC);
+        Serial.print(",");
+        Serial.println((float)co2_trend/16, 1);
+        break;
+    }
+  }
+
+  return;
+}
+
+
+void http_begin(Print *client, unsigned int close) //Antwort an client beginnen, close: 0=Keep-Alive (Chunked)
+{
+  http_client = client;
+  http_len = 0;
+  http_chunk = 0;
+  http_close = close;
+
+  return;
+}
+
+
+void http_chunk_end(void) //Laenge des Chunks eintragen, leeren Chunk verwerfen
+{
+  static const char hex[] = "0123456789abcdef";
+  unsigned int n = http_len - http_chunk;
+
+  if(n == 0)
+  {
+    http_len = http_chunk - 5;
+  }
+  else
+  {
+    http_buf[http_chunk-5] = hex[(n>>8) & 0x0F]; //"xxx\r\n", max. 0xFFF
+    http_buf[http_chunk-4] = hex[(n>>4) & 0x0F];
+    http_buf[http_chunk-3] = hex[n & 0x0F];
+    http_buf[http_chunk-2] = '\r';
+    http_buf[http_chunk-1] = '\n';
+    http_buf[http_len++] = '\r';
+    http_buf[http_len++] = '\n';
+  }
+
+  return;
+}
+
+
+void http_flush(void) //Sendepuffer an client uebergeben
+{
+  if(http_chunk > 0)
+  {
+    http_chunk_end();
+  }
+  if(http_len > 0)
+  {
+    http_client->write((const uint8_t*)http_buf, http_len);
+    http_len = 0;
+  }
+  if(http_chunk > 0) //Platz fuer naechsten Chunk-Header
+  {
+    http_chunk = 5;
+    http_len = 5;
+  }
+
+  return;
+}
+
+
+void http_end(void) //Antwort abschliessen
+{
+  if(http_chunk > 0)
+  {
+    http_chunk_end();
+    http_chunk = 0;
+    memcpy(&http_buf[http_len], "0\r\n\r\n", 5); //letzter Chunk, Platz ist reserviert
+    http_len += 5;
+  }
+  http_flush();
+
+  return;
+}
+
+
+void http_write(const char *s) //Text direkt aus dem Flash in den Sendepuffer kopieren
+{
+  unsigned int size = (http_chunk > 0) ? (sizeof(http_buf)-7) : sizeof(http_buf); //Chunk: Platz fuer "\r\n0\r\n\r\n"
+
+  while(*s)
+  {
+    if(http_len >= size)
+    {
+      http_flush();
+    }
+    http_buf[http_len++] = *s++;
+  }
+
+  return;
+}
+
+
+void http_int(long value) //Ganzzahl ausgeben
+{
+  char tmp[12], *p = &tmp[sizeof(tmp)-1];
+  unsigned long v = (value < 0) ? -value : value;
+
+  *p = 0;
+  do
+  {
+    *--p = '0' + (v % 10);
+    v /= 10;
+  } while(v);
+  if(value < 0)
+  {
+    *--p = '-';
+  }
+  http_write(p);
+
+  return;
+}
+
+
+void http_tenth(long v) //Festkommawert in Zehnteln mit einer Nachkommastelle ausgeben
+{
+  char tmp[3] = { '.', 0, 0 };
+
+  if((v < 0) && (v > -10)) //-0.x
+  {
+    http_write("-");
+  }
+  http_int(v / 10);
+  tmp[1] = '0' + ((v < 0) ? -v : v) % 10;
+  http_write(tmp);
+
+  return;
+}
+
+
+void http_fixed(float value) //Festkomma mit einer Nachkommastelle ausgeben
+{
+  http_tenth((value < 0) ? (long)(value*10 - 0.5f) : (long)(value*10 + 0.5f));
+
+  return;
+}
+
+
+void http_hex(uint8_t value) //Byte zweistellig hexadezimal ausgeben
+{
+  static const char hex[] = "0123456789abcdef";
+  char tmp[3] = { hex[value>>4], hex[value&0x0F], 0 };
+
+  http_write(tmp);
+
+  return;
+}
+
+
+void http_header(const char *status, const char *type) //HTTP Header
+{
+  http_write("HTTP/1.1 ");
+  http_write(status);
+  http_write("\r\nContent-Type: ");
+  http_write(type);
+  if(http_close)
+  {
+    http_write("\r\nConnection: close\r\n\r\n");
+  }
+  else
+  {
+    http_write("\r\nTransfer-Encoding: chunked\r\n\r\n");
+    http_len += 5; //Platz fuer Chunk-Header
+    http_chunk = http_len;
+  }
+
+  return;
+}
+
+
+void http_json(void) //JSON
+{
+  http_header("200 OK", "application/json");
+  http_write("{\r\n \"c\": ");
+  http_int(co2_value);
+  http_write(",\r\n \"t\": ");
+  http_fixed(temp_value);
+  http_write(",\r\n \"h\": ");
+  http_fixed(humi_value);
+  if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
+  {
+    http_write(",\r\n \"p\": ");
+    http_fixed(pres_value);
+    http_write(",\r\n \"u\": ");
+    http_fixed(temp2_value);
+  }
+  http_write(",\r\n \"l\": ");
+  http_int(light_value);
+  http_write(",\r\n \"d\": ");
+  http_tenth((co2_trend*10)/16);
+  http_write("\r\n}\r\n");
+
+  return;
+}
+
+
+void http_cmk(void) //Checkmk Agent
+{
+  //CO2-Ampeln koennen so direkt ins Monitoring von checkmk.com 
+  //aufgenommen werden. Plugins sind nicht zwingend erforderlich.
+  //Da HTTP als Uebertragungsweg genutzt wird, "Data Source" 
+  //verwenden: wget -O - http://ip_address/cmk-agent
+  //Siehe: https://docs.checkmk.com/latest/de/datasource_programs.html
+  http_header("200 OK", "text/plain");
+  //Plaintext im von Checkmk erwarteten Format
+  //Siehe: https://docs.checkmk.com/latest/en/devel_check_plugins.html
+  http_write("<<<check_mk>>>\r\n" \
+             "AgentOS: arduino\r\n" \
+             //Check-Plugin fuer den Server erforderlich, um die Metriken auszuwerten 
+             "<<<watterott_co2ampel_plugin>>>\r\n" \
+             "co2 ");
+  http_int(co2_value);
+  http_write("\r\ntemp ");
+  http_fixed(temp_value);
+  http_write("\r\nhumidity ");
+  http_fixed(humi_value);
+  http_write("\r\nlighting ");
+  http_int(light_value);
+  if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
+  {
+    http_write("\r\npressure ");
+    http_fixed(pres_value);
+    http_write("\r\ntemp2 ");
+    http_fixed(temp2_value);
+  }
+  //Ad-hoc Check, der kein Server-Plugin benoetigt, nutzt Schwellwerte der Ampel.
+  //Achtung: Nur eine Zeile - der Checkmk-Server nimmt die Bewertung selbst an
+  //Hand der uebergebenen Schwellwerte vor. Die lesen wir hier aus der Ampel aus:
+  http_write("\r\n<<<local:sep(0)>>>\r\n" \
+             "P \"CO2 level (ppm)\" co2ppm=");
+  http_int(co2_value);
+  http_write(";");
+  http_int(settings.range[1]);
+  http_write(";");
+  http_int(settings.range[2]);
+  http_write(" CO2/ventilation control with Watterott CO2-Ampel, thresholds taken from sensor board.\r\n");
+
+  return;
+}
+
+
+void http_seconds(uint64_t us) //Mikrosekunden als Sekunden mit 6 Nachkommastellen ausgeben
+{
+  char tmp[8];
+  unsigned long frac = us % 1000000;
+
+  http_int((long)(us / 1000000));
+  tmp[0] = '.';
+  for(int i=6; i > 0; i--)
+  {
+    tmp[i] = '0' + (frac % 10);
+    frac /= 10;
+  }
+  tmp[7] = 0;
+  http_write(tmp);
+
+  return;
+}
+
+
+void http_metric(const char *name, const char *type, const char *help) //OpenMetrics: Beschreibung einer Metrik
+{
+  http_write("# TYPE ");
+  http_write(name);
+  http_write(" ");
+  http_write(type);
+  http_write("\n# HELP ");
+  http_write(name);
+  http_write(" ");
+  http_write(help);
+  http_write("\n");
+
+  return;
+}
+
+
+void http_metrics(void) //Prometheus/OpenMetrics, wird ohne Zwischenspeicher in Chunks gesendet
+{
+  unsigned long n;
+
+  //Siehe: https://github.com/OpenObservability/OpenMetrics/blob/main/specification/OpenMetrics.md
+  http_header("200 OK", "application/openmetrics-text; version=1.0.0; charset=utf-8");
+
+  http_metric("co2ampel_build", "info", "Firmware version");
+  http_write("co2ampel_build_info{version=\"" VERSION "\"} 1\n");
+  http_metric("co2ampel_uptime_seconds", "gauge", "Time since start");
+  http_write("co2ampel_uptime_seconds ");
+  http_int(uptime());
+  http_write("\n");
+
+  //Messwerte
+  http_metric("co2ampel_co2_ppm", "gauge", "CO2 concentration");
+  http_write("co2ampel_co2_ppm ");
+  http_int(co2_value);
+  http_write("\n");
+  http_metric("co2ampel_co2_average_ppm", "gauge", "CO2 average used for the traffic light");
+  http_write("co2ampel_co2_average_ppm ");
+  http_int(co2_average);
+  http_write("\n");
+  http_metric("co2ampel_co2_trend_ppm_per_minute", "gauge", "Smoothed rate of change of the CO2 average");
+  http_write("co2ampel_co2_trend_ppm_per_minute ");
+  http_tenth((co2_trend*10)/16);
+  http_write("\n");
+  http_metric("co2ampel_temperature_celsius", "gauge", "Temperature");
+  http_write("co2ampel_temperature_celsius ");
+  http_fixed(temp_value);
+  http_write("\n");
+  http_metric("co2ampel_humidity_percent", "gauge", "Relative humidity");
+  http_write("co2ampel_humidity_percent ");
+  http_fixed(humi_value);
+  http_write("\n");
+  if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
+  {
+    http_metric("co2ampel_pressure_hpa", "gauge", "Air pressure");
+    http_write("co2ampel_pressure_hpa ");
+    http_fixed(pres_value);
+    http_write("\n");
+  }
+  http_metric("co2ampel_light", "gauge", "Light sensor reading");
+  http_write("co2ampel_light ");
+  http_int(light_value);
+  http_write("\n");
+  http_metric("co2ampel_wifi_rssi_dbm", "gauge", "WiFi signal strength");
+  http_write("co2ampel_wifi_rssi_dbm ");
+  http_int(WiFi.RSSI());
+  http_write("\n");
+
+  //Histogramm: kumulierte Anzahl je Obergrenze
+  http_metric("co2ampel_loop_duration_seconds", "histogram", "Time between loop() runs");
+  n = 0;
+  for(unsigned int b=0; b < sizeof(loop_hist)/sizeof(loop_hist[0]); b++)
+  {
+    n += loop_hist[b];
+    http_write("co2ampel_loop_duration_seconds_bucket{le=\"");
+    if(b < sizeof(loop_bucket)/sizeof(loop_bucket[0]))
+    {
+      http_seconds(loop_bucket[b]);
+    }
+    else
+    {
+      http_write("+Inf");
+    }
+    http_write("\"} ");
+    http_int(n);
+    http_write("\n");
+  }
+  http_write("co2ampel_loop_duration_seconds_count ");
+  http_int(n);
+  http_write("\nco2ampel_loop_duration_seconds_sum ");
+  http_seconds(loop_hist_sum);
+  http_write("\n");
+
+  //Fehler- und Schreibzaehler
+  http_metric("co2ampel_sensor_errors", "counter", "Sensor read errors");
+  http_write("co2ampel_sensor_errors_total{sensor=\"co2\"} ");
+  http_int(err_co2);
+  http_write("\nco2ampel_sensor_errors_total{sensor=\"pressure\"} ");
+  http_int(err_pres);
+  http_write("\n");
+  http_metric("co2ampel_wifi_reconnects", "counter", "WiFi reconnects after a lost connection");
+  http_write("co2ampel_wifi_reconnects_total ");
+  http_int(wifi_reconnects);
+  http_write("\n");
+  http_metric("co2ampel_flash_writes", "counter", "Flash log records written since start");
+  http_write("co2ampel_flash_writes_total ");
+  http_int(flash_log.writes());
+  http_write("\n");
+  http_metric("co2ampel_flash_erases", "counter", "Flash log blocks erased since start");
+  http_write("co2ampel_flash_erases_total ");
+  http_int(flash_log.erases());
+  http_write("\n");
+
+  //RAM
+  http_metric("co2ampel_memory_free_bytes", "gauge", "Free RAM between heap and stack");
+  http_write("co2ampel_memory_free_bytes ");
+  http_int(mem_free());
+  http_write("\n");
+  http_metric("co2ampel_memory_headroom_bytes", "gauge", "Lowest free RAM since start (stack watermark)");
+  http_write("co2ampel_memory_headroom_bytes ");
+  http_int(mem_headroom());
+  http_write("\n# EOF\n");
+
+  return;
+}
+
+
+#if TRACE
+void http_trace(void) //Ringpuffer im Chrome Trace Event Format (chrome://tracing, Perfetto, speedscope)
+{
+  static const char *name[TRACE_NUM] = { "sensors", "leds", "display", "flash", "http", "mqtt", "winc_isr", "winc_send" };
+  unsigned int i = (trace_head + TRACE_ANZAHL - trace_count) % TRACE_ANZAHL, depth=0, first=1;
+  uint32_t t0 = trace_buf[i].t;
+
+  trace_pause = 1; //Senden erzeugt selbst Eintraege (WINC1500)
+  http_write("{\"traceEvents\":[");
+  for(unsigned int n=trace_count; n != 0; n--, i=(i+1)%TRACE_ANZAHL)
+  {
+    TRACE_EVENT *e = &trace_buf[i];
+    if(e->begin)
+    {
+      depth++;
+    }
+    else if(depth == 0) //Beginn wurde bereits ueberschrieben
+    {
+      continue;
+    }
+    else
+    {
+      depth--;
+    }
+    http_write(first ? "\n{\"name\":\"" : ",\n{\"name\":\"");
+    first = 0;
+    http_write(name[e->scope]);
+    http_write(e->begin ? "\",\"ph\":\"B\",\"ts\":" : "\",\"ph\":\"E\",\"ts\":");
+    http_int(e->t - t0); //us relativ zum aeltesten Eintrag
+    http_write(",\"pid\":1,\"tid\":1}");
+  }
+  http_write("\n]}\n");
+  trace_pause = 0;
+
+  return;
+}
+#endif
+
+
+#if HISTORY
+void http_history(unsigned int tier) //Messwertverlauf als CSV, aeltester Wert zuerst
+{
+  HISTORY_TIER *h = &history[tier];
+  unsigned int i = (h->head + h->size - h->count) % h->size;
+
+  http_header("200 OK", "text/csv");
+  http_write("s,c,t,h,p,l\r\n"); //Alter in s (leer = vor dem Neustart), CO2, Temperatur, Luftfeuchte, Druck, Licht
+  for(unsigned int n=h->count; n != 0; n--)
+  {
+    HISTORY_ENTRY *e = &h->entry[i];
+    if(n <= (h->count - h->restored)) //seit dem Neustart
+    {
+      http_int(-(long)(n*h->interval));
+    }
+    http_write(",");
+    http_int(e->co2);
+    http_write(",");
+    http_tenth(e->temp*5);
+    http_write(",");
+    http_tenth(e->humi*5);
+    http_write(",");
+    http_int(600 + e->pres*2);
+    http_write(",");
+    http_int(e->light*4);
+    http_write("\r\n");
+    i = (i+1) % h->size;
+  }
+
+  return;
+}
+#endif
+
+
+void http_html(void) //Webseite
+{
+  byte mac[6];
+
+  //HTTP Header+Daten
+  http_header("200 OK", "text/html");
+  http_write("<!DOCTYPE html>\r\n" \
+             "<html>\r\n" \
+             "<head>\r\n" \
+             "<meta charset=utf-8>\r\n" \
+             "<meta http-equiv=refresh content=120>\r\n" \
+             "<title>CO2-Ampel</title>\r\n" \
+             "<link rel=icon href=\"data:image/gif;base64,R0lGODlhAQABAAAAACwAAAAAAQABAAA=\">\r\n" \
+             "<style>\r\n" \
+             "body { font-size:1.0em; font-family:Lato,sans-serif; padding:10px; }\r\n" \
+             "#data { font-size:3.0em; }\r\n" \
+             "#wifi { font-size:1.0em; display:none; }\r\n" \
+             "#info { font-size:0.9em; }\r\n" \
+             "</style>\r\n" \
+             "<script>\r\n" \
+             "function wifi() {\r\n" \
+             "var box = document.getElementById('wifi');\r\n" \
+             "if(box.style.display != 'block') { box.style.display = 'block'; }\r\n" \
+             "else { box.style.display = 'none'; }\r\n" \
+             "}\r\n" \
+             "</script>\r\n" \
+             "</head>\r\n" \
+             "<body>\r\n");
+
+  http_write("<div id=data>\r\n" \
+             "CO2 (ppm): ");
+  http_int(co2_value);
+  http_write("<br/>\r\nTemperatur (&deg;C): ");
+  http_fixed(temp_value);
+  http_write("<br/>\r\nLuftfeuchte (% rel): ");
+  http_fixed(humi_value);
+  if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
+  {
+    http_write("<br/>\r\nDruck (hPa): ");
+    http_fixed(pres_value);
+    http_write("<br/>\r\nTemperatur (&deg;C): ");
+    http_fixed(temp2_value);
+  }
+  http_write("<br/>\r\n</div>\r\n");
+
+  String fv = WiFi.firmwareVersion();
+  WiFi.macAddress(mac);
+  http_write("<br/><br/>\r\n" \
+             "<a href='/json'>JSON</a> - ");
+  #if HISTORY
+    http_write("<a href='/history?s=2'>History</a> - ");
+  #endif
+  http_write("<a href='/cmk-agent'>Checkmk</a> - <a href='/metrics'>Metrics</a> - <a href='#' onclick='wifi();'>WiFi Login</a>\r\n" \
+             "<br/><br/>\r\n" \
+             "<div id=wifi>\r\n" \
+             "<form method=post>\r\n" \
+             "SSID <input name=1 size=30 maxlength=64 placeholder=SSID value='");
+  http_write(settings.wifi_ssid);
+  http_write("'><br/>\r\n" \
+             "Code <input name=2 size=30 maxlength=64 placeholder=Password value=''><br/>\r\n" \
+             "<input type=submit> (Neustart erforderlich, requires reboot)<br/>\r\n" \
+             "</form><br/>\r\n" \
+             "<div id=info>\r\n" \
+             "Firmware: v" VERSION ", \r\n" \
+             "WINC1500: ");
+  http_write(fv.c_str());
+  http_write(", \r\nMAC: ");
+  for(int i=5; i >= 0; i--)
+  {
+    http_hex(mac[i]);
+    if(i > 0)
+    {
+      http_write(":");
+    }
+  }
+  http_write("\r\n" \
+             "</div>\r\n" \
+             "</div>\r\n" \
+             "</body>\r\n" \
+             "</html>\r\n");
+
+  return;
+}
+
+
+void http_reset(HTTP_CONN *c) //auf naechste Anfrage warten
+{
+  c->state  = HTTP_METHOD;
+  c->close  = 0;
+  c->method = HTTP_OTHER;
+  c->length = 0;
+  c->pos    = 0;
+  c->path[0]  = 0;
+  c->query[0] = 0;
+  c->line[0]  = 0;
+  c->body   = 0;
+  c->field  = 0;
+  c->i      = 0;
+  c->hex    = 0;
+  c->form[0][0] = 0;
+  c->form[1][0] = 0;
+
+  return;
+}
+
+
+void http_append(char *dst, unsigned int size, unsigned int *pos, char ch) //Zeichen anhaengen, zu lange Texte werden abgeschnitten
+{
+  if(*pos < (size-1))
+  {
+    dst[(*pos)++] = ch;
+    dst[*pos] = 0;
+  }
+
+  return;
+}
+
+
+void http_form(HTTP_CONN *c, char ch) //POST-Daten (1=xxx&2=yyy) zeichenweise url-dekodieren
+{
+  if(c->hex > 0) //%xx
+  {
+    if(!isxdigit((uint8_t)ch))
+    {
+      c->hex = 0;
+      return;
+    }
+    c->esc = (c->esc << 4) | (isdigit(ch) ? (ch-'0') : ((ch|0x20)-'a'+10));
+    if(++c->hex <= 2)
+    {
+      return;
+    }
+    c->hex = 0;
+    ch = c->esc;
+  }
+  else if(ch == '%')
+  {
+    c->hex = 1;
+    c->esc = 0;
+    return;
+  }
+  else if(ch == '&') //naechstes Feld
+  {
+    c->field = 0;
+    c->i = 0;
+    return;
+  }
+  else if(ch == '+')
+  {
+    ch = ' ';
+  }
+
+  if(c->field == 0) //Feldname
+  {
+    if(ch == '=')
+    {
+      c->field = (c->i >= 1) && (c->i <= 2) ? c->i : 3; //nur 1 und 2 speichern
+      c->i = 0;
+    }
+    else
+    {
+      c->i = isdigit(ch) ? (c->i*10 + (ch-'0')) : 3;
+    }
+  }
+  else if(c->field <= 2)
+  {
+    http_append(c->form[c->field-1], sizeof(c->form[0]), &c->i, ch);
+  }
+
+  return;
+}
+
+
+unsigned int http_parse(HTTP_CONN *c, char ch) //Anfrage zeichenweise verarbeiten (beliebig segmentiert), 1=Anfrage vollstaendig
+{
+  switch(c->state)
+  {
+    case HTTP_BODY:
+      http_form(c, ch);
+      return (--c->length == 0);
+
+    case HTTP_METHOD:
+      if((ch == '\r') || (ch == '\n')) //Leerzeilen vor der Anfrage ignorieren
+      {
+        break;
+      }
+      if(ch != ' ')
+      {
+        http_append(c->line, sizeof(c->line), &c->pos, ch);
+        break;
+      }
+      c->method = (strcmp(c->line, "GET") == 0) ? HTTP_GET : (strcmp(c->line, "POST") == 0) ? HTTP_POST : HTTP_OTHER;
+      c->state = HTTP_PATH;
+      c->pos = 0;
+      break;
+
+    case HTTP_PATH:
+    case HTTP_QUERY:
+      if((ch == ' ') || (ch == '\r') || (ch == '\n'))
+      {
+        c->state = HTTP_VERSION;
+        c->pos = 0;
+        c->line[0] = 0;
+        if(ch == '\n') //HTTP/0.9 ohne Version
+        {
+          c->close = 1;
+          c->state = HTTP_HEADER;
+        }
+      }
+      else if((ch == '?') && (c->state == HTTP_PATH))
+      {
+        c->state = HTTP_QUERY;
+        c->pos = 0;
+      }
+      else if(c->state == HTTP_PATH)
+      {
+        http_append(c->path, sizeof(c->path), &c->pos, ch);
+      }
+      else
+      {
+        http_append(c->query, sizeof(c->query), &c->pos, ch);
+      }
+      break;
+
+    case HTTP_VERSION:
+      if(ch == '\r')
+      {
+        break;
+      }
+      if(ch != '\n')
+      {
+        http_append(c->line, sizeof(c->line), &c->pos, ch);
+        break;
+      }
+      if(strcmp(c->line, "HTTP/1.1") != 0) //HTTP/1.0: kein Keep-Alive
+      {
+        c->close = 1;
+      }
+      c->state = HTTP_HEADER;
+      c->pos = 0;
+      c->line[0] = 0;
+      break;
+
+    case HTTP_HEADER:
+      if(ch == '\r')
+      {
+        break;
+      }
+      if(ch != '\n')
+      {
+        http_append(c->line, sizeof(c->line), &c->pos, ch);
+        break;
+      }
+      if(c->pos == 0) //Leerzeile = Header zu Ende
+      {
+        if(c->length > 0)
+        {
+          c->state = HTTP_BODY;
+          c->body = 1;
+          break;
+        }
+        return 1;
+      }
+      if(strncasecmp(c->line, "Connection:", 11) == 0)
+      {
+        if(strcasestr(c->line+11, "close"))
+        {
+          c->close = 1;
+        }
+      }
+      else if(strncasecmp(c->line, "Content-Length:", 15) == 0)
+      {
+        c->length = atoi(c->line+15);
+      }
+      c->pos = 0;
+      c->line[0] = 0;
+      break;
+  }
+
+  return 0;
+}
+
+
+unsigned int http_query(HTTP_CONN *c, const char *name, unsigned int value) //Zahl aus den Parametern lesen, value=Standardwert
+{
+  unsigned int len = strlen(name);
+
+  for(char *q = c->query; q != NULL; q = strchr(q, '&'))
+  {
+    if(*q == '&')
+    {
+      q++;
+    }
+    if((strncmp(q, name, len) == 0) && (q[len] == '='))
+    {
+      return atoi(q+len+1);
+    }
+  }
+
+  return value;
+}
+
+
+void http_route_json(HTTP_CONN *c)
+{
+  http_json();
+
+  return;
+}
+
+
+void http_route_cmk(HTTP_CONN *c)
+{
+  http_cmk();
+
+  return;
+}
+
+
+void http_route_metrics(HTTP_CONN *c)
+{
+  http_metrics();
+
+  return;
+}
+
+
+#if TRACE
+void http_route_trace(HTTP_CONN *c)
+{
+  http_header("200 OK", "application/json");
+  http_trace();
+
+  return;
+}
+#endif
+
+
+#if HISTORY
+void http_route_history(HTTP_CONN *c) //Stufe mit ?s=1-3
+{
+  unsigned int tier = http_query(c, "s", 1);
+
+  http_history(((tier >= 1) && (tier <= 3)) ? (tier-1) : 0);
+
+  return;
+}
+#endif
+
+
+void http_route_ampel(HTTP_CONN *c) //Hysterese (?h1-h5=ppm) und Trendwarnung (?w=min) setzen und abfragen
+{
+  char name[3] = "h1";
+  unsigned int v, change=0;
+
+  for(unsigned int i=0; i < 5; i++)
+  {
+    name[1] = '1'+i;
+    v = http_query(c, name, ampel_settings.hysterese[i]);
+    if((v <= 500) && (v != ampel_settings.hysterese[i]))
+    {
+      ampel_settings.hysterese[i] = v;
+      change = 1;
+    }
+  }
+  v = http_query(c, "w", ampel_settings.warnung);
+  if((v <= 60) && (v != ampel_settings.warnung))
+  {
+    ampel_settings.warnung = v;
+    change = 1;
+  }
+  if(change)
+  {
+    settings_save(); //Einstellungen speichern
+  }
+
+  http_header("200 OK", "application/json");
+  http_write("{\r\n \"h\": [");
+  for(unsigned int i=0; i < 5; i++)
+  {
+    http_int(ampel_settings.hysterese[i]);
+    http_write((i < 4) ? ", " : "],\r\n \"w\": ");
+  }
+  http_int(ampel_settings.warnung);
+  http_write(",\r\n \"d\": ");
+  http_tenth((co2_trend*10)/16);
+  http_write(",\r\n \"a\": ");
+  #if AMPEL_DURCHSCHNITT > 0
+    http_int(ampel_level(co2_average));
+  #else
+    http_int(ampel_level(co2_value));
+  #endif
+  http_write("\r\n}\r\n");
+
+  return;
+}
+
+
+void http_route_html(HTTP_CONN *c)
+{
+  http_html();
+
+  return;
+}
+
+
+void http_route_settings(HTTP_CONN *c) //WiFi-Zugangsdaten aus dem Formular uebernehmen
+{
+  if(c->body && (strcmp(c->form[0], settings.wifi_ssid) || strcmp(c->form[1], settings.wifi_code)))
+  {
+    //todo: Leerzeichen am Ende entfernen
+    strcpy(settings.wifi_ssid, c->form[0]);
+    strcpy(settings.wifi_code, c->form[1]);
+    settings_save(); //Einstellungen speichern
+  }
+  http_html();
+
+  return;
+}
+
+
+void http_route_notfound(HTTP_CONN *c)
+{
+  http_header("404 Not Found", "text/plain");
+  http_write("404 Not Found\r\n");
+
+  return;
+}
+
+
+const HTTP_ROUTE http_routes[] =
+{
+  { HTTP_GET,  "/json",        http_route_json     },
+  { HTTP_GET,  "/cmk-agent",   http_route_cmk      },
+  { HTTP_GET,  "/metrics",     http_route_metrics  },
+  { HTTP_GET,  "/ampel",       http_route_ampel    },
+#if TRACE
+  { HTTP_GET,  "/trace",       http_route_trace    },
+#endif
+#if HISTORY
+  { HTTP_GET,  "/history",     http_route_history  },
+#endif
+  { HTTP_GET,  "/favicon.ico", http_route_notfound },
+  { HTTP_POST, "/",            http_route_settings },
+};
+
+
+void http_request(HTTP_CONN *c) //Anfrage ueber die Routing-Tabelle beantworten
+{
+  const HTTP_ROUTE *r;
+
+  http_begin(&c->client, c->close);
+  for(r = http_routes; r < &http_routes[sizeof(http_routes)/sizeof(http_routes[0])]; r++)
+  {
+    if((r->method == c->method) && (strcmp(r->path, c->path) == 0))
+    {
+      r->handler(c);
+      break;
+    }
+  }
+  if(r == &http_routes[sizeof(http_routes)/sizeof(http_routes[0])]) //kein Eintrag
+  {
+    if(c->method == HTTP_OTHER) //kein GET oder POST
+    {
+      http_header("400 Bad Request", "text/plain");
+      http_write("400 Bad Request\r\n");
+    }
+    else if(c->method == HTTP_POST) //Formular von einer anderen Seite
+    {
+      http_route_settings(c);
+    }
+    else //alle anderen Seiten: Webseite
+    {
+      http_html();
+    }
+  }
+  http_end();
+
+  return;
+}
+
+
+unsigned int http_busy(void) //1 = mindestens eine HTTP-Verbindung offen
+{
+  for(HTTP_CONN *c=http_conn; c < &http_conn[HTTP_CLIENTS]; c++)
+  {
+    if(c->state != HTTP_FREE)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+void webserver_service(void)
+{
+  static unsigned long t_check=0;
+  static unsigned int lost=0; //1 = Verbindung verloren, noch nicht wieder verbunden
+  unsigned int status;
+
+  if((features & FEATURE_WINC1500) == 0)
+  {
+    return;
+  }
+
+  status = WiFi.status();
+
+  if((status == WL_IDLE_STATUS) && (lost == 0)) //Verbindungsaufbau
+  {
+    return;
+  }
+  else if((status == WL_IDLE_STATUS) ||
+          (status == WL_CONNECT_FAILED) ||
+          (status == WL_CONNECTION_LOST) || 
+          (status == WL_DISCONNECTED)) //Verbindungsabbruch, Neuverbindung laeuft
+  {
+    lost = 1;
+    if((millis()-t_check) > (1*60000UL)) //1min
+    {
+      t_check = millis();
+      wifi_reconnect();
+    }
+    return;
+  }
 
-      case 'S': //Save/Speichern
-        cmd = Serial.read();
-        if(cmd == '1')
+  t_check = millis(); //Zeit speichern fuer Neuverbindung nach 1min
+  if(lost && (status == WL_CONNECTED)) //erfolgreiche Neuverbindung zaehlen, nicht die Versuche
+  {
+    lost = 0;
+    wifi_reconnects++;
+    server.begin(); //der Verbindungsabbruch hat alle Sockets geschlossen
+  }
+
+  //neue Verbindung einem freien Slot zuordnen
+  WiFiClient client = server.available();
+  if(client)
+  {
+    HTTP_CONN *c, *free_c=NULL;
+    for(c=http_conn; c < &http_conn[HTTP_CLIENTS]; c++)
+    {
+      if(c->state == HTTP_FREE)
+      {
+        if(free_c == NULL)
         {
-          settings.valid = true;
-          flash_settings.write(settings); //Einstellungen speichern
-          Serial.println("OK");
+          free_c = c;
         }
+      }
+      else if(c->client == client)
+      {
         break;
+      }
+    }
+    if(c == &http_conn[HTTP_CLIENTS]) //unbekannte Verbindung
+    {
+      if(free_c == NULL) //alle Slots belegt
+      {
+        client.stop();
+      }
+      else
+      {
+        free_c->client = client;
+        free_c->t_last = millis();
+        http_reset(free_c);
+      }
+    }
+  }
 
-      case 'H': //LED Helligkeit
-        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
-        if(i >= 0)
+  //alle Verbindungen reihum bedienen, ohne zu warten, max. eine Antwort pro Durchlauf (mehrere Seiten ueberschreiten LOOP_BUDGET)
+  unsigned int answered=0;
+  for(unsigned int k=0; (k < HTTP_CLIENTS) && (answered == 0); k++)
+  {
+    HTTP_CONN *c = &http_conn[(http_next+k) % HTTP_CLIENTS];
+    if(c->state == HTTP_FREE)
+    {
+      continue;
+    }
+    uint8_t buf[64];
+    int n = c->client.read(buf, sizeof(buf));
+    if(n > 0)
+    {
+      c->t_last = millis();
+      for(int i=0; (i < n) && (c->state != HTTP_FREE); i++)
+      {
+        if(http_parse(c, buf[i]))
         {
-          tmp[i] = 0;
-          sscanf(tmp, "%X", &val);
-          if(val < 0)
+          trace(TRACE_HTTP, 1);
+          http_request(c);
+          trace(TRACE_HTTP, 0);
+          answered = 1;
+          http_next = (http_next+k+1) % HTTP_CLIENTS; //im naechsten Durchlauf zuerst die folgende Verbindung
+          if(c->close)
           {
-            val = 0;
+            c->client.stop();
+            c->state = HTTP_FREE;
           }
-          else if(val > 255)
+          else
           {
-            val = 255;
+            http_reset(c);
           }
-          settings.brightness = val;
-          ws2812.setBrightness(val);
-          ws2812.show();
-          Serial.println("OK");
         }
-        break;
+      }
+    }
+    else if(!c->client.connected() || ((millis()-c->t_last) > (HTTP_TIMEOUT*1000UL))) //geschlossen oder Timeout
+    {
+      c->client.stop();
+      c->state = HTTP_FREE;
+    }
+  }
 
-      case 'L': //LED Farbe
-        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
-        if(i > 0)
-        {
-          tmp[i] = 0;
-          sscanf(tmp, "%X", &val);
-          leds(val);
-          Serial.println("OK");
-        }
-        break;
+  return;
+}
 
-      case 'B': //Buzzer
-        cmd = Serial.read();
-        if(cmd == '1')
-        {
-          buzzer(500); //500ms Buzzer an
-          settings.buzzer = 1;
-          Serial.println("OK");
-        }
-        else if(cmd == '0')
-        {
-          settings.buzzer = 0;
-          Serial.println("OK");
-        }
-        break;
 
-      case 'T': //Temperaturoffset
-        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
-        if(i > 0)
-        {
-          tmp[i] = 0;
-          sscanf(tmp, "%d", &val);
-          if((val >= 0) && (val <= 20))
-          {
-            temp_offset = val;
-            if(features & FEATURE_SCD30)
-            {
-              scd30.setTemperatureOffset(val); //Temperaturoffset
-              Serial.println("OK");
-            }
-            else if(features & FEATURE_SCD4X)
-            {
-              scd4x.stopPeriodicMeasurement();
-              delay(1000);
-              if(scd4x.setTemperatureOffset(val) == 0) //Temperaturoffset
-              {
-                Serial.println("OK");
-              }
-              else
-              {
-                Serial.println("ERROR");
-              }
-              delay(500);
-              scd4x.startPeriodicMeasurement();
-            }
-          }
-        }
-        break;
+#if MQTT
+void mqtt_sample(void) //Messwert bei Aenderung (max. alle MQTT_INTERVALL) oder Ampelwechsel in den Sendepuffer legen
+{
+  static OUTPUT_STATE out_mqtt;
+  static unsigned int level_last=~0U;
+  #if AMPEL_DURCHSCHNITT > 0
+    unsigned int level = ampel_level(co2_average);
+  #else
+    unsigned int level = ampel_level(co2_value);
+  #endif
 
-      case 'A': //Altitude/Hoehe ueber dem Meeresspiegel
-        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
-        if(i > 0)
-        {
-          tmp[i] = 0;
-          sscanf(tmp, "%d", &val);
-          if((val >= 0) && (val <= 3000))
-          {
-            if(features & FEATURE_SCD30)
-            {
-              scd30.setAltitudeCompensation(val); //Meter ueber dem Meeresspiegel
-              Serial.println("OK");
-            }
-            else if(features & FEATURE_SCD4X)
-            {
-              scd4x.stopPeriodicMeasurement();
-              delay(1000);
-              if(scd4x.setSensorAltitude(val) == 0) //Meter ueber dem Meeresspiegel
-              {
-                Serial.println("OK");
-              }
-              else
-              {
-                Serial.println("ERROR");
-              }
-              delay(500);
-              scd4x.startPeriodicMeasurement();
-            }
-          }
-        }
-        break;
+  if((features & FEATURE_WINC1500) == 0)
+  {
+    return;
+  }
+  if(level != level_last) //Ampelwechsel: sofort senden
+  {
+    out_mqtt.valid = 0;
+  }
+  if(output_changed(&out_mqtt, ~0U, MQTT_INTERVALL*1000UL) == 0)
+  {
+    return;
+  }
+  level_last = level;
+
+  MQTT_ENTRY *e = &mqtt_queue[mqtt_head];
+  e->t     = millis();
+  e->n     = ++mqtt_n;
+  e->co2   = co2_value;
+  e->temp  = (temp_value < 0) ? (int16_t)(temp_value*10 - 0.5f) : (int16_t)(temp_value*10 + 0.5f);
+  e->humi  = (uint16_t)(humi_value*10 + 0.5f);
+  e->pres  = (features & (FEATURE_LPS22HB|FEATURE_BMP280)) ? (uint16_t)(pres_value*10 + 0.5f) : 0;
+  e->light = light_value;
+  e->level = level;
+  mqtt_head = (mqtt_head + 1) % MQTT_PUFFER;
+  if(mqtt_count < MQTT_PUFFER)
+  {
+    mqtt_count++;
+  }
+  else if(mqtt_sent > 0) //aeltester Wert ueberschrieben
+  {
+    mqtt_sent--;
+  }
 
-      case 'C': //Calibration/Kalibrierung
-        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
-        if((i > 0) && (calibration_done == 0))
-        {
-          tmp[i] = 0;
-          sscanf(tmp, "%d", &val);
-          if((val > 0) && (val < 400))
-          {
-            val = 400;
-          }
-          if((val >= 400) || (val <= 2000))
-          {
-            calibration_done = 1;
-            if(features & FEATURE_SCD30)
-            {
-              scd30.setForcedRecalibrationFactor(val);
-              delay(500);
-            }
-            else if(features & FEATURE_SCD4X)
-            {
-              uint16_t corr;
-              scd4x.stopPeriodicMeasurement();
-              delay(1000);
-              scd4x.performForcedRecalibration(val, corr);
-              delay(1000);
-              scd4x.startPeriodicMeasurement();
-            }
-            Serial.println("OK");
-          }
-        }
-        break;
+  return;
+}
+
+
+#if MQTT_TLS
+unsigned long mqtt_tls_time(void) //Uhrzeit fuer die Pruefung des Server-Zertifikats
+{
+  return WiFi.getTime();
+}
+
+
+void mqtt_tls_begin(void) //TLS einrichten, Signatur und ECDH im ATECC608 oder in Software
+{
+  ArduinoBearSSL.onGetTime(mqtt_tls_time);
+  mqtt_tls.setSessionCache(&mqtt_tls_cache); //Wiederaufnahme der Sitzung beim Neuverbinden
+
+  #if MQTT_TLS_ATECC
+    if(ECCX08.begin() && ECCX08.locked()) //ATECC608 an Wire1 gefunden und konfiguriert
+    {
+      features |= FEATURE_ATECC608;
+      if(strlen(MQTT_TLS_CERT) > 0)
+      {
+        mqtt_tls.setEccSlot(MQTT_TLS_SLOT, MQTT_TLS_CERT);
+      }
+      mqtt_tls.setCryptoProvider(BearSSLClient::CryptoProvider::ECCX08);
+      return;
+    }
+  #endif
+
+  mqtt_tls.setCryptoProvider(BearSSLClient::CryptoProvider::Software); //Client-Zertifikat nur mit ATECC608
+
+  return;
+}
+#endif
+
+
+unsigned int mqtt_connect(void) //Verbindungsaufbau starten, weiter in mqtt_reconnect()
+{
+  byte mac[6];
+  char id[24];
+
+  WiFi.macAddress(mac); //MAC-Adresse abfragen
+  sprintf(id, "CO2AMPEL-%02X%02X%02X", mac[2], mac[1], mac[0]);
+  sprintf(mqtt_topic, "%s/%02X%02X%02X", MQTT_TOPIC, mac[2], mac[1], mac[0]);
+
+  mqtt.setId(id);
+  if(strlen(MQTT_USER) > 0)
+  {
+    mqtt.setUsernamePassword(MQTT_USER, MQTT_PASS);
+  }
+  mqtt.setKeepAliveInterval(MQTT_KEEPALIVE*1000UL);
+  mqtt.setConnectionTimeout(MQTT_TIMEOUT*1000UL);
+
+  if(features & FEATURE_USB)
+  {
+    Serial.println("MQTT connect...");
+  }
+
+  if(!WiFi.beginHostByName(MQTT_BROKER)) //Broker-Adresse aufloesen
+  {
+    return 1;
+  }
+  task_wait(&mqtt_task, 1, MQTT_TIMEOUT*1000UL);
+
+  return 0;
+}
+
+
+unsigned int mqtt_reconnect(void) //Verbindung zum Broker schrittweise aufbauen (DNS, TCP, CONNECT/CONNACK), 1 = Verbindungsaufbau laeuft
+{
+  static unsigned long t_retry=0, retry=0;
+  IPAddress ip;
+  int ret=0; //1 = verbunden, -1 = Fehler
+
+  if(((features & FEATURE_WINC1500) == 0) || (WiFi.status() != WL_CONNECTED))
+  {
+    task_stop(&mqtt_task);
+    return 0;
+  }
+
+  switch(mqtt_task.state)
+  {
+    case 0: //verbunden oder Wartezeit nach Fehler
+      if(mqtt.connected() || ((millis()-t_retry) < retry))
+      {
+        return 0;
+      }
+      #if MQTT_TLS
+      if(http_busy() || lora_pending()) //der TLS-Handshake blockiert, nicht bei offenen HTTP-Verbindungen oder LoRa-Empfangsfenstern
+      {
+        return 0;
+      }
+      #endif
+      t_retry = millis();
+      if(mqtt_connect() != 0)
+      {
+        ret = -1;
+      }
+      break;
+
+    case 1: //Broker-Adresse
+      if(WiFi.hostByNameResult(ip) == 0)
+      {
+        ret = task_ready(&mqtt_task) ? -1 : 0;
+      }
+      #if MQTT_TLS
+      else if(mqtt_tls.connect(ip, MQTT_PORT) && mqtt.beginConnect()) //TCP und TLS-Handshake blockieren (Schluesseltausch)
+      {
+        task_wait(&mqtt_task, 3, 0);
+      }
+      #else
+      else if(mqtt_net.beginConnect(ip, MQTT_PORT))
+      {
+        task_wait(&mqtt_task, 2, MQTT_TIMEOUT*1000UL);
+      }
+      #endif
+      else
+      {
+        ret = -1;
+      }
+      break;
 
-      case '1': //Range/Bereich 1
-      case '2': //Range/Bereich 2
-      case '3': //Range/Bereich 3
-      case '4': //Range/Bereich 4
-      case '5': //Range/Bereich 5
-        i = Serial.readBytesUntil('\n', tmp, sizeof(tmp));
-        if(i > 0)
-        {
-          tmp[i] = 0;
-          sscanf(tmp, "%d", &val);
-          if((val >= 400) && (val <= 10000))
-          {
-            settings.range[cmd-'1'] = val;
-            Serial.println("OK");
-          }
-        }
-        break;
-    }
+    case 2: //TCP-Verbindung
+      ret = mqtt_net.connectResult();
+      if(ret > 0)
+      {
+        ret = mqtt.beginConnect() ? 0 : -1; //CONNECT senden
+        task_wait(&mqtt_task, 3, 0);
+      }
+      else if((ret == 0) && task_ready(&mqtt_task))
+      {
+        ret = -1;
+      }
+      break;
+
+    case 3: //CONNACK, Wartezeit per setConnectionTimeout()
+      ret = mqtt.connectResult();
+      break;
   }
-  else if(val == '?') //?
+
+  if(ret < 0) //nach Fehlern mit wachsendem Abstand neu verbinden
   {
-    switch(toupper(cmd))
+    if(features & FEATURE_USB)
     {
-      case 'V': //Version
-        Serial.println(VERSION);
-        break;
-      case 'H': //LED Helligkeit
-        Serial.println(settings.brightness, HEX);
-        break;
-      case 'B': //Buzzer
-        Serial.println(settings.buzzer, DEC);
-        break;
-      case 'T': //Temperaturoffset
-        if(features & FEATURE_SCD30)
-        {
-          val = scd30.getTemperatureOffset();
-        }
-        else if(features & FEATURE_SCD4X)
-        {
-          float offset;
-          scd4x.stopPeriodicMeasurement();
-          delay(500);
-          scd4x.getTemperatureOffset(offset);
-          delay(500);
-          scd4x.startPeriodicMeasurement();
-          val = offset;
-        }
-        Serial.println(val, DEC);
-        break;
-      case 'A': //Altitude/Hoehe ueber dem Meeresspiegel
-        if(features & FEATURE_SCD30)
-        {
-          val = scd30.getAltitudeCompensation();
-        }
-        else if(features & FEATURE_SCD4X)
-        {
-          uint16_t alt;
-          scd4x.stopPeriodicMeasurement();
-          delay(500);
-          scd4x.getSensorAltitude(alt);
-          delay(500);
-          scd4x.startPeriodicMeasurement();
-          val = alt;
-        }
-        Serial.println(val, DEC);
-        break;
-      case '1': //Range/Bereich 1
-      case '2': //Range/Bereich 2
-      case '3': //Range/Bereich 3
-      case '4': //Range/Bereich 4
-      case '5': //Range/Bereich 5
-        Serial.println(settings.range[cmd-'1'], DEC);
-        break;
+      Serial.print("MQTT error: ");
+      Serial.println((mqtt_task.state == 3) ? mqtt.connectError() : MQTT_CONNECTION_REFUSED);
     }
+    mqtt.stop();
+    task_stop(&mqtt_task);
+    retry = (retry == 0) ? (MQTT_RETRY*1000UL) : min(retry*2, MQTT_RETRY*16000UL);
+  }
+  else if(ret > 0)
+  {
+    task_stop(&mqtt_task);
+    retry = 0;
+  }
+
+  return (mqtt_task.state != 0);
+}
+
+
+void mqtt_time(void) //Unix-Zeit einmalig vom WINC1500 (SNTP) holen, max. 1x pro Minute versuchen
+{
+  static unsigned long t_try=0;
+  static unsigned int tried=0;
+  unsigned long t;
+
+  if((mqtt_unix != 0) || (tried && ((millis()-t_try) < 60000UL)))
+  {
+    return;
+  }
+  tried = 1;
+  t_try = millis();
+  t = WiFi.getTime(); //0 = noch keine Zeit per SNTP
+  if(t != 0)
+  {
+    mqtt_unix = t;
+    mqtt_unix_ms = millis();
   }
 
   return;
 }
 
 
-void urldecode(char *src) //URL Parameter dekodieren
+void mqtt_service(void) //Verbindung halten und gepufferte Messwerte gesammelt senden, blockiert nicht (QoS 0)
 {
-  char a, b, *dst = src;
+  if(((features & FEATURE_WINC1500) == 0) || (WiFi.status() != WL_CONNECTED) || !mqtt.connected())
+  {
+    mqtt_sent = 0; //unbestaetigte Messwerte nach dem Neuverbinden erneut senden
+    return;
+  }
+
+  mqtt.poll(); //Keep-Alive (PINGREQ), eingehende Pakete verarbeiten
+  if(!mqtt.connected()) //kein PINGRESP nach 2x Keep-Alive
+  {
+    mqtt_sent = 0;
+    return;
+  }
+
+  //ohne PUBACK gilt eine Nachricht als angekommen, wenn die naechste gesendet wurde oder die Verbindung noch 2x Keep-Alive besteht
+  if((mqtt_sent > 0) && ((millis()-mqtt_t_sent) > (2*MQTT_KEEPALIVE*1000UL)))
+  {
+    mqtt_count -= mqtt_sent;
+    mqtt_sent = 0;
+  }
+
+  if(mqtt_count <= mqtt_sent)
+  {
+    return;
+  }
 
-  while(*src) 
+  mqtt_time();
+
+  //bis zu MQTT_BATCH Messwerte nach den unbestaetigten als JSON-Array, aeltester Wert zuerst
+  unsigned int i = (mqtt_head + MQTT_PUFFER - mqtt_count + mqtt_sent) % MQTT_PUFFER, n;
+  http_begin(NULL, 1); //Sendepuffer des Webservers nutzen, wird nicht an einen Client uebergeben
+  http_write("[");
+  for(n=0; (n < (mqtt_count-mqtt_sent)) && (n < MQTT_BATCH) && (http_len < (sizeof(http_buf)-100)); n++)
   {
-    if((*src == '%') && ((a = src[1]) && (b = src[2])) && (isxdigit((uint8_t)a) && isxdigit((uint8_t)b))) 
+    MQTT_ENTRY *e = &mqtt_queue[(i + n) % MQTT_PUFFER];
+    http_write((n == 0) ? "{\"n\":" : ",{\"n\":");
+    http_int(e->n);
+    if(mqtt_unix != 0) //aus dem festen Bezugspunkt, bei jeder Wiederholung gleich
+    {
+      http_write(",\"u\":");
+      http_int(mqtt_unix + (long)(e->t - mqtt_unix_ms)/1000L);
+    }
+    http_write(",\"s\":");
+    http_int(-(long)((millis()-e->t)/1000UL));
+    http_write(",\"c\":");
+    http_int(e->co2);
+    http_write(",\"t\":");
+    http_tenth(e->temp);
+    http_write(",\"h\":");
+    http_tenth(e->humi);
+    if(e->pres != 0)
     {
-      if (a >= 'a')
-        a -= 'a' - 'A';
+      http_write(",\"p\":");
+      http_tenth(e->pres);
+    }
+    http_write(",\"l\":");
+    http_int(e->light);
+    http_write(",\"a\":");
+    http_int(e->level);
+    http_write("}");
+  }
+  http_write("]");
 
-      if (a >= 'A')
-        a -= 'A' - 10;
-      else
-        a -= '0';
+  //QoS 0: endMessage() wartet nicht auf PUBACK, Messwerte bleiben bis zur Bestaetigung im Puffer
+  trace(TRACE_MQTT, 1);
+  if(mqtt.beginMessage(mqtt_topic, http_len, false, 0) &&
+     (mqtt.write((const uint8_t*)http_buf, http_len) == http_len) &&
+     mqtt.endMessage())
+  {
+    mqtt_count -= mqtt_sent; //vorherige Nachricht bestaetigt
+    mqtt_sent = n;
+    mqtt_t_sent = millis();
+  }
+  else
+  {
+    mqtt.stop(); //neu verbinden, Messwerte bleiben im Puffer
+    mqtt_sent = 0;
+  }
+  trace(TRACE_MQTT, 0);
+  http_len = 0;
 
-      if (b >= 'a')
-        b -= 'a' - 'A';
+  return;
+}
+#endif
 
-      if (b >= 'A')
-        b -= 'A' - 10;
-      else
-        b -= '0';
 
-      *dst++ = 16 * a + b;
-      src += 3;
+unsigned int lora_pending(void) //1 = Uplink und Empfangsfenster laufen, dann nichts Blockierendes (Messung, Display, Flash)
+{
+  #if LORA
+    if((features & FEATURE_RFM9X) && (LMIC.opmode & OP_TXRXPEND))
+    {
+      return 1;
     }
-    else if (*src == '+')
+  #endif
+
+  return 0;
+}
+
+
+#if LORA
+//Nutzdaten, 7 Bytes, Bits MSB zuerst:
+//  CO2 14 Bit (ppm), Temperatur 11 Bit ((°C+40)*10), Luftfeuchte 8 Bit (%*2),
+//  Druck 13 Bit ((hPa-300)*10, 0 = kein Drucksensor), Ampelstufe 3 Bit, 7 Bit frei (0)
+#define LORA_PAYLOAD 7
+
+void lora_bits(uint8_t *buf, unsigned int *pos, unsigned long value, unsigned int bits) //Wert bitweise anhaengen
+{
+  while(bits--)
+  {
+    if(value & (1UL<<bits))
     {
-      *dst++ = ' ';
-      src++;
+      buf[*pos/8] |= 0x80 >> (*pos%8);
     }
-    else
+    (*pos)++;
+  }
+
+  return;
+}
+
+
+unsigned long lora_clamp(float value, unsigned long max) //runden und auf 0-max begrenzen
+{
+  if(!(value > 0)) //auch NaN
+  {
+    return 0;
+  }
+  if(value >= max)
+  {
+    return max;
+  }
+
+  return (unsigned long)(value + 0.5f);
+}
+
+
+void lora_pack(uint8_t *buf, unsigned int level) //Messwerte in LORA_PAYLOAD Bytes packen
+{
+  unsigned int pos=0;
+
+  memset(buf, 0, LORA_PAYLOAD);
+  lora_bits(buf, &pos, min(co2_value, 16383U), 14);
+  lora_bits(buf, &pos, lora_clamp((temp_value+40)*10, 2047), 11);
+  lora_bits(buf, &pos, lora_clamp(humi_value*2, 255), 8);
+  if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
+  {
+    lora_bits(buf, &pos, max(lora_clamp((pres_value-300)*10, 8191), 1UL), 13);
+  }
+  else
+  {
+    lora_bits(buf, &pos, 0, 13);
+  }
+  lora_bits(buf, &pos, level, 3);
+
+  return;
+}
+
+
+void lora_init(void) //LMIC starten, ABP-Session und EU868-Kanaele wie in RFM9X_TTN
+{
+  pinMode(21, INPUT_PULLDOWN); //DIO0, Interrupt ist high-aktiv
+  pinMode(22, INPUT_PULLDOWN); //DIO1
+
+  os_init();
+  LMIC_reset();
+  LMIC_setSession(0x1, LORA_DEVADDR, lora_nwkskey, lora_appskey);
+  LMIC_setupChannel(0, 868100000, DR_RANGE_MAP(DR_SF12, DR_SF7),  BAND_CENTI);
+  LMIC_setupChannel(1, 868300000, DR_RANGE_MAP(DR_SF12, DR_SF7B), BAND_CENTI);
+  LMIC_setupChannel(2, 868500000, DR_RANGE_MAP(DR_SF12, DR_SF7),  BAND_CENTI);
+  LMIC_setupChannel(3, 867100000, DR_RANGE_MAP(DR_SF12, DR_SF7),  BAND_CENTI);
+  LMIC_setupChannel(4, 867300000, DR_RANGE_MAP(DR_SF12, DR_SF7),  BAND_CENTI);
+  LMIC_setupChannel(5, 867500000, DR_RANGE_MAP(DR_SF12, DR_SF7),  BAND_CENTI);
+  LMIC_setupChannel(6, 867700000, DR_RANGE_MAP(DR_SF12, DR_SF7),  BAND_CENTI);
+  LMIC_setupChannel(7, 867900000, DR_RANGE_MAP(DR_SF12, DR_SF7),  BAND_CENTI);
+  LMIC_setupChannel(8, 868800000, DR_RANGE_MAP(DR_FSK,  DR_FSK),  BAND_MILLI);
+  LMIC_setLinkCheckMode(0);
+  LMIC.dn2Dr = DR_SF9; //TTN RX2
+  LMIC_setDrTxpow(LORA_DR, 14);
+
+  return;
+}
+
+
+void lora_sample(void) //Uplink bei starker Aenderung oder Ampelwechsel, sonst nach LORA_INTERVALL_MAX, begrenzt durch das Sendezeit-Budget
+{
+  static unsigned long t_send=0, t_budget=0;
+  static unsigned int co2_last=0, level_last=~0U;
+  #if AMPEL_DURCHSCHNITT > 0
+    unsigned int level = ampel_level(co2_average);
+  #else
+    unsigned int level = ampel_level(co2_value);
+  #endif
+  unsigned long airtime, since;
+  uint8_t buf[LORA_PAYLOAD];
+
+  if((features & FEATURE_RFM9X) == 0)
+  {
+    return;
+  }
+
+  //Budget: LORA_AIRTIME pro Tag, ansparen fuer max. 3h
+  while((millis()-t_budget) >= 1000)
+  {
+    t_budget += 1000;
+    lora_budget = min(lora_budget + (LORA_AIRTIME*1000000UL/86400UL), LORA_AIRTIME*1000000UL/8);
+  }
+
+  if(LMIC.opmode & OP_TXRXPEND) //vorherige Nachricht noch nicht gesendet
+  {
+    return;
+  }
+  since = millis()-t_send;
+  if(since < (LORA_INTERVALL_MIN*1000UL))
+  {
+    return;
+  }
+  if((since < (LORA_INTERVALL_MAX*1000UL)) && (level == level_last) &&
+     (((co2_value > co2_last) ? (co2_value-co2_last) : (co2_last-co2_value)) < LORA_DELTA_CO2))
+  {
+    return;
+  }
+  airtime = osticks2us(calcAirTime(updr2rps(LMIC.datarate), LORA_PAYLOAD+13)); //+13 Bytes MHDR, FHDR, FPort, MIC
+  if(lora_budget < airtime)
+  {
+    return; //Budget aufgebraucht, spaeter senden
+  }
+
+  lora_pack(buf, level);
+  if(LMIC_setTxData2(LORA_PORT, buf, LORA_PAYLOAD, 0) == 0)
+  {
+    lora_budget -= airtime;
+    t_send = millis();
+    co2_last = co2_value;
+    level_last = level;
+  }
+
+  return;
+}
+
+
+void onEvent(ev_t ev) //LMIC-Ereignisse
+{
+  if(ev == EV_TXCOMPLETE)
+  {
+    lora_tx++;
+    if(features & FEATURE_USB)
     {
-      *dst++ = *src++;
+      Serial.print("LoRa TX ");
+      Serial.println(lora_tx);
     }
   }
-  *dst++ = '\0';
 
   return;
 }
 
 
-void webserver_service(void)
+//nur OTAA, nicht genutzt (ABP)
+void os_getArtEui(u1_t *buf) { }
+void os_getDevEui(u1_t *buf) { }
+void os_getDevKey(u1_t *buf) { }
+#endif
+
+
+#if LOW_POWER
+extern "C" void SysTick_DefaultHandler(void); //Core: millis()-Zaehler um 1ms weiterzaehlen
+
+
+void RTC_Handler(void) //Vergleichswert erreicht, weckt aus standby()
 {
-  static unsigned long t_check=0;
-  unsigned int status;
+  RTC->MODE0.INTFLAG.reg = RTC_MODE0_INTFLAG_CMP0;
+  rtc_wakeup = 1;
+
+  return;
+}
+
+
+void rtc_init(void) //RTC als 32-Bit-Zaehler mit 1024Hz aus OSCULP32K (GCLK2), laeuft im Standby weiter
+{
+  NVMCTRL->CTRLB.bit.SLEEPPRM = NVMCTRL_CTRLB_SLEEPPRM_DISABLED_Val; //Errata: Flash beim Aufwachen sofort bereit (sonst HardFault moeglich)
+
+  PM->APBAMASK.reg |= PM_APBAMASK_RTC;
+  GCLK->GENDIV.reg = GCLK_GENDIV_ID(2) | GCLK_GENDIV_DIV(4); //32768Hz / 2^(4+1) = 1024Hz
+  GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(2) | GCLK_GENCTRL_SRC_OSCULP32K | GCLK_GENCTRL_DIVSEL | GCLK_GENCTRL_GENEN | GCLK_GENCTRL_RUNSTDBY;
+  while(GCLK->STATUS.bit.SYNCBUSY);
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID_RTC | GCLK_CLKCTRL_GEN_GCLK2 | GCLK_CLKCTRL_CLKEN;
+  while(GCLK->STATUS.bit.SYNCBUSY);
+
+  RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_SWRST;
+  while(RTC->MODE0.CTRL.bit.SWRST);
+  RTC->MODE0.CTRL.reg = RTC_MODE0_CTRL_MODE_COUNT32 | RTC_MODE0_CTRL_PRESCALER_DIV1;
+  RTC->MODE0.CTRL.bit.ENABLE = 1;
+  while(RTC->MODE0.STATUS.bit.SYNCBUSY);
+  RTC->MODE0.INTENSET.reg = RTC_MODE0_INTENSET_CMP0;
+  NVIC_EnableIRQ(RTC_IRQn);
+
+  return;
+}
+
+
+uint32_t rtc_count(void) //RTC-Zaehler lesen (1024Hz)
+{
+  RTC->MODE0.READREQ.reg = RTC_READREQ_RREQ;
+  while(RTC->MODE0.STATUS.bit.SYNCBUSY);
+
+  return RTC->MODE0.COUNT.reg;
+}
+
+
+void standby(unsigned long ms) //MCU fuer ms (max. 9h) im STANDBY, Aufwecken durch den RTC, millis() wird nachgefuehrt
+{
+  uint32_t start, ticks=(ms*128UL)/125UL; //ms -> 1/1024s
+
+  i2c0.wait(); //Display-Transfers abschliessen
+  if(ticks < 10) //Vergleichswert muss nach der Synchronisation (max. 6 Takte) noch in der Zukunft liegen
+  {
+    ticks = 10;
+  }
+
+  rtc_wakeup = 0;
+  start = rtc_count();
+  RTC->MODE0.COMP[0].reg = start + ticks;
+  while(RTC->MODE0.STATUS.bit.SYNCBUSY);
+
+  SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk; //anstehender Tick wuerde sofort wecken
+  SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk; //STANDBY statt IDLE
+  while(rtc_wakeup == 0) //andere Interrupts wecken ebenfalls
+  {
+    __DSB();
+    __WFI();
+  }
+  SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+  //SysTick steht im Standby, der Tick-Zaehler des Cores ist nur ueber den Handler erreichbar (ca. 0.4us pro ms)
+  for(ms=((rtc_count()-start)*125UL)/128UL; ms != 0; ms--)
+  {
+    SysTick_DefaultHandler();
+  }
+  SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+
+  return;
+}
+
+
+void low_power_start(void) //in den Standby-Betrieb wechseln
+{
+  low_power_on = 1;
+
+  if(features & FEATURE_WINC1500)
+  {
+    WiFi.end(); //WINC1500 abschalten (Chip Enable aus)
+    features &= ~FEATURE_WINC1500;
+  }
+  scd4x.stopPeriodicMeasurement(); //Idle-Modus fuer Einzelmessungen
+  #if LOW_POWER_SCD4X
+    scd4x.powerDown();
+  #endif
+
+  status_led(0);
+  leds(FARBE_AUS);
+  if(features & FEATURE_SSD1306)
+  {
+    i2c0.wait();
+    display.ssd1306_command(SSD1306_DISPLAYOFF);
+  }
+
+  rtc_init();
+
+  return;
+}
+
+
+void low_power(void) //Standby-Betrieb: SCD4X Einzelmessung, Ampel kurz anzeigen, bis zur naechsten Messung schlafen
+{
+  unsigned long t=millis();
+
+  #if LOW_POWER_SCD4X
+    scd4x.wakeUp();
+  #endif
 
-  if((features & FEATURE_WINC1500) == 0)
+  if(USBDevice.connected()) //USB-Verbindung: zurueck in den Normalbetrieb (ohne WiFi)
   {
+    low_power_on = 0;
+    features |= FEATURE_USB;
+    scd4x.startPeriodicMeasurement();
+    if(features & FEATURE_SSD1306)
+    {
+      display.ssd1306_command(SSD1306_DISPLAYON);
+    }
     return;
   }
 
-  status = WiFi.status();
-
-  if(status == WL_IDLE_STATUS) //Verbindungsaufbau
+  //Messung, der Druck wird im Idle-Modus direkt gesetzt
+  if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
   {
-    return;
+    scd4x.setAmbientPressure(pres_last); //hPa=mBar
   }
-  else if((status == WL_CONNECT_FAILED) ||
-          (status == WL_CONNECTION_LOST) || 
-          (status == WL_DISCONNECTED)) //Verbindungsabbruch
+  #if LOW_POWER_SCD4X
+    uint16_t v_co2;
+    float v_temp, v_humi;
+    scd4x.beginMeasureSingleShot(); //erste Messung nach dem Aufwachen verwerfen
+    standby(5000);
+    scd4x.readMeasurement(v_co2, v_temp, v_humi);
+  #endif
+  scd4x.beginMeasureSingleShot();
+  standby(5000); //5s
+  if(check_sensors_wait())
   {
-    if((millis()-t_check) > (1*60000UL)) //1min
-    {
-      t_check = millis();
-      wifi_start();
-    }
-    return;
+    co2_average = co2_filter(co2_value);
+    trend_update(co2_average);
   }
+  else
+  {
+    err_co2++;
+  }
+  #if LOW_POWER_SCD4X
+    scd4x.powerDown();
+  #endif
 
-  t_check = millis(); //Zeit speichern fuer Neuverbindung nach 1min
+  #if LORA
+    lora_sample();
+    while((features & FEATURE_RFM9X) && (LMIC.opmode & OP_TXRXPEND)) //Senden und Empfangsfenster abwarten
+    {
+      os_runloop_once();
+    }
+  #endif
 
-  WiFiClient client = server.available();
-  if(!client) //Client nicht verbunden
+  if(buzzer_timer > LOW_POWER_INTERVALL)
   {
-    return;
+    buzzer_timer -= LOW_POWER_INTERVALL;
   }
-  //if(features & FEATURE_USB)
-  //{
-  //  Serial.println("WiFi client connected");
-  //}
-  boolean currentLineIsBlank=true;
-  unsigned int pos=0;
-  char buf[1024];
-  char req[2][64+1]; //HTTP request
-  req[0][0] = 0;
-  while(client.connected())
+  else
   {
-    if((millis()-t_check) > (5*1000UL)) //Stop nach 5s
+    buzzer_timer = 0;
+  }
+
+  //Anzeige, die WS2812 halten die Farbe auch im Standby
+  #if LOW_POWER_ANZEIGE > 0
+    #if AMPEL_DURCHSCHNITT > 0
+      unsigned int co2 = co2_average;
+    #else
+      unsigned int co2 = co2_value;
+    #endif
+    if(features & FEATURE_SSD1306)
     {
-      break;
+      display.ssd1306_command(SSD1306_DISPLAYON);
     }
-    if(client.available())
+    show_data();
+    ampel(co2);
+    buzzer(0); //PWM steht im Standby
+    if((co2 >= settings.range[4]) && (buzzer_timer == 0) && settings.buzzer)
     {
-      char c = client.read();
-      if(c == '\n' && currentLineIsBlank) //Header zu Ende
-      {
-        if(strncmp(req[0], "GET ", 4) && strncmp(req[0], "POST ", 5)) //kein GET oder POST
-        {
-          sprintf(buf, 
-              "HTTP/1.1 400 Bad Request\r\n" \
-              "Content-Type: text/plain\r\n" \
-              "Connection: close\r\n" \
-              "\r\n" \
-              "400 Bad Request\r\n"
-          );
-          client.print(buf);
-        }
-        else if(strncmp(req[0], "GET /json", 9) == 0) //JSON
-        {
-          if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
-          {
-            sprintf(buf,
-                "HTTP/1.1 200 OK\r\n" \
-                "Content-Type: application/json\r\n" \
-                "Connection: close\r\n" \
-                "\r\n" \
-                "{\r\n" \
-                " \"c\": %i,\r\n" \
-                " \"t\": %.1f,\r\n" \
-                " \"h\": %.1f,\r\n" \
-                " \"p\": %.1f,\r\n" \
-                " \"u\": %.1f,\r\n" \
-                " \"l\": %i\r\n" \
-                "}\r\n",
-                co2_value, temp_value, humi_value, pres_value, temp2_value, light_value
-            );
-          }
-          else
-          {
-            sprintf(buf,
-                "HTTP/1.1 200 OK\r\n" \
-                "Content-Type: application/json\r\n" \
-                "Connection: close\r\n" \
-                "\r\n" \
-                "{\r\n" \
-                " \"c\": %i,\r\n" \
-                " \"t\": %.1f,\r\n" \
-                " \"h\": %.1f,\r\n" \
-                " \"l\": %i\r\n" \
-                "}\r\n",
-                co2_value, temp_value, humi_value, light_value
-            );
-          }
-          client.print(buf);
-        }
-        else if(strncmp(req[0], "GET /cmk-agent", 14) == 0) //Checkmk Agent
-        {
-          //CO2-Ampeln koennen so direkt ins Monitoring von checkmk.com 
-          //aufgenommen werden. Plugins sind nicht zwingend erforderlich.
-          //Da HTTP als Uebertragungsweg genutzt wird, "Data Source" 
-          //verwenden: wget -O - http://ip_address/cmk-agent
-          //Siehe: https://docs.checkmk.com/latest/de/datasource_programs.html
-          if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
-          {
-            sprintf(buf,
-                "HTTP/1.1 200 OK\r\n" \
-                "Content-Type: text/plain\r\n" \
-                "Connection: close\r\n" \
-                "\r\n" \
-                //Plaintext im von Checkmk erwarteten Format
-                //Siehe: https://docs.checkmk.com/latest/en/devel_check_plugins.html
-                "<<<check_mk>>>\r\n" \
-                "AgentOS: arduino\r\n" \
-                //Check-Plugin fuer den Server erforderlich, um die Metriken auszuwerten 
-                "<<<watterott_co2ampel_plugin>>>\r\n" \
-                "co2 %i\r\n" \
-                "temp %.1f\r\n" \
-                "humidity %.1f\r\n" \
-                "lighting %i\r\n" \
-                "pressure %.1f\r\n" \
-                "temp2 %.1f\r\n" \
-                //Ad-hoc Check, der kein Server-Plugin benoetigt, nutzt Schwellwerte der Ampel.
-                //Achtung: Nur eine Zeile - der Checkmk-Server nimmt die Bewertung selbst an
-                //Hand der uebergebenen Schwellwerte vor. Die lesen wir hier aus der Ampel aus:
-                "<<<local:sep(0)>>>\r\n" \
-                "P \"CO2 level (ppm)\" co2ppm=%i;%i;%i CO2/ventilation control with Watterott CO2-Ampel, thresholds taken from sensor board.\r\n",
-                co2_value, temp_value, humi_value, light_value, pres_value, temp2_value,
-                co2_value, settings.range[1], settings.range[2]
-            );
-          }
-          else
-          {
-            sprintf(buf,
-                "HTTP/1.1 200 OK\r\n" \
-                "Content-Type: text/plain\r\n" \
-                "Connection: close\r\n" \
-                "\r\n" \
-                //Plaintext im von Checkmk erwarteten Format
-                //Siehe: https://docs.checkmk.com/latest/en/devel_check_plugins.html
-                "<<<check_mk>>>\r\n" \
-                "AgentOS: arduino\r\n" \
-                //Check-Plugin fuer den Server erforderlich, um die Metriken auszuwerten 
-                "<<<watterott_co2ampel_plugin>>>\r\n" \
-                "co2 %i\r\n" \
-                "temp %.1f\r\n" \
-                "humidity %.1f\r\n" \
-                "lighting %i\r\n" \
-                //Ad-hoc Check, der kein Server-Plugin benoetigt, nutzt Schwellwerte der Ampel.
-                //Achtung: Nur eine Zeile - der Checkmk-Server nimmt die Bewertung selbst an
-                //Hand der uebergebenen Schwellwerte vor. Die lesen wir hier aus der Ampel aus:
-                "<<<local:sep(0)>>>\r\n" \
-                "P \"CO2 level (ppm)\" co2ppm=%i;%i;%i CO2/ventilation control with Watterott CO2-Ampel, thresholds taken from sensor board.\r\n",
-                co2_value, temp_value, humi_value, light_value,
-                co2_value, settings.range[1], settings.range[2]
-            );
-          }
-          client.print(buf);
-        }
-        else if(strncmp(req[0], "GET /favicon", 12) == 0) //Favicon 
-        {
-          sprintf(buf, 
-              "HTTP/1.1 404 Not Found\r\n" \
-              "Content-Type: text/plain\r\n" \
-              "Connection: close\r\n" \
-              "\r\n" \
-              "404 Not Found\r\n"
-          );
-          client.print(buf);
-        }
-        else
-        {
-          //HTTP Post Daten verarbeiten
-          if((strncmp(req[0], "POST ", 5) == 0) && client.available())
-          {
-            req[0][0] = 0; //SSID
-            req[1][0] = 0; //Code
-            for(unsigned int r=0, i=0, last_c=0; client.available();)
-            {
-              c = client.read();
-              if(c == '&') //Aufbau: 1=xxx&2=yyy
-              {
-                r = 0;
-              }
-              else if((c == '=') && isdigit(last_c)) //1=xxx
-              {
-                r = last_c-'0';
-                i = 0;
-              }
-              else if((r > 0) && (r < 3)) //1 bis 2
-              {
-                req[r-1][i++] = c;
-                req[r-1][i] = 0;
-              }
-              last_c = c;
-            }
-            urldecode(req[0]); //Serial.println(req[0]);
-            urldecode(req[1]); //Serial.println(req[1]);
-            if(strcmp(req[0], settings.wifi_ssid) || strcmp(req[1], settings.wifi_code))
-            {
-              //todo: Leerzeichen am Ende entfernen
-              strcpy(settings.wifi_ssid, req[0]);
-              strcpy(settings.wifi_code, req[1]);
-              flash_settings.write(settings); //Einstellungen speichern
-            }
-          }
-          //HTTP Header+Daten
-          sprintf(buf,
-              "HTTP/1.1 200 OK\r\n" \
-              "Content-Type: text/html\r\n" \
-              "Connection: close\r\n" \
-              "\r\n"
-              "<!DOCTYPE html>\r\n" \
-              "<html>\r\n" \
-              "<head>\r\n" \
-              "<meta charset=utf-8>\r\n" \
-              "<meta http-equiv=refresh content=120>\r\n" \
-              "<title>CO2-Ampel</title>\r\n" \
-              "<link rel=icon href=\"data:image/gif;base64,R0lGODlhAQABAAAAACwAAAAAAQABAAA=\">\r\n" \
-              "<style>\r\n" \
-              "body { font-size:1.0em; font-family:Lato,sans-serif; padding:10px; }\r\n" \
-              "#data { font-size:3.0em; }\r\n" \
-              "#wifi { font-size:1.0em; display:none; }\r\n" \
-              "#info { font-size:0.9em; }\r\n" \
-              "</style>\r\n" \
-              "<script>\r\n" \
-              "function wifi() {\r\n" \
-              "var box = document.getElementById('wifi');\r\n" \
-              "if(box.style.display != 'block') { box.style.display = 'block'; }\r\n" \
-              "else { box.style.display = 'none'; }\r\n" \
-              "}\r\n" \
-              "</script>\r\n" \
-              "</head>\r\n" \
-              "<body>\r\n"
-          );
-          client.print(buf);
-
-          if(features & (FEATURE_LPS22HB|FEATURE_BMP280))
-          {
-            sprintf(buf,
-                "<div id=data>\r\n" \
-                "CO2 (ppm): %i<br/>\r\n" \
-                "Temperatur (&deg;C): %.1f<br/>\r\n" \
-                "Luftfeuchte (% rel): %.1f<br/>\r\n" \
-                "Druck (hPa): %.1f<br/>\r\n" \
-                "Temperatur (&deg;C): %.1f<br/>\r\n" \
-                "</div>\r\n",
-                co2_value, temp_value, humi_value, pres_value, temp2_value
-            );
-          }
-          else
-          {
-            sprintf(buf,
-                "<div id=data>\r\n" \
-                "CO2 (ppm): %i<br/>\r\n" \
-                "Temperatur (&deg;C): %.1f<br/>\r\n" \
-                "Luftfeuchte (% rel): %.1f<br/>\r\n" \
-                "</div>\r\n",
-                co2_value, temp_value, humi_value
-            );
-          }
-          client.print(buf);
-
-          String fv = WiFi.firmwareVersion();
-          byte mac[6];
-          WiFi.macAddress(mac);
-          sprintf(buf,
-              "<br/><br/>\r\n" \
-              "<a href='/json'>JSON</a> - <a href='/cmk-agent'>Checkmk</a> - <a href='#' onclick='wifi();'>WiFi Login</a>\r\n" \
-              "<br/><br/>\r\n" \
-              "<div id=wifi>\r\n" \
-              "<form method=post>\r\n" \
-              "SSID <input name=1 size=30 maxlength=64 placeholder=SSID value='%s'><br/>\r\n" \
-              "Code <input name=2 size=30 maxlength=64 placeholder=Password value=''><br/>\r\n" \
-              "<input type=submit> (Neustart erforderlich, requires reboot)<br/>\r\n" \
-              "</form><br/>\r\n" \
-              "<div id=info>\r\n" \
-              "Firmware: v" VERSION ", \r\n" \
-              "WINC1500: %s, \r\n" \
-              "MAC: %02x:%02x:%02x:%02x:%02x:%02x\r\n" \
-              "</div>\r\n" \
-              "</div>\r\n" \
-              "</body>\r\n" \
-              "</html>\r\n",
-              settings.wifi_ssid, /*settings.wifi_code, */ fv.c_str(), 
-              mac[5], mac[4], mac[3], mac[2], mac[1], mac[0]
-          );
-          client.print(buf);
-        }
-        break;
-      }
-      else //save request
-      {
-        if(pos < (sizeof(req[0])-1))
-        {
-          req[0][pos++] = c;
-          req[0][pos] = 0;
-        }
-      }
-      if(c == '\n')
-      {
-        currentLineIsBlank = true;
-      }
-      else if(c != '\r')
-      {
-        currentLineIsBlank = false;
-      }
+      buzzer(500); //500ms
     }
-  }
+    standby(LOW_POWER_ANZEIGE*1000UL);
+    leds(FARBE_AUS);
+    if(features & FEATURE_SSD1306)
+    {
+      display.ssd1306_command(SSD1306_DISPLAYOFF);
+    }
+  #endif
 
-  delay(20); //20ms warten zum Senden
-  client.stop();
+  t = millis()-t;
+  standby((t < (LOW_POWER_INTERVALL*1000UL)) ? ((LOW_POWER_INTERVALL*1000UL)-t) : 0);
 
   return;
 }
+#endif
 
 
-int check_i2c(Sercom *sercom, byte addr) //1=okay
+int check_i2c(I2CQueue &bus, byte addr) //1=okay
 {
-  int res = 0;
-
-  for(int t=3; (t!=0) && (res==0); t--) //try 3 times
+  for(int t=3; t!=0; t--) //try 3 times
   {
-    sercom->I2CM.CTRLA.bit.ENABLE = 1; //enable master mode
-    delay(10); //wait 10ms
-    sercom->I2CM.ADDR.bit.ADDR = (addr<<1) | 0x00; //start transfer
-    delay(10); //wait 10ms
-    if(sercom->I2CM.INTFLAG.bit.MB || sercom->I2CM.INTFLAG.bit.SB) //data transmitted
+    if(bus.probe(addr)) //ack received
     {
-      if(!sercom->I2CM.STATUS.bit.RXNACK) //ack received
-      {
-        res = 1; //ok
-        break;
-      }
+      return 1; //ok
     }
+    delay(10); //wait 10ms
   }
 
-  /*
-  if(res == 0)
-  {
-    if(sercom == SERCOM1)
-    {
-      Wire.beginTransmission(addr);
-      if(Wire.endTransmission() == 0)
-      {
-        res = 1; //ok
-      }
-    }
-    else if(sercom == SERCOM2)
-    {
-      Wire1.beginTransmission(addr);
-      if(Wire1.endTransmission() == 0)
-      {
-        res = 1; //ok
-      }
-    }
-  }
-  */
+  return 0;
+}
+
+
+int check_rfm9x(void) //1=okay
+{
+  byte version;
+
+  SPI.begin();
+  SPI.beginTransaction(SPISettings(1000000, MSBFIRST, SPI_MODE0));
+  digitalWrite(20, LOW); //RFM9X CS low/active
+  SPI.transfer(0x42); //0x42 = version
+  version = SPI.transfer(0x00);
+  digitalWrite(20, HIGH); //RFM9X CS high
+  SPI.endTransaction();
 
-  return res;
+  return (version == 0x12);
 }
 
 
@@ -1115,15 +3709,7 @@ void self_test(void) //Testprogramm
 
   //RFM9X-Test
   #if PRO_AMPEL
-    SPI.begin();
-    SPI.setDataMode(SPI_MODE0);
-    SPI.setBitOrder(MSBFIRST);
-    SPI.setClockDivider(SPI_CLOCK_DIV128);
-    digitalWrite(20, LOW); //RFM9X CS low/active
-    SPI.transfer(0x42); //0x42 = version
-    byte i = SPI.transfer(0x00);
-    digitalWrite(20, HIGH); //RFM9X CS high
-    if(i == 0x12) //check version
+    if(check_rfm9x()) //check version
     {
       leds(FARBE_WEISS); //LEDs weiss
       buzzer(1000); //1s Buzzer an
@@ -1163,7 +3749,7 @@ void self_test(void) //Testprogramm
       ws2812.setPixelColor(0, FARBE_AUS);
     }
 
-    if(check_sensors())
+    if(check_sensors_wait())
     {
       co2  = co2_sensor();
       temp = temp_sensor();
@@ -1207,7 +3793,7 @@ void self_test(void) //Testprogramm
       show_data();
     }
 
-    ws2812.show();
+    leds_show();
   }
   
   delay(2000); //2s warten
@@ -1221,7 +3807,7 @@ void air_test(void) //Frischluft-Test
   unsigned int co2;
 
   ws2812.fill(FARBE_WEISS, 0, 4); //LEDs weiss
-  ws2812.show();
+  leds_show();
 
   while(1)
   {
@@ -1232,7 +3818,7 @@ void air_test(void) //Frischluft-Test
 
     status_led(200); //Status-LED
 
-    if(check_sensors())
+    if(check_sensors_wait())
     {
       co2 = co2_sensor();
 
@@ -1256,7 +3842,7 @@ void air_test(void) //Frischluft-Test
       {
         ws2812.fill(FARBE_ROT, 0, NUM_LEDS); //rot
       }
-      ws2812.show();
+      leds_show();
 
       show_data();
     }
@@ -1283,7 +3869,7 @@ unsigned int select_value(unsigned int value, unsigned int min, unsigned int max
   {
     ws2812.fill(color, 0, value);
   }
-  ws2812.show();
+  leds_show();
 
   for(sw=0, timeout=0; timeout<1000; timeout++) //10s Timeout
   {
@@ -1322,7 +3908,7 @@ unsigned int select_value(unsigned int value, unsigned int min, unsigned int max
         {
           ws2812.fill(color, 0, value);
         }
-        ws2812.show();
+        leds_show();
       }
       sw = 0;
     }
@@ -1411,7 +3997,7 @@ void altitude_toffset(void) //Altitude und Temperaturoffset
   }
 
   //Ende
-  flash_settings.write(settings); //Einstellungen speichern
+  settings_save(); //Einstellungen speichern
   leds(FARBE_BLAU);//LEDs blau
   buzzer(250); //250ms Buzzer an
 
@@ -1428,7 +4014,7 @@ void calibration(void) //Kalibrierung
   //scd30.setMeasurementInterval(INTERVALL); //setze Messintervall
 
   ws2812.fill(FARBE_WEISS, 0, 4); //LEDs weiss
-  ws2812.show();
+  leds_show();
 
   if(features & FEATURE_SCD4X)
   {
@@ -1493,7 +4079,7 @@ void calibration(void) //Kalibrierung
     
     status_led(200); //Status-LED
     
-    if(check_sensors())
+    if(check_sensors_wait())
     {
       co2 = co2_sensor();
       if((co2 >= 200) && (co2 <= 800) && 
@@ -1530,7 +4116,7 @@ void calibration(void) //Kalibrierung
       {
         ws2812.fill(FARBE_ROT, 2, 2); //rot
       }
-      ws2812.show();
+      leds_show();
 
       if(features & FEATURE_USB)
       {
@@ -1681,7 +4267,7 @@ unsigned int wifi_start(void)
     {
       break;
     }
-    status_led(1000); //Status-LED
+    status_wait(1000); //Status-LED
   }
 
   if(!(WiFi.status() == WL_CONNECTED)) //Verbindung fehlgeschlagen
@@ -1695,6 +4281,32 @@ unsigned int wifi_start(void)
 }
 
 
+void wifi_reconnect(void) //Neuverbindung starten, wartet nicht: WiFi.status() bleibt WL_IDLE_STATUS bis zur Verbindung
+{
+  if(settings.wifi_ssid[0] == 0) //keine Logindaten
+  {
+    return;
+  }
+
+  if(features & FEATURE_USB)
+  {
+    Serial.println("WiFi reconnect...");
+  }
+
+  WiFi.setTimeout(0); //begin() kehrt sofort zurueck
+  if(strlen(settings.wifi_code) > 0) //Passwort
+  {
+    WiFi.begin(settings.wifi_ssid, settings.wifi_code);
+  }
+  else
+  {
+    WiFi.begin(settings.wifi_ssid);
+  }
+
+  return;
+}
+
+
 void reset_mcu(void)
 {
   if(features & FEATURE_USB)
@@ -1721,6 +4333,8 @@ void reset_mcu(void)
     scd4x.stopPeriodicMeasurement();
   }
 
+  i2c0.end();
+  i2c1.end();
   Wire.end();
   Wire1.end();
   Serial.end();
@@ -1735,6 +4349,8 @@ void setup()
 {
   int run_menu=0;
 
+  mem_paint(); //freien RAM markieren (Stack-Wasserzeichen fuer /metrics)
+
   //setze Pins
   pinMode(6, INPUT_PULLUP); //PA08 SDA1
   pinMode(7, INPUT_PULLUP); //PA09 SCL1
@@ -1762,16 +4378,21 @@ void setup()
 
   //WS2812
   ws2812.begin();
+  #if LEDS_DMA
+    ws2812.setDMA(SERCOM3, 0, PIO_SERCOM); //PA22 = SERCOM3/PAD[0]
+  #endif
   ws2812.setBrightness(HELLIGKEIT); //0...255
   ws2812.fill(FARBE_AUS, 0, NUM_LEDS); //LEDs aus
   ws2812.fill(ws2812.Color(20,20,20), 0, 4); //4 LEDs weiss
-  ws2812.show();
+  leds_show();
 
   //Wire/I2C
   Wire.begin();
   Wire.setClock(50000); //50kHz, empfohlen fuer SCD30
   Wire1.begin();
   Wire1.setClock(100000); //100kHz ATECC+LPS22HB+BMP280
+  i2c0.begin();
+  i2c1.begin();
 
   //serielle Schnittstelle (USB)
   Serial.begin(BAUDRATE); //seriellen Port starten
@@ -1789,7 +4410,7 @@ void setup()
   #endif
 
   //LPS22HB
-  if(check_i2c(SERCOM2, ADDR_LPS22HB)) //LPS22HB gefunden
+  if(check_i2c(i2c1, ADDR_LPS22HB)) //LPS22HB gefunden
   {
     if(lps22.begin())
     {
@@ -1798,14 +4419,14 @@ void setup()
   }
 
   //BMP280
-  if(check_i2c(SERCOM2, ADDR_BMP280)) //BMP280 gefunden
+  if(check_i2c(i2c1, ADDR_BMP280)) //BMP280 gefunden
   {
     if(bmp280.begin(ADDR_BMP280))
     {
       features |= FEATURE_BMP280;
     }
   }
-  else if(check_i2c(SERCOM2, ADDR_BMP280+1)) //BMP280 gefunden
+  else if(check_i2c(i2c1, ADDR_BMP280+1)) //BMP280 gefunden
   {
     if(bmp280.begin(ADDR_BMP280+1))
     {
@@ -1814,11 +4435,12 @@ void setup()
   }
 
   //SSD1306
-  if(check_i2c(SERCOM0, ADDR_SSD1306)) //SSD1306 gefunden
+  if(check_i2c(i2c0, ADDR_SSD1306)) //SSD1306 gefunden
   {
     features |= FEATURE_SSD1306;
     delay(500); //500ms warten
     display.begin(SSD1306_SWITCHCAPVCC, ADDR_SSD1306);
+    display_buf = display.getBuffer();
     display.clearDisplay();
     display.setTextColor(WHITE, BLACK);
     display.setTextSize(3);
@@ -1835,7 +4457,7 @@ void setup()
   }
 
   //SCD30+SCD4X
-  if(check_i2c(SERCOM0, ADDR_SCD30)) //SCD30 gefunden
+  if(check_i2c(i2c0, ADDR_SCD30)) //SCD30 gefunden
   {
     for(int t=5; t!=0; t--) //try 5 times
     {
@@ -1845,12 +4467,12 @@ void setup()
         features |= FEATURE_SCD30;
         break;
       }
-      status_led(1000); //Status-LED
+      status_wait(1000); //Status-LED
     }
     scd30.setMeasurementInterval(INTERVALL); //setze Messintervall
     //scd30.setAmbientPressure(1000); //0 oder 700-1400, Luftdruck in hPa
   }
-  if(check_i2c(SERCOM0, ADDR_SCD4X)) //SCD4X gefunden
+  if(check_i2c(i2c0, ADDR_SCD4X)) //SCD4X gefunden
   {
     for(int t=5; t!=0; t--) //try 5 times
     {
@@ -1863,10 +4485,24 @@ void setup()
         features |= FEATURE_SCD4X;
         break;
       }
-      status_led(1000); //Status-LED
+      status_wait(1000); //Status-LED
     }
   }
 
+  //RFM9X (LoRaWAN)
+  #if LORA
+    if(check_rfm9x()) //RFM9X gefunden
+    {
+      features |= FEATURE_RFM9X;
+      lora_init();
+    }
+  #endif
+
+  //ATECC608 (TLS fuer MQTT)
+  #if MQTT && MQTT_TLS
+    mqtt_tls_begin();
+  #endif
+
   //Temperaturoffset
   if(features & FEATURE_SCD30)
   {
@@ -1890,7 +4526,23 @@ void setup()
   }
 
   //Einstellungen
-  settings = flash_settings.read(); //Einstellungen lesen
+  flash_log.begin();
+  if((flash_log.read(LOG_AMPEL, &ampel_settings, sizeof(ampel_settings)) == false) || (ampel_settings.warnung > 60)) //vor dem ersten settings_save()
+  {
+    for(unsigned int i=0; i < 5; i++)
+    {
+      ampel_settings.hysterese[i] = AMPEL_HYSTERESE;
+    }
+    ampel_settings.warnung = TREND_WARNUNG;
+  }
+  if(flash_log.read(LOG_SETTINGS, &settings, sizeof(settings)) == false) //Einstellungen lesen
+  {
+    settings = flash_settings.read(); //aeltere Firmware: Einstellungen vom alten Speicherort uebernehmen
+    if(settings.valid == true)
+    {
+      settings_save();
+    }
+  }
   if((settings.valid == false) || (settings.brightness > 255) || (settings.range[0] < 100))
   {
     settings.brightness   = HELLIGKEIT;
@@ -1909,7 +4561,7 @@ void setup()
     settings.ip_gw        = IPAddress(WIFI_GW);
     settings.ip_dns       = IPAddress(WIFI_DNS);
     settings.valid        = true;
-    flash_settings.write(settings);
+    settings_save();
     //Standard Temperaturoffset
     if(features & FEATURE_WINC1500)
     {
@@ -1938,15 +4590,22 @@ void setup()
     else if(features & FEATURE_SCD4X)
     {
       float offset;
+      scd4x.stopPeriodicMeasurement(); //Einstellungen nur im Idle-Modus
       scd4x.getTemperatureOffset(offset);
       if((offset == 0) || (offset > 12))
       {
         scd4x.setTemperatureOffset(temp_offset); //Temperaturoffset
       }
+      scd4x.startPeriodicMeasurement();
     }
   }
   ws2812.setBrightness(settings.brightness); //0...255
 
+  //Messwertverlauf aus Flash-Log
+  #if HISTORY && HISTORY_FLASH
+    history_restore();
+  #endif
+
   //USB-Verbindung
   if(USBDevice.connected()) //(Serial) nutzt Flow-Control zur Erkennung
   {
@@ -1960,6 +4619,8 @@ void setup()
     if(features & FEATURE_BMP280)   { Serial.print(" BMP280"); }
     if(features & FEATURE_WINC1500) { Serial.print(" WINC1500"); }
     if(features & FEATURE_SSD1306)  { Serial.print(" SSD1306"); }
+    if(features & FEATURE_RFM9X)    { Serial.print(" RFM9X"); }
+    if(features & FEATURE_ATECC608) { Serial.print(" ATECC608"); }
     Serial.println("\n");
   }
 
@@ -1969,6 +4630,14 @@ void setup()
     menu(); //Menue aufrufen
   }
 
+  //Batteriebetrieb
+  #if LOW_POWER
+    if((features & (FEATURE_USB|FEATURE_SCD4X)) == FEATURE_SCD4X) //mit SCD4X und ohne USB-Verbindung
+    {
+      low_power_start(); //WiFi bleibt aus
+    }
+  #endif
+
   //Plus-Version
   if(features & FEATURE_WINC1500)
   {
@@ -2027,7 +4696,7 @@ void setup()
       Serial.println("Error: CO2 sensor not found");
     }
     leds(FARBE_ROT);
-    status_led(1000); //Status-LED
+    status_wait(1000); //Status-LED
     leds(FARBE_AUS);
     co2_value = co2_average = START_ROT;
   }
@@ -2036,27 +4705,57 @@ void setup()
 }
 
 
+unsigned int ampel_level(unsigned int co2) //Ampelstufe 0-4 (blau, gruen, gelb, rot, rot blinken), zurueck erst die Hysterese des Bereichs unter der Schwelle
+{
+  static unsigned int level=0;
+
+  while((level < 4) && (co2 >= settings.range[level]))
+  {
+    level++;
+  }
+  while((level > 0) && ((co2 + ampel_settings.hysterese[level-1]) < settings.range[level-1]))
+  {
+    level--;
+  }
+
+  return level;
+}
+
+
 void ampel(unsigned int co2)
 {
-  static unsigned int blinken=0;
+  static unsigned int blinken=0, alarm=0;
+  unsigned int level = ampel_level(co2);
 
   //LEDs
-  if(co2 < settings.range[0]) //blau
+  if((level < 3) && trend_warning(co2)) //gelb blinken: Vorwarnung
+  {
+    if(blinken == 0)
+    {
+      leds(ws2812.Color(10,5,0)); //gelb schwache Helligkeit
+    }
+    else
+    {
+      leds(FARBE_GELB); //gelb
+    }
+    blinken = 1-blinken; //invertieren
+  }
+  else if(level == 0) //blau
   {
     blinken = 0;
     leds(FARBE_BLAU);
   }
-  else if(co2 < settings.range[1]) //gruen
+  else if(level == 1) //gruen
   {
     blinken = 0;
     leds(FARBE_GRUEN);
   }
-  else if(co2 < settings.range[2]) //gelb
+  else if(level == 2) //gelb
   {
     blinken = 0;
     leds(FARBE_GELB);
   }
-  else if(co2 < settings.range[3]) //rot
+  else if(level == 3) //rot
   {
     blinken = 0;
     leds(FARBE_ROT);
@@ -2075,7 +4774,15 @@ void ampel(unsigned int co2)
   }
 
   //Buzzer
-  if(co2 < settings.range[4])
+  if(co2 >= settings.range[4])
+  {
+    alarm = 1;
+  }
+  else if((co2 + ampel_settings.hysterese[4]) < settings.range[4])
+  {
+    alarm = 0;
+  }
+  if(alarm == 0)
   {
     buzzer(0); //Buzzer aus
   }
@@ -2098,14 +4805,80 @@ void ampel(unsigned int co2)
 void loop()
 {
   static unsigned int dark=0, sw=0;
-  static unsigned long t_switch=0, t_ampel=0, t_light=~((LICHT_INTERVALL*1000UL*60UL)-60000UL); //Lichtsensor nach 60s pruefen
+  static unsigned long t_switch=0, t_ampel=0, t_history=0, t_data=0, t_light=~((LICHT_INTERVALL*1000UL*60UL)-60000UL); //Lichtsensor nach 60s pruefen
+  unsigned long t;
   unsigned int overwrite=0;
 
+  #if LOW_POWER
+    if(low_power_on) //Messung, dann Standby bis zur naechsten Messung
+    {
+      low_power();
+      return;
+    }
+  #endif
+
+  profile_loop(); //Laufzeitmessung
+
   //serielle Befehle verarbeiten
+  t = micros();
   serial_service();
+  profile_add(PROFILE_SERIAL, t);
+
+  #if LORA
+    if(features & FEATURE_RFM9X)
+    {
+      t = micros();
+      os_runloop_once(); //in jedem Durchlauf, damit die RX-Fenster puenktlich starten
+      profile_add(PROFILE_LORA, t);
+    }
+  #endif
+
+  #if MQTT
+    t = micros();
+    mqtt_reconnect(); //ein Schritt des Verbindungsaufbaus
+    profile_add(PROFILE_MQTT_CONNECT, t);
+  #endif
 
   //WiFi-Daten verarbeiten
+  t = micros();
   webserver_service();
+  profile_add(PROFILE_WEB, t);
+
+  #if MQTT
+    t = micros();
+    mqtt_service();
+    profile_add(PROFILE_MQTT, t);
+  #endif
+
+  //Ablaeufe ohne delay() fortsetzen
+  status_service();
+  if(features & FEATURE_SCD4X)
+  {
+    pressure_service();
+    scd4x_service();
+  }
+  if(light_sensor()) //Lichtsensor-Messung fertig
+  {
+    if(light_value < LICHT_DUNKEL)
+    {
+      if(dark == 0)
+      {
+        dark = 1;
+        if(settings.brightness > HELLIGKEIT_DUNKEL)
+        {
+          ws2812.setBrightness(HELLIGKEIT_DUNKEL); //dunkel
+        }
+      }
+    }
+    else
+    {
+      if(dark == 1)
+      {
+        dark = 0;
+        ws2812.setBrightness(settings.brightness); //hell
+      }
+    }
+  }
 
   //Taster pruefen
   if(digitalRead(PIN_SWITCH) == LOW) //Taster gedrueckt
@@ -2141,6 +4914,30 @@ void loop()
     }
   }
 
+  //Sensordaten auslesen, Transfers laufen per Interrupt, nicht waehrend der LoRa-Empfangsfenster (Druck und Display blockieren)
+  unsigned int pending = lora_pending();
+  if(pending == 0)
+  {
+    t = micros();
+    if(sensor_task.state == 0) //erste Abfrage: Sensor-Timeout ab jetzt
+    {
+      t_data = millis();
+    }
+    if(check_sensors())
+    {
+      t_data = millis();
+      co2_average = co2_filter(co2_value);
+      trend_update(co2_average);
+      show_data();
+      if(dark == 0)
+      {
+        status_blink(1); //Status-LED
+      }
+      overwrite = 1; //Ampel sofort aktualisieren
+    }
+    profile_add(PROFILE_SENSORS, t);
+  }
+
   if((millis()-t_ampel) > 1000) //Ampelfunktion nur jede Sekunde ausfuehren
   {
     t_ampel = millis(); //Zeit speichern
@@ -2160,17 +4957,40 @@ void loop()
     //  features &= ~FEATURE_USB;
     //}
 
-    //Sensordaten auslesen
-    if(check_sensors())
+    //keine neuen Sensordaten
+    if((pending == 0) && ((millis()-t_data) > (SENSOR_TIMEOUT*1000UL*((features & FEATURE_SCD4X) ? 5 : INTERVALL))))
     {
-      show_data();
-      if(dark == 0)
+      t_data = millis();
+      err_co2++;
+    }
+    uptime(); //Ueberlauf von millis() erkennen
+
+    #if HISTORY
+      if((millis()-t_history) >= (HISTORY_INTERVALL*1000UL)) //Messwertverlauf
       {
-        status_led(2); //Status-LED
+        t_history = millis();
+        history_sample();
       }
+      #if HISTORY_FLASH
+        if(pending == 0)
+        {
+          history_save();
+        }
+      #endif
+    #endif
+
+    if(settings_deferred && (pending == 0))
+    {
+      settings_save();
     }
 
-    co2_average = (co2_average + co2_sensor()) / 2; //Berechnung jede Sekunde
+    #if MQTT
+      mqtt_sample();
+    #endif
+
+    #if LORA
+      lora_sample();
+    #endif
   }
   else if(overwrite == 0)
   {
@@ -2178,13 +4998,15 @@ void loop()
   }
 
   //Ampel
-  if(remote_on == 0)
+  if((remote_on == 0) && (light_task.state == 0)) //nicht waehrend Lichtsensor-Messung
   {
+    t = micros();
     #if AMPEL_DURCHSCHNITT > 0
       ampel(co2_average);
     #else
       ampel(co2_value);
     #endif
+    profile_add(PROFILE_AMPEL, t);
   }
 
   //Lichtsensor
@@ -2193,27 +5015,7 @@ void loop()
     if((millis()-t_light) > (LICHT_INTERVALL*1000UL*60UL))
     {
       t_light = millis(); //Zeit speichern
-
-      light_value = light_sensor();
-      if(light_value < LICHT_DUNKEL)
-      {
-        if(dark == 0)
-        {
-          dark = 1;
-          if(settings.brightness > HELLIGKEIT_DUNKEL)
-          {
-            ws2812.setBrightness(HELLIGKEIT_DUNKEL); //dunkel
-          }
-        }
-      }
-      else
-      {
-        if(dark == 1)
-        {
-          dark = 0;
-          ws2812.setBrightness(settings.brightness); //hell
-        }
-      }
+      light_start(); //weiter in light_sensor()
     }
   }
 
@@ -0,0 +1,281 @@
+/*
+  Crypto Benchmark
+
+  Measures the BearSSL implementations bundled with ArduinoBearSSL on the
+  SAMD21 (Cortex-M0+, 48 MHz, one flash wait state) and prints cycles/byte
+  and cycles/op for each alternative, followed by the fastest constant-time
+  one. Lines marked with * are the ones used by BearSSLClient (BR_LOMUL is
+  set for ARDUINO in bearssl/config.h). aes_small and aes_big are not
+  constant-time, they are only listed for comparison.
+
+  Code size per implementation: build with "Show verbose output" enabled and
+  run on the ELF file:
+    arm-none-eabi-nm -S --size-sort Crypto_Benchmark.ino.elf | grep -i "br_"
+*/
+
+#include <ArduinoBearSSL.h>
+#include <bearssl/bearssl.h>
+
+#define DATA_LEN 1024 // bytes per run
+
+uint8_t data[DATA_LEN];
+uint8_t key[32], iv[16], tag[16];
+
+//--- timing ---
+
+typedef void (*bench_fn)(void);
+
+uint32_t cycles(bench_fn fn, uint32_t runs) // cycles per run
+{
+  uint32_t t;
+
+  fn(); // warm-up (NVM cache)
+  t = micros();
+  for(uint32_t i = 0; i < runs; i++)
+  {
+    fn();
+  }
+  t = micros() - t;
+
+  return (uint64_t)t * (F_CPU / 1000000UL) / runs;
+}
+
+char best_name[24];
+uint32_t best_cycles;
+uint8_t candidates;
+
+void group(const char *title) // start a group of alternatives
+{
+  if(candidates > 1)
+  {
+    Serial.print("   -> fastest: ");
+    Serial.println(best_name);
+  }
+  candidates = 0;
+  if(title)
+  {
+    Serial.print("\n--- ");
+    Serial.print(title);
+    Serial.println(" ---");
+  }
+}
+
+void candidate(const char *name, uint32_t c) // constant-time alternative
+{
+  if(candidates == 0 || c < best_cycles)
+  {
+    strncpy(best_name, name, sizeof(best_name) - 1);
+    best_cycles = c;
+  }
+  candidates++;
+}
+
+void print_result(const char *name, bool used, uint32_t c, uint32_t len)
+{
+  Serial.print(used ? " * " : "   ");
+  Serial.print(name);
+  for(int i = strlen(name); i < 24; i++)
+  {
+    Serial.print(' ');
+  }
+  if(len)
+  {
+    Serial.print((float)c / len, 1);
+    Serial.println(" cycles/byte");
+  }
+  else
+  {
+    Serial.print(c);
+    Serial.print(" cycles/op (");
+    Serial.print(c / (F_CPU / 1000UL));
+    Serial.println(" ms)");
+  }
+}
+
+void bench(const char *name, bool used, bool ct, bench_fn fn, uint32_t runs)
+{
+  uint32_t c = cycles(fn, runs);
+
+  print_result(name, used, c, DATA_LEN);
+  if(ct)
+  {
+    candidate(name, c);
+  }
+}
+
+//--- hash, DRBG ---
+
+void run_sha256(void)
+{
+  br_sha256_context ctx;
+  br_sha256_init(&ctx);
+  br_sha256_update(&ctx, data, DATA_LEN);
+  br_sha256_out(&ctx, tag);
+}
+
+void run_drbg(void)
+{
+  br_hmac_drbg_context ctx;
+  br_hmac_drbg_init(&ctx, &br_sha256_vtable, key, sizeof(key));
+  br_hmac_drbg_generate(&ctx, data, DATA_LEN);
+}
+
+//--- AES-128 CTR, GCM, CCM ---
+
+const br_block_ctr_class *ctr_vt;
+const br_block_ctrcbc_class *ctrcbc_vt;
+br_ghash ghash;
+
+void run_ctr(void)
+{
+  br_aes_gen_ctr_keys ctx;
+  ctr_vt->init(&ctx.vtable, key, 16);
+  ctr_vt->run(&ctx.vtable, iv, 1, data, DATA_LEN);
+}
+
+void run_gcm(void)
+{
+  br_aes_gen_ctr_keys bc;
+  br_gcm_context ctx;
+  ctr_vt->init(&bc.vtable, key, 16);
+  br_gcm_init(&ctx, &bc.vtable, ghash);
+  br_gcm_reset(&ctx, iv, 12);
+  br_gcm_aad_inject(&ctx, key, 13); // TLS record header
+  br_gcm_flip(&ctx);
+  br_gcm_run(&ctx, 1, data, DATA_LEN);
+  br_gcm_get_tag(&ctx, tag);
+}
+
+void run_ccm(void)
+{
+  br_aes_gen_ctrcbc_keys bc;
+  br_ccm_context ctx;
+  ctrcbc_vt->init(&bc.vtable, key, 16);
+  br_ccm_init(&ctx, &bc.vtable);
+  br_ccm_reset(&ctx, iv, 13, 13, DATA_LEN, 8); // LoRaWAN/802.15.4 style nonce
+  br_ccm_aad_inject(&ctx, key, 13);
+  br_ccm_flip(&ctx);
+  br_ccm_run(&ctx, 1, data, DATA_LEN);
+  br_ccm_get_tag(&ctx, tag);
+}
+
+//--- ChaCha20+Poly1305 ---
+
+br_poly1305_run poly1305;
+
+void run_chapol(void)
+{
+  poly1305(key, iv, data, DATA_LEN, key, 13, tag, br_chacha20_ct_run, 1);
+}
+
+//--- EC ---
+
+const br_ec_impl *ec;
+int ec_curve;
+uint8_t ec_point[65];
+size_t ec_point_len;
+
+void run_mulgen(void) // key generation, ECDHE public key
+{
+  ec->mulgen(ec_point, key, 32, ec_curve);
+}
+
+void run_mul(void) // ECDHE shared secret
+{
+  ec->mul(ec_point, ec_point_len, key, 32, ec_curve);
+}
+
+void bench_ec(const char *name, const br_ec_impl *impl, int curve, bool used)
+{
+  char s[32];
+  uint32_t c1, c2;
+
+  ec = impl;
+  ec_curve = curve;
+  ec_point_len = ec->mulgen(ec_point, key, 32, ec_curve);
+
+  c1 = cycles(run_mulgen, 2);
+  snprintf(s, sizeof(s), "%s mulgen", name);
+  print_result(s, used, c1, 0);
+  c2 = cycles(run_mul, 2);
+  snprintf(s, sizeof(s), "%s mul", name);
+  print_result(s, used, c2, 0);
+  candidate(name, c1 + c2); // one ECDHE
+}
+
+//--- main ---
+
+void setup()
+{
+  // init serial library
+  Serial.begin(9600);
+  while(!Serial); // wait for serial monitor
+  Serial.println("Crypto Benchmark");
+  Serial.print(F_CPU / 1000000UL);
+  Serial.print(" MHz, ");
+  Serial.print(DATA_LEN);
+  Serial.println(" bytes per run");
+
+  for(uint32_t i = 0; i < sizeof(key); i++)
+  {
+    key[i] = i + 1;
+  }
+  key[0] &= 0x7F; // scalar below the curve order
+  memset(iv, 0x5A, sizeof(iv));
+  memset(data, 0xA5, sizeof(data));
+
+  group("SHA-256, HMAC-DRBG");
+  bench("sha256", true, true, run_sha256, 20);
+  bench("hmac_drbg sha256", true, false, run_drbg, 5);
+
+  group("AES-128-CTR");
+  ctr_vt = &br_aes_ct_ctr_vtable;
+  bench("aes_ct", true, true, run_ctr, 10);
+  ctr_vt = &br_aes_small_ctr_vtable;
+  bench("aes_small", false, false, run_ctr, 10);
+  ctr_vt = &br_aes_big_ctr_vtable;
+  bench("aes_big", false, false, run_ctr, 10);
+
+  group("AES-128-GCM (aes_ct)");
+  ctr_vt = &br_aes_ct_ctr_vtable;
+  ghash = br_ghash_ctmul32;
+  bench("ghash_ctmul32", true, true, run_gcm, 5);
+  ghash = br_ghash_ctmul;
+  bench("ghash_ctmul", false, true, run_gcm, 5);
+  ghash = br_ghash_ctmul64;
+  bench("ghash_ctmul64", false, true, run_gcm, 5);
+
+  group("AES-128-CCM");
+  ctrcbc_vt = &br_aes_ct_ctrcbc_vtable;
+  bench("aes_ct", true, true, run_ccm, 5);
+  ctrcbc_vt = &br_aes_small_ctrcbc_vtable;
+  bench("aes_small", false, false, run_ccm, 5);
+  ctrcbc_vt = &br_aes_big_ctrcbc_vtable;
+  bench("aes_big", false, false, run_ccm, 5);
+
+  group("ChaCha20+Poly1305 (chacha20_ct)");
+  poly1305 = br_poly1305_ctmul32_run;
+  bench("poly1305_ctmul32", true, true, run_chapol, 10);
+  poly1305 = br_poly1305_ctmul_run;
+  bench("poly1305_ctmul", false, true, run_chapol, 10);
+  poly1305 = br_poly1305_i15_run;
+  bench("poly1305_i15", false, true, run_chapol, 10);
+
+  group("EC P-256");
+  bench_ec("p256_m15", &br_ec_p256_m15, BR_EC_secp256r1, true);
+  bench_ec("p256_m31", &br_ec_p256_m31, BR_EC_secp256r1, false);
+  bench_ec("prime_i15", &br_ec_prime_i15, BR_EC_secp256r1, false);
+  bench_ec("prime_i31", &br_ec_prime_i31, BR_EC_secp256r1, false);
+
+  group("EC Curve25519");
+  bench_ec("c25519_m15", &br_ec_c25519_m15, BR_EC_curve25519, true);
+  bench_ec("c25519_m31", &br_ec_c25519_m31, BR_EC_curve25519, false);
+  group(NULL);
+
+  Serial.println("\nDone");
+}
+
+void loop()
+{
+  // do nothing
+}
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""
+Sketch -> C++ for the host tests, like the Arduino builder:
+  - sets the configuration: NAME=VALUE replaces the value of the first
+    "#define NAME value" in the sketch
+  - adds #include <Arduino.h> and the prototypes of the functions that are
+    compiled in this configuration (found in the preprocessed sketch)
+  - keeps the line numbers of the sketch (#line) for compiler messages
+
+usage: ino2cpp.py sketch.ino out.cpp [NAME=VALUE ...] -- [preprocessor flags]
+"""
+
+import re
+import subprocess
+import sys
+
+FUNC = re.compile(r'^([A-Za-z_][\w \*]*?[\s\*])([A-Za-z_]\w*)\(([^;{}]*?)\)[ \t]*(//[^\n]*)?\n\{', re.M)
+KEYWORDS = ('if', 'while', 'for', 'switch', 'return', 'else')
+
+
+def configure(src, defines):
+    for d in defines:
+        name, value = d.split('=', 1)
+        pat = re.compile(r'^([ \t]*#define[ \t]+' + re.escape(name) + r'[ \t]+)(\S+)', re.M)
+        src, n = pat.subn(lambda m: m.group(1) + value, src, count=1)
+        if n == 0:
+            sys.exit('ino2cpp: #define %s not found' % name)
+    return src
+
+
+def active(src, flags):
+    # function definitions that survive the preprocessor in this configuration
+    out = subprocess.run(['g++', '-E', '-P', '-x', 'c++', '-std=gnu++11', '-include', 'Arduino.h'] + flags + ['-'],
+                         input=src, capture_output=True, text=True)
+    if out.returncode != 0:
+        sys.exit(out.stderr)
+    return {m.group(1) for m in re.finditer(r'\b([A-Za-z_]\w*)\s*\([^;{}]*\)\s*\{', out.stdout)}
+
+
+def main():
+    args = sys.argv[1:]
+    flags = []
+    if '--' in args:
+        flags = args[args.index('--') + 1:]
+        args = args[:args.index('--')]
+    ino, cpp, defines = args[0], args[1], args[2:]
+
+    src = configure(open(ino).read(), defines)
+    names = active(src, flags)
+
+    protos = []
+    first = None
+    for m in FUNC.finditer(src):
+        ret, name, params = m.group(1).strip(), m.group(2), m.group(3)
+        if ret.split()[0] in ('typedef', 'struct', 'enum') or ret in KEYWORDS or name in KEYWORDS:
+            continue
+        if first is None:
+            first = m.start()
+        if name in names and name not in ('setup', 'loop'):
+            protos.append('%s %s(%s);' % (ret, name, re.sub(r'=[^,]*', '', params)))
+
+    line = src[:first].count('\n') + 1
+    with open(cpp, 'w') as f:
+        f.write('#include <Arduino.h>\n#line 1 "%s"\n' % ino)
+        f.write(src[:first])
+        f.write('\n'.join(protos) + '\n')
+        f.write('#line %d "%s"\n' % (line, ino))
+        f.write(src[first:])
+
+
+if __name__ == '__main__':
+    main()
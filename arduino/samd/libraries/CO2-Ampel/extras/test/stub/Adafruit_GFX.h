@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Arduino.h>
+
+class Adafruit_GFX : public Print
+{
+public:
+  Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) { }
+  void setCursor(int16_t x, int16_t y) { cursor_x = x; cursor_y = y; }
+  void setTextSize(uint8_t s) { textsize = s; }
+  void setTextColor(uint16_t c) { textcolor = textbgcolor = c; }
+  void setTextColor(uint16_t c, uint16_t bg) { textcolor = c; textbgcolor = bg; }
+  size_t write(uint8_t) { cursor_x += 6 * textsize; changed(); return 1; }
+  using Print::write;
+protected:
+  virtual void changed() { }
+  const int16_t WIDTH, HEIGHT;
+  int16_t cursor_x = 0, cursor_y = 0;
+  uint8_t textsize = 1;
+  uint16_t textcolor = 0xFFFF, textbgcolor = 0xFFFF;
+};
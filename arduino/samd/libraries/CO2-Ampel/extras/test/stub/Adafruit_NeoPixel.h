@@ -0,0 +1,62 @@
+/*
+  Host stub of Adafruit_NeoPixel, keeps the pixel buffer (scaled by the
+  brightness like the library) and counts show() calls.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#define NEO_GRB    ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+
+extern unsigned long stub_leds_shows; // ws2812.show() calls
+
+class Adafruit_NeoPixel
+{
+public:
+  Adafruit_NeoPixel(uint16_t n, int16_t = 6, uint16_t = NEO_GRB + NEO_KHZ800) : numLEDs(n), pixels(new uint8_t[n * 3]()) { }
+  ~Adafruit_NeoPixel() { delete[] pixels; }
+  void begin() { }
+  bool setDMA(Sercom *, uint8_t, EPioType) { dma = true; return true; }
+  void show() { stub_leds_shows++; if (!dma) stub_advance(numLEDs * 30); } // bit-banging: 30us per LED, interrupts off
+  bool canShow() { return true; }
+  void setBrightness(uint8_t b) { brightness = b + 1; }
+  uint8_t getBrightness() const { return brightness - 1; }
+  void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+  {
+    if (n < numLEDs) {
+      uint8_t *p = &pixels[n * 3];
+      if (brightness) {
+        r = (r * brightness) >> 8;
+        g = (g * brightness) >> 8;
+        b = (b * brightness) >> 8;
+      }
+      p[0] = g;
+      p[1] = r;
+      p[2] = b;
+    }
+  }
+  void setPixelColor(uint16_t n, uint32_t c) { setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c); }
+  void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0)
+  {
+    uint16_t end = (count == 0 || first + count > numLEDs) ? numLEDs : first + count;
+    for (uint16_t i = first; i < end; i++) {
+      setPixelColor(i, c);
+    }
+  }
+  uint32_t getPixelColor(uint16_t n) const
+  {
+    const uint8_t *p = &pixels[n * 3];
+    return ((uint32_t)p[1] << 16) | ((uint32_t)p[0] << 8) | p[2];
+  }
+  uint8_t *getPixels() const { return pixels; }
+  uint16_t numPixels() const { return numLEDs; }
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) { return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
+
+private:
+  uint16_t numLEDs;
+  uint8_t *pixels;
+  uint8_t brightness = 0;
+  bool dma = false;
+};
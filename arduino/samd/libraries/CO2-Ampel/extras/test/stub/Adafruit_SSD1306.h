@@ -0,0 +1,47 @@
+/*
+  Host stub of Adafruit_SSD1306. Drawing only marks the whole screen as
+  changed, nextWindow() then returns it as one window of all pages.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+
+#define BLACK 0
+#define WHITE 1
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_COLUMNADDR   0x21
+#define SSD1306_PAGEADDR     0x22
+#define SSD1306_DISPLAYOFF   0xAE
+#define SSD1306_DISPLAYON    0xAF
+
+class Adafruit_SSD1306 : public Adafruit_GFX
+{
+public:
+  Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire * = &Wire, int8_t = -1) : Adafruit_GFX(w, h) { }
+  bool begin(uint8_t = SSD1306_SWITCHCAPVCC, uint8_t = 0) { return true; }
+  void clearDisplay() { memset(buffer, 0, sizeof(buffer)); changed(); }
+  void display() { dirty = false; stub_advance(WIDTH * HEIGHT / 8 * 25); } // blocking, 400kHz
+  bool nextWindow(uint8_t *p0, uint8_t *p1, uint8_t *x0, uint8_t *x1)
+  {
+    if (!dirty) {
+      return false;
+    }
+    dirty = false;
+    *p0 = 0;
+    *p1 = HEIGHT / 8 - 1;
+    *x0 = 0;
+    *x1 = WIDTH - 1;
+    return true;
+  }
+  uint8_t *getBuffer() { return buffer; }
+  void ssd1306_command(uint8_t) { stub_advance(100); }
+protected:
+  void changed() { dirty = true; }
+private:
+  uint8_t buffer[128 * 64 / 8];
+  bool dirty = false;
+};
@@ -0,0 +1,295 @@
+/*
+  Host stub of the Arduino SAMD core: virtual clock, pins, Print/Stream,
+  USB serial, peripheral objects and the simulated air for the sensors.
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <SPI.h>
+#include <I2CQueue.h>
+#include <Adafruit_NeoPixel.h>
+
+//--- virtual clock ---
+
+uint64_t stub_us = 0;
+
+void stub_advance(uint64_t us)
+{
+  stub_us += us;
+}
+
+unsigned long millis(void)
+{
+  stub_us += 1; // every read costs time, busy waits terminate
+  stub_irq_run();
+  return (unsigned long)(stub_us / 1000);
+}
+
+unsigned long micros(void)
+{
+  stub_us += 1;
+  stub_irq_run();
+  return (unsigned long)stub_us;
+}
+
+void delay(unsigned long ms)
+{
+  stub_us += (uint64_t)ms * 1000;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  stub_us += us;
+}
+
+void yield(void)
+{
+}
+
+extern "C" void SysTick_DefaultHandler(void)
+{
+  stub_us += 1000;
+}
+
+//--- pins ---
+
+int stub_pin_in[NUM_PINS];
+int stub_pin_out[NUM_PINS];
+int stub_analog[NUM_PINS];
+int stub_resets = 0;
+
+static struct StubPinInit
+{
+  StubPinInit()
+  {
+    for (int i = 0; i < NUM_PINS; i++) {
+      stub_pin_in[i] = HIGH; // pull-ups, switch not pressed
+    }
+    stub_analog[PIN_LSENSOR] = 500;
+  }
+} stub_pin_init;
+
+void pinMode(uint32_t, uint32_t)
+{
+}
+
+void digitalWrite(uint32_t pin, uint32_t value)
+{
+  if (pin < NUM_PINS) {
+    stub_pin_out[pin] = value;
+  }
+}
+
+int digitalRead(uint32_t pin)
+{
+  return (pin < NUM_PINS) ? stub_pin_in[pin] : LOW;
+}
+
+int analogRead(uint32_t pin)
+{
+  stub_us += 10;
+  return (pin < NUM_PINS) ? stub_analog[pin] : 0;
+}
+
+void analogWrite(uint32_t pin, uint32_t value)
+{
+  digitalWrite(pin, value);
+}
+
+void NVIC_SystemReset(void)
+{
+  stub_resets++;
+}
+
+//--- interrupts ---
+
+uint32_t stub_primask = 0;
+void (*stub_irq)(void) = NULL;
+void (*sercom0_handler)(void) = NULL;
+void (*sercom2_handler)(void) = NULL;
+void __attribute__((weak)) i2c_bus_acquire(TwoWire *) { }
+void __attribute__((weak)) i2c_bus_release(TwoWire *) { }
+void (*stub_reg_write)(StubReg *r, uint32_t old) = NULL;
+void (*stub_reg_read)(StubReg *r) = NULL;
+
+void stub_irq_run(void)
+{
+  static bool active = false;
+
+  if (stub_irq != NULL && stub_primask == 0 && !active) {
+    active = true; // no nesting, like one priority level
+    stub_primask = 1;
+    stub_irq();
+    stub_primask = 0;
+    active = false;
+  }
+}
+
+//--- RAM: heap end for the stack watermark of the sketch ---
+
+#define STUB_STACK 24576 // bytes between heap and stack, like the SAMD21 after .bss
+
+static void stub_stack_touch(void)
+{
+  volatile char probe[2 * STUB_STACK];
+
+  for (unsigned int i = 0; i < sizeof(probe); i += 256) {
+    probe[i] = 0; // map the stack pages below main()
+  }
+}
+
+static char *stub_heap_end = NULL;
+
+extern "C" char *sbrk(int i)
+{
+  if (stub_heap_end == NULL) {
+    stub_stack_touch();
+    stub_heap_end = (char*)__builtin_frame_address(0) - STUB_STACK;
+  }
+  char *p = stub_heap_end;
+  stub_heap_end += i;
+  return p;
+}
+
+//--- Print, Stream ---
+
+size_t Print::write(const uint8_t *buf, size_t size)
+{
+  size_t n = 0;
+
+  while (size--) {
+    n += write(*buf++);
+  }
+  return n;
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+  char buf[8 * sizeof(long) + 1];
+  char *s = &buf[sizeof(buf) - 1];
+
+  if (base < 2) {
+    base = 10;
+  }
+  *s = 0;
+  do {
+    char c = n % base;
+    n /= base;
+    *--s = (c < 10) ? (c + '0') : (c + 'A' - 10);
+  } while (n);
+  return write(s);
+}
+
+size_t Print::print(long n, int base)
+{
+  if (base == 10 && n < 0) {
+    return print('-') + print((unsigned long)-n, 10);
+  }
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(double number, int digits)
+{
+  char buf[48];
+
+  if (isnan(number)) {
+    return print("nan");
+  }
+  if (isinf(number)) {
+    return print("inf");
+  }
+  snprintf(buf, sizeof(buf), "%.*f", digits, number);
+  return print(buf);
+}
+
+size_t Print::print(const Printable &p)
+{
+  return p.printTo(*this);
+}
+
+size_t Stream::readBytes(char *buf, size_t length)
+{
+  size_t n = 0;
+
+  while (n < length) {
+    int c = read();
+    if (c < 0) {
+      stub_us += (uint64_t)_timeout * 1000; // timedRead() waits
+      break;
+    }
+    buf[n++] = c;
+  }
+  return n;
+}
+
+size_t Stream::readBytesUntil(char terminator, char *buf, size_t length)
+{
+  size_t n = 0;
+
+  while (n < length) {
+    int c = read();
+    if (c < 0) {
+      stub_us += (uint64_t)_timeout * 1000;
+      break;
+    }
+    if (c == terminator) {
+      break;
+    }
+    buf[n++] = c;
+  }
+  return n;
+}
+
+bool IPAddress::fromString(const char *s)
+{
+  unsigned int a, b, c, d;
+
+  if (sscanf(s, "%u.%u.%u.%u", &a, &b, &c, &d) != 4) {
+    return false;
+  }
+  *this = IPAddress(a, b, c, d);
+  return true;
+}
+
+size_t IPAddress::printTo(Print &p) const
+{
+  size_t n = 0;
+
+  for (int i = 0; i < 4; i++) {
+    n += p.print((unsigned long)addr.bytes[i], DEC);
+    if (i < 3) {
+      n += p.print('.');
+    }
+  }
+  return n;
+}
+
+//--- peripherals ---
+
+Serial_ Serial;
+USBDeviceClass USBDevice;
+TwoWire Wire, Wire1;
+uint8_t (*stub_wire_tx)(TwoWire *wire, uint8_t addr, const uint8_t *data, size_t len) = NULL;
+SPIClass SPI;
+uint8_t stub_spi_rx = 0x12;
+uint8_t (*stub_spi_transfer)(uint8_t data) = NULL;
+bool stub_i2c_devices[128];
+StubI2CDevice *stub_i2c_model[128];
+unsigned long stub_leds_shows = 0;
+float stub_co2 = 600, stub_temp = 22, stub_humi = 45, stub_pres = 1013;
+
+static Rtc stub_rtc;
+static Gclk stub_gclk;
+static Pm stub_pm;
+static Nvm stub_nvm;
+static Scb stub_scb;
+static Systick stub_systick;
+static Sercom stub_sercom[6];
+Rtc *RTC = &stub_rtc;
+Gclk *GCLK = &stub_gclk;
+Pm *PM = &stub_pm;
+Nvm *NVMCTRL = &stub_nvm;
+Scb *SCB = &stub_scb;
+Systick *SysTick = &stub_systick;
+Sercom *SERCOM0 = &stub_sercom[0], *SERCOM1 = &stub_sercom[1], *SERCOM2 = &stub_sercom[2];
+Sercom *SERCOM3 = &stub_sercom[3], *SERCOM4 = &stub_sercom[4], *SERCOM5 = &stub_sercom[5];
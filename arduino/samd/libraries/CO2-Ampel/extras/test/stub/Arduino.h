@@ -0,0 +1,306 @@
+/*
+  Host stub of the Arduino SAMD core for the CO2-Ampel tests.
+
+  millis()/micros() run on a virtual clock (stub_us). delay() and the
+  simulated peripherals advance it, every clock read costs 1us, so busy
+  waits on millis() terminate. Nothing here talks to hardware.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW  0
+#define INPUT          0
+#define OUTPUT         1
+#define INPUT_PULLUP   2
+#define INPUT_PULLDOWN 3
+#define HEX 16
+#define DEC 10
+
+// variant co2ampel
+#define PIN_LED         13
+#define PIN_BUZZER      12
+#define PIN_WS2812      11
+#define PIN_LSENSOR     14
+#define PIN_LSENSOR_PWR 15
+#define PIN_SWITCH      16
+#define NUM_PINS        32
+
+#define F_CPU 48000000UL
+class __FlashStringHelper;
+#define F(x) (x)
+#define PROGMEM
+
+//--- virtual clock ---
+
+extern uint64_t stub_us;        // virtual time in us
+void stub_advance(uint64_t us); // let time pass (peripheral latency)
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+//--- pins ---
+
+extern int stub_pin_in[NUM_PINS];  // level returned by digitalRead()
+extern int stub_pin_out[NUM_PINS]; // last digitalWrite()
+extern int stub_analog[NUM_PINS];  // value returned by analogRead()
+
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+int analogRead(uint32_t pin);
+void analogWrite(uint32_t pin, uint32_t value);
+
+//--- CPU ---
+
+extern int stub_resets; // NVIC_SystemReset() calls
+
+// A test can attach the interrupts of its peripheral models to stub_irq,
+// they run whenever interrupts are enabled again and in millis()/micros().
+extern uint32_t stub_primask;
+extern void (*stub_irq)(void);
+void stub_irq_run(void);
+
+void NVIC_SystemReset(void);
+inline uint32_t __get_PRIMASK(void) { return stub_primask; }
+inline void __set_PRIMASK(uint32_t m) { stub_primask = m; stub_irq_run(); }
+inline void __disable_irq(void) { stub_primask = 1; }
+inline void __enable_irq(void) { __set_PRIMASK(0); }
+inline void __WFI(void) { }
+inline void __DSB(void) { }
+inline void noInterrupts(void) { __disable_irq(); }
+inline void interrupts(void) { __enable_irq(); }
+
+template<class T, class L> auto min(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (b < a) ? b : a; }
+template<class T, class L> auto max(const T& a, const L& b) -> decltype((b < a) ? b : a) { return (a < b) ? b : a; }
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+//--- String, Print, Stream ---
+
+class String
+{
+public:
+  String(const char *s = "") : s(s) { }
+  const char *c_str() const { return s.c_str(); }
+  unsigned int length() const { return s.length(); }
+private:
+  std::string s;
+};
+
+class Printable;
+
+class Print
+{
+public:
+  virtual ~Print() { }
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t size);
+  size_t write(const char *s) { return (s == NULL) ? 0 : write((const uint8_t*)s, strlen(s)); }
+  size_t write(const char *buf, size_t size) { return write((const uint8_t*)buf, size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() { }
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+  size_t print(const Printable &p);
+
+  size_t println(void) { return write("\r\n"); }
+  template<class T> size_t println(const T &v) { size_t n = print(v); return n + println(); }
+  template<class T> size_t println(const T &v, int f) { size_t n = print(v, f); return n + println(); }
+};
+
+class Printable
+{
+public:
+  virtual ~Printable() { }
+  virtual size_t printTo(Print &p) const = 0;
+};
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  size_t readBytes(char *buf, size_t length);
+  size_t readBytesUntil(char terminator, char *buf, size_t length);
+protected:
+  unsigned long _timeout = 1000;
+};
+
+// USB serial: input is fed by the test, output is collected
+class Serial_ : public Stream
+{
+public:
+  void begin(unsigned long) { }
+  void end() { }
+  int available() { return in.size() - pos; }
+  int read() { return (pos < in.size()) ? (uint8_t)in[pos++] : -1; }
+  int peek() { return (pos < in.size()) ? (uint8_t)in[pos] : -1; }
+  size_t write(uint8_t c) { out += (char)c; return 1; }
+  using Print::write;
+  operator bool() { return true; }
+
+  std::string in, out; // test side
+  size_t pos = 0;
+};
+extern Serial_ Serial;
+
+class IPAddress : public Printable
+{
+public:
+  IPAddress() { addr.dword = 0; }
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { addr.bytes[0] = a; addr.bytes[1] = b; addr.bytes[2] = c; addr.bytes[3] = d; }
+  IPAddress(uint32_t a) { addr.dword = a; }
+  operator uint32_t() const { return addr.dword; }
+  uint8_t operator[](int i) const { return addr.bytes[i]; }
+  uint8_t& operator[](int i) { return addr.bytes[i]; }
+  bool fromString(const char *s);
+  size_t printTo(Print &p) const;
+private:
+  union { uint8_t bytes[4]; uint32_t dword; } addr;
+};
+
+class USBDeviceClass
+{
+public:
+  bool connected() { return stub_connected; }
+  void detach() { }
+  void attach() { }
+  void standby() { }
+  bool stub_connected = true;
+};
+extern USBDeviceClass USBDevice;
+
+//--- SAMD21 registers (low power, I2C) ---
+
+struct R32 { uint32_t reg; struct { uint32_t SWRST, ENABLE, SYNCBUSY, SLEEPPRM, CMP0, MODE; } bit; };
+struct RtcMode0 { R32 CTRL, READREQ, STATUS, COUNT, COMP[1], INTFLAG, INTENSET, INTENCLR; };
+struct Rtc { RtcMode0 MODE0; };
+struct Gclk { R32 GENDIV, GENCTRL, CLKCTRL, STATUS; };
+struct Pm { R32 APBAMASK, APBCMASK; };
+struct Nvm { R32 CTRLB; };
+struct Scb { uint32_t SCR; };
+struct Systick { uint32_t CTRL; };
+// SERCOM I2C master: a write calls stub_reg_write with the old value, the
+// test's bus model reacts to it (ADDR, DATA, CMD) like the hardware does.
+// SERCOM SPI: a read calls stub_reg_read first, the model updates the
+// flags and pops the received byte from DATA
+struct StubReg
+{
+  uint32_t v;
+  StubReg &operator=(uint32_t x);
+  operator uint32_t() const;
+};
+extern void (*stub_reg_write)(StubReg *r, uint32_t old);
+extern void (*stub_reg_read)(StubReg *r);
+inline StubReg &StubReg::operator=(uint32_t x)
+{
+  uint32_t old = v;
+  v = x;
+  if (stub_reg_write != NULL) {
+    stub_reg_write(this, old);
+  }
+  return *this;
+}
+inline StubReg::operator uint32_t() const
+{
+  if (stub_reg_read != NULL) {
+    stub_reg_read(const_cast<StubReg *>(this));
+  }
+  return v;
+}
+struct SercomReg { StubReg reg; struct { StubReg ADDR, CMD, ACKACT, SYSOP; } bit; };
+struct SercomI2cm { SercomReg CTRLB, ADDR, DATA, INTENCLR, INTENSET, INTFLAG, STATUS, SYNCBUSY; };
+struct SercomSpiReg { StubReg reg; struct { StubReg DRE, TXC, RXC; } bit; };
+struct SercomSpi { SercomSpiReg INTFLAG, STATUS, DATA; };
+struct Sercom { SercomI2cm I2CM; SercomSpi SPI; };
+extern Rtc *RTC;
+extern Gclk *GCLK;
+extern Pm *PM;
+extern Nvm *NVMCTRL;
+extern Scb *SCB;
+extern Systick *SysTick;
+extern Sercom *SERCOM0, *SERCOM1, *SERCOM2, *SERCOM3, *SERCOM4, *SERCOM5;
+
+#define RTC_MODE0_INTFLAG_CMP0                1
+#define RTC_MODE0_INTENSET_CMP0               1
+#define RTC_MODE0_CTRL_SWRST                  1
+#define RTC_MODE0_CTRL_MODE_COUNT32           0
+#define RTC_MODE0_CTRL_PRESCALER_DIV1         0
+#define RTC_MODE0_CTRL_ENABLE                 2
+#define RTC_READREQ_RREQ                      0x8000
+#define NVMCTRL_CTRLB_SLEEPPRM_DISABLED_Val   3
+#define PM_APBAMASK_RTC                       0x20
+#define GCLK_GENDIV_ID(x)                     (x)
+#define GCLK_GENDIV_DIV(x)                    ((x) << 8)
+#define GCLK_GENCTRL_ID(x)                    (x)
+#define GCLK_GENCTRL_SRC_OSCULP32K            (3 << 8)
+#define GCLK_GENCTRL_DIVSEL                   (1 << 20)
+#define GCLK_GENCTRL_GENEN                    (1 << 16)
+#define GCLK_GENCTRL_RUNSTDBY                 (1 << 21)
+#define GCLK_CLKCTRL_ID_RTC                   4
+#define GCLK_CLKCTRL_GEN_GCLK2                (2 << 8)
+#define GCLK_CLKCTRL_CLKEN                    (1 << 14)
+#define SysTick_CTRL_TICKINT_Msk              2
+#define SCB_SCR_SLEEPDEEP_Msk                 4
+
+#define SERCOM_I2CM_INTENSET_MB               (1 << 0)
+#define SERCOM_I2CM_INTENSET_SB               (1 << 1)
+#define SERCOM_I2CM_INTENSET_ERROR            (1 << 7)
+#define SERCOM_I2CM_INTFLAG_MB                (1 << 0)
+#define SERCOM_I2CM_INTFLAG_SB                (1 << 1)
+#define SERCOM_I2CM_INTFLAG_ERROR             (1 << 7)
+#define SERCOM_I2CM_STATUS_BUSERR             (1 << 0)
+#define SERCOM_I2CM_STATUS_ARBLOST            (1 << 1)
+#define SERCOM_I2CM_STATUS_RXNACK             (1 << 2)
+#define SERCOM_I2CM_STATUS_BUSSTATE(x)        ((x) << 4)
+
+// variant co2ampel: SERCOM0/SERCOM2 interrupt hooks
+extern void (*sercom0_handler)(void);
+extern void (*sercom2_handler)(void);
+
+// variant co2ampel: I2C bus arbitration (weak hooks, I2CQueue.cpp overrides them)
+class TwoWire;
+void i2c_bus_acquire(TwoWire *wire);
+void i2c_bus_release(TwoWire *wire);
+
+class I2CBusLock
+{
+public:
+  I2CBusLock(TwoWire *wire) : _wire(wire) { i2c_bus_acquire(_wire); }
+  ~I2CBusLock() { i2c_bus_release(_wire); }
+
+private:
+  TwoWire *_wire;
+};
+
+enum EPioType { PIO_SERCOM = 2 };
+enum IRQn { RTC_IRQn, SERCOM0_IRQn, SERCOM2_IRQn };
+inline void NVIC_EnableIRQ(IRQn) { }
+inline void NVIC_DisableIRQ(IRQn) { }
+inline void NVIC_SetPriority(IRQn, uint32_t) { }
+extern "C" void SysTick_DefaultHandler(void);
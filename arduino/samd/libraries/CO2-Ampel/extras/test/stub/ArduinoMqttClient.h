@@ -0,0 +1,67 @@
+/*
+  Host stub of ArduinoMqttClient. CONNACK arrives stub_mqtt_connect_ms after
+  beginConnect() (never if the broker is down, connectResult() fails after
+  the connection timeout), connect() waits for it, a QoS 1 endMessage()
+  blocks for stub_mqtt_puback_ms like the library waiting for PUBACK. Published payloads end up in
+  stub_mqtt_msgs.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include <string>
+#include <vector>
+
+#define MQTT_CONNECTION_REFUSED            -2
+#define MQTT_CONNECTION_TIMEOUT            -1
+#define MQTT_SUCCESS                        0
+
+extern bool stub_mqtt_broker;               // broker reachable
+extern unsigned long stub_mqtt_connect_ms;  // CONNECT until CONNACK
+extern unsigned long stub_mqtt_puback_ms;   // round trip of a QoS 1 publish
+extern std::vector<std::string> stub_mqtt_msgs; // delivered payloads
+
+class MqttClient : public Client
+{
+public:
+  MqttClient(Client &client) : _client(&client) { }
+  MqttClient(Client *client) : _client(client) { }
+
+  void setId(const char *) { }
+  void setUsernamePassword(const char *, const char *) { }
+  void setKeepAliveInterval(unsigned long) { }
+  void setConnectionTimeout(unsigned long timeout) { _timeout = timeout; }
+
+  int connect(IPAddress, uint16_t port = 1883) { return connect("", port); }
+  int connect(const char *host, uint16_t port = 1883);
+  int beginConnect();
+  int connectResult();
+  uint8_t connected() { return _connected && stub_mqtt_broker; }
+  void stop() { _connected = false; _client->stop(); }
+  int connectError() const { return _error; }
+  void poll() { if (!stub_mqtt_broker) _connected = false; }
+
+  int beginMessage(const char *topic, unsigned long size, bool retain = false, uint8_t qos = 0, bool dup = false);
+  int beginMessage(const char *topic, bool retain = false, uint8_t qos = 0, bool dup = false) { return beginMessage(topic, 0xffffffffL, retain, qos, dup); }
+  int endMessage();
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t *buf, size_t size) { if (!_message) return 0; _payload.append((const char*)buf, size); return size; }
+  using Print::write;
+
+  int available() { return 0; }
+  int read() { return -1; }
+  int read(uint8_t *, size_t) { return -1; }
+  int peek() { return -1; }
+  void flush() { }
+  operator bool() { return true; }
+
+private:
+  Client *_client;
+  bool _connected = false, _message = false;
+  int _error = 0;
+  uint8_t _qos = 0;
+  unsigned long _timeout = 30000;
+  uint64_t _start = 0;
+  std::string _payload;
+};
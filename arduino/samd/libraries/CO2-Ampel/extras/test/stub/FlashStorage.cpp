@@ -0,0 +1,79 @@
+/*
+  Host implementation of FlashClass (FlashStorage library) on the static
+  array of the Flash() macro. Like NOR flash, a write can only clear bits
+  and an erase sets a whole row to 0xFF. stub_flash_budget simulates a
+  power loss: once that many bytes are written, the rest is dropped.
+*/
+
+#include <FlashStorage.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "flash.h"
+
+long stub_flash_budget = -1; // bytes until power loss, -1 = no power loss
+unsigned long stub_flash_writes = 0, stub_flash_erases = 0; // pages, rows
+
+FlashClass::FlashClass(const void *flash_addr, uint32_t size) :
+  PAGE_SIZE(64),
+  PAGES(4096),
+  MAX_FLASH(PAGE_SIZE * PAGES),
+  ROW_SIZE(PAGE_SIZE * 4),
+  flash_address((volatile void *)flash_addr),
+  flash_size(size)
+{
+  // the array is const (.rodata), make it writable like the NVM controller does
+  uintptr_t page = sysconf(_SC_PAGESIZE);
+  uintptr_t start = (uintptr_t)flash_addr & ~(page - 1);
+  uintptr_t end = ((uintptr_t)flash_addr + size + page - 1) & ~(page - 1);
+  if (size != 0) {
+    mprotect((void *)start, end - start, PROT_READ | PROT_WRITE);
+  }
+}
+
+void FlashClass::write(const volatile void *flash_ptr, const void *data, uint32_t size)
+{
+  volatile uint8_t *dst = (volatile uint8_t *)flash_ptr;
+  const uint8_t *src = (const uint8_t *)data;
+
+  size = (size + 3) / 4 * 4; // whole words
+  for (uint32_t i = 0; i < size; i++) {
+    if (stub_flash_budget == 0) {
+      return; // power lost
+    }
+    if (stub_flash_budget > 0) {
+      stub_flash_budget--;
+    }
+    dst[i] &= src[i];
+    if (((uintptr_t)&dst[i] % PAGE_SIZE) == (PAGE_SIZE - 1) || i == size - 1) {
+      stub_flash_writes++;
+      stub_advance(2500); // page write, CPU stalls
+    }
+  }
+}
+
+void FlashClass::erase(const volatile void *flash_ptr, uint32_t size)
+{
+  const uint8_t *ptr = (const uint8_t *)flash_ptr;
+
+  while (size > ROW_SIZE) {
+    erase(ptr);
+    ptr += ROW_SIZE;
+    size -= ROW_SIZE;
+  }
+  erase(ptr);
+}
+
+void FlashClass::erase(const volatile void *flash_ptr)
+{
+  if (stub_flash_budget == 0) {
+    return;
+  }
+  memset((void *)flash_ptr, 0xFF, ROW_SIZE);
+  stub_flash_erases++;
+  stub_advance(6000); // row erase
+}
+
+void FlashClass::read(const volatile void *flash_ptr, void *data, uint32_t size)
+{
+  memcpy(data, (const void *)flash_ptr, size);
+}
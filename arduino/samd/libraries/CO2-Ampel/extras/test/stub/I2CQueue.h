@@ -0,0 +1,66 @@
+/*
+  Host stub of I2CQueue. Transfers complete at once (on the target they run
+  in the interrupt and do not block loop()) and go to the slave models of
+  the Wire stub, probe() acknowledges the addresses in stub_i2c_devices.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define I2C_OK           0
+#define I2C_PENDING      1
+#define I2C_ERR_NACK    -1
+#define I2C_ERR_BUS     -2
+#define I2C_ERR_TIMEOUT -3
+
+#define I2C_TIMEOUT 100
+
+struct I2CTransfer {
+  uint8_t addr;
+  uint8_t headLen;
+  const uint8_t *head;
+  const uint8_t *tx;
+  uint8_t *rx;
+  uint16_t txLen, rxLen;
+  volatile int8_t status;
+  void (*done)(I2CTransfer *t);
+  void *arg;
+  I2CTransfer *next;
+};
+
+class I2CQueue {
+public:
+  I2CQueue(Sercom *, TwoWire *) { }
+  void begin() { }
+  void end() { }
+  bool submit(I2CTransfer *t)
+  {
+    StubI2CDevice *dev = stub_i2c_model[t->addr & 0x7F];
+
+    t->status = stub_i2c_devices[t->addr & 0x7F] ? I2C_OK : I2C_ERR_NACK;
+    if (t->status == I2C_OK && dev != NULL && (t->headLen + t->txLen) != 0) {
+      std::string tx((const char*)t->head, t->headLen);
+      tx.append((const char*)t->tx, t->txLen);
+      t->status = dev->write((const uint8_t*)tx.data(), tx.size()) ? I2C_OK : I2C_ERR_NACK;
+    }
+    if (t->status == I2C_OK && t->rxLen != 0) {
+      memset(t->rx, 0, t->rxLen);
+      if (dev != NULL && dev->read(t->rx, t->rxLen) == 0) {
+        t->status = I2C_ERR_NACK;
+      }
+    }
+    if (t->done != NULL) {
+      t->done(t);
+    }
+    return true;
+  }
+  void service() { }
+  bool wait(uint32_t = 1000) { return true; }
+  void acquire() { }
+  void release() { }
+  bool probe(uint8_t addr) { stub_advance(100); return stub_i2c_devices[addr & 0x7F]; }
+  bool busy() { return false; }
+  uint32_t errors() { return 0; }
+};
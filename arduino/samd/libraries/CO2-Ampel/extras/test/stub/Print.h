@@ -0,0 +1,7 @@
+/*
+  Host stub of the Arduino core header of the same name.
+*/
+
+#pragma once
+
+#include <Arduino.h>
@@ -0,0 +1,32 @@
+/*
+  Host stub of SPI, transfer() returns the simulated RFM9X version register
+  or calls stub_spi_transfer when a test sets it.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+#define MSBFIRST  1
+
+extern uint8_t stub_spi_rx; // returned by transfer(), 0x12 = SX1276 version
+extern uint8_t (*stub_spi_transfer)(uint8_t data);
+
+class SPISettings
+{
+public:
+  SPISettings(uint32_t, uint8_t, uint8_t) { }
+};
+
+class SPIClass
+{
+public:
+  void begin() { }
+  void end() { }
+  void beginTransaction(SPISettings) { }
+  void endTransaction() { }
+  uint8_t transfer(uint8_t data) { return (stub_spi_transfer != NULL) ? stub_spi_transfer(data) : stub_spi_rx; }
+};
+
+extern SPIClass SPI;
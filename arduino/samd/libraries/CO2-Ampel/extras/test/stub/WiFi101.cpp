@@ -0,0 +1,262 @@
+/*
+  Host stub of WiFi101 and ArduinoMqttClient, see WiFi101.h and
+  ArduinoMqttClient.h.
+*/
+
+#include <WiFi101.h>
+#include <ArduinoMqttClient.h>
+
+StubSocket stub_sock[STUB_SOCKETS];
+int stub_wifi_status = WL_IDLE_STATUS;
+unsigned long stub_wifi_connect_ms = 3000;
+unsigned long stub_tcp_connect_ms = 100;
+unsigned long stub_dns_ms = 20;
+bool stub_tcp_refuse = false;
+unsigned long stub_winc_call_us = 0;
+unsigned long stub_winc_byte_ns = 0;
+WiFiClass WiFi;
+
+static void winc_spi(size_t bytes) // SPI transfer to the WINC1500
+{
+  stub_advance(stub_winc_call_us + (bytes * stub_winc_byte_ns) / 1000);
+}
+
+uint8_t stub_sock_open(void)
+{
+  for (uint8_t s = 0; s < STUB_SOCKETS; s++) {
+    if (!stub_sock[s].used) {
+      stub_sock[s] = StubSocket();
+      stub_sock[s].used = true;
+      stub_sock[s].open = true;
+      return s;
+    }
+  }
+  return STUB_NO_SOCKET;
+}
+
+uint8_t stub_http_open(const char *request)
+{
+  uint8_t s = stub_sock_open();
+
+  if (s != STUB_NO_SOCKET) {
+    stub_sock[s].incoming = true;
+    stub_sock[s].rx = request;
+  }
+  return s;
+}
+
+int WiFiClass::status()
+{
+  if (connecting && stub_wifi_status == WL_IDLE_STATUS && stub_us >= connected_at) {
+    stub_wifi_status = WL_CONNECTED;
+  }
+  if (stub_wifi_status != WL_IDLE_STATUS) {
+    connecting = false; // connected or cancelled by the test
+  }
+  return stub_wifi_status;
+}
+
+int WiFiClass::begin(const char *)
+{
+  if (_timeout == 0) {
+    stub_wifi_status = WL_IDLE_STATUS;
+    connected_at = stub_us + stub_wifi_connect_ms * 1000ULL;
+    connecting = true;
+    return stub_wifi_status;
+  }
+  delay(stub_wifi_connect_ms); // the driver waits for the connection
+  stub_wifi_status = WL_CONNECTED;
+  return stub_wifi_status;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+  if (!beginConnect(ip, port)) {
+    return 0;
+  }
+  delay(stub_tcp_connect_ms);
+  return connectResult() > 0;
+}
+
+int WiFiClient::connect(const char *, uint16_t port)
+{
+  return connect(IPAddress(192, 168, 1, 2), port);
+}
+
+int WiFiClient::beginConnect(IPAddress, uint16_t)
+{
+  stop();
+  sock = stub_sock_open();
+  if (sock == STUB_NO_SOCKET) {
+    return 0;
+  }
+  stub_sock[sock].open = false;
+  stub_sock[sock].outgoing = true;
+  connect_at = stub_us + stub_tcp_connect_ms * 1000ULL;
+  return 1;
+}
+
+int WiFiClient::connectResult()
+{
+  if (sock == STUB_NO_SOCKET) {
+    return -1;
+  }
+  if (stub_us < connect_at) {
+    return 0;
+  }
+  if (stub_tcp_refuse) {
+    stub_sock[sock].used = false;
+    sock = STUB_NO_SOCKET;
+    return -1;
+  }
+  stub_sock[sock].open = true;
+  return 1;
+}
+
+size_t WiFiClient::write(const uint8_t *buf, size_t size)
+{
+  if (sock == STUB_NO_SOCKET || !stub_sock[sock].open) {
+    return 0;
+  }
+  winc_spi(size);
+  stub_sock[sock].tx.append((const char *)buf, size);
+  return size;
+}
+
+int WiFiClient::available()
+{
+  return (sock == STUB_NO_SOCKET) ? 0 : stub_sock[sock].rx.size();
+}
+
+int WiFiClient::read()
+{
+  uint8_t c;
+
+  return (read(&c, 1) == 1) ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t size)
+{
+  if (sock == STUB_NO_SOCKET || stub_sock[sock].rx.empty()) {
+    return -1;
+  }
+  std::string &rx = stub_sock[sock].rx;
+  size_t n = (size < rx.size()) ? size : rx.size();
+  winc_spi(n);
+  memcpy(buf, rx.data(), n);
+  rx.erase(0, n);
+  return n;
+}
+
+int WiFiClient::peek()
+{
+  return (available() > 0) ? (uint8_t)stub_sock[sock].rx[0] : -1;
+}
+
+void WiFiClient::stop()
+{
+  if (sock != STUB_NO_SOCKET) {
+    stub_sock[sock].open = false; // the test reads tx, then frees the socket
+    if (stub_sock[sock].outgoing) {
+      stub_sock[sock].used = false;
+    }
+    sock = STUB_NO_SOCKET;
+  }
+}
+
+uint8_t WiFiClient::connected()
+{
+  return (sock != STUB_NO_SOCKET) && (stub_sock[sock].open || !stub_sock[sock].rx.empty());
+}
+
+WiFiClient WiFiServer::available(uint8_t *)
+{
+  for (uint8_t s = 0; s < STUB_SOCKETS; s++) {
+    if (stub_sock[s].used && stub_sock[s].incoming) {
+      stub_sock[s].incoming = false;
+      return WiFiClient(s);
+    }
+  }
+  for (uint8_t s = 0; s < STUB_SOCKETS; s++) {
+    if (stub_sock[s].used && stub_sock[s].open && !stub_sock[s].rx.empty()) {
+      return WiFiClient(s); // like the WINC1500: a socket with data
+    }
+  }
+  return WiFiClient();
+}
+
+//--- MQTT ---
+
+bool stub_mqtt_broker = true;
+unsigned long stub_mqtt_connect_ms = 300;
+unsigned long stub_mqtt_puback_ms = 50;
+std::vector<std::string> stub_mqtt_msgs;
+
+int MqttClient::connect(const char *host, uint16_t port)
+{
+  int ret;
+
+  if (!_client->connect(host, port) || !beginConnect()) {
+    _error = MQTT_CONNECTION_REFUSED;
+    return 0;
+  }
+  while ((ret = connectResult()) == 0) {
+    delay(1);
+  }
+  return ret > 0;
+}
+
+int MqttClient::beginConnect()
+{
+  if (!_client->connected()) {
+    return 0;
+  }
+  _connected = false;
+  _start = stub_us;
+  return 1;
+}
+
+int MqttClient::connectResult()
+{
+  if (!stub_mqtt_broker) {
+    if ((stub_us - _start) < _timeout * 1000ULL) {
+      return 0;
+    }
+    _error = MQTT_CONNECTION_TIMEOUT; // no CONNACK
+    _client->stop();
+    return -1;
+  }
+  if ((stub_us - _start) < stub_mqtt_connect_ms * 1000ULL) {
+    return 0;
+  }
+  _connected = true;
+  _error = MQTT_SUCCESS;
+  return 1;
+}
+
+int MqttClient::beginMessage(const char *, unsigned long, bool, uint8_t qos, bool)
+{
+  if (!connected()) {
+    return 0;
+  }
+  _qos = qos;
+  _message = true;
+  _payload.clear();
+  return 1;
+}
+
+int MqttClient::endMessage()
+{
+  if (!_message) {
+    return 0;
+  }
+  _message = false;
+  if (!connected()) {
+    return 0;
+  }
+  if (_qos > 0) {
+    delay(stub_mqtt_puback_ms); // the library polls until PUBACK
+  }
+  stub_mqtt_msgs.push_back(_payload);
+  return 1;
+}
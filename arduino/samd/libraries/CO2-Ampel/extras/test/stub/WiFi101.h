@@ -0,0 +1,124 @@
+/*
+  Host stub of WiFi101. Sockets are kept in stub_sock[], a test opens an
+  incoming connection with stub_http_open(), the sketch picks it up through
+  WiFiServer::available(). stub_wifi_status is returned by WiFi.status(),
+  begin() only returns after stub_wifi_connect_ms like the blocking driver,
+  after setTimeout(0) at once, status() then changes to WL_CONNECTED after
+  stub_wifi_connect_ms. The split-phase calls (beginHostByName(),
+  WiFiClient::beginConnect()) complete after stub_dns_ms and
+  stub_tcp_connect_ms of virtual time. Socket reads and writes cost
+  stub_winc_call_us plus stub_winc_byte_ns per byte (default 0).
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+#include <string>
+
+#define SOCKET_BUFFER_MAX_LENGTH 1400
+#define STUB_SOCKETS 7
+#define STUB_NO_SOCKET 255
+
+enum {
+  WL_NO_SHIELD = 255,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL,
+  WL_SCAN_COMPLETED,
+  WL_CONNECTED,
+  WL_CONNECT_FAILED,
+  WL_CONNECTION_LOST,
+  WL_DISCONNECTED,
+  WL_AP_LISTENING,
+  WL_AP_CONNECTED,
+  WL_AP_FAILED,
+};
+
+struct StubSocket {
+  bool used;      // allocated
+  bool open;      // connected, false after stop() or close by the peer
+  bool incoming;  // accepted by the server, not yet returned by available()
+  bool outgoing;  // opened by WiFiClient::connect(), freed by stop()
+  std::string rx; // data to the sketch
+  std::string tx; // data from the sketch
+};
+
+extern StubSocket stub_sock[STUB_SOCKETS];
+extern int stub_wifi_status;             // WiFi.status()
+extern unsigned long stub_wifi_connect_ms; // duration of WiFi.begin()
+extern unsigned long stub_tcp_connect_ms;  // duration of WiFiClient::connect()
+extern unsigned long stub_dns_ms;          // duration of hostByName()
+extern bool stub_tcp_refuse;             // connect() fails
+extern unsigned long stub_winc_call_us;   // SPI time of a socket read()/write() with data, 0 = free
+extern unsigned long stub_winc_byte_ns;   // SPI time per byte read or written
+
+uint8_t stub_sock_open(void);                    // returns STUB_NO_SOCKET if all are in use
+uint8_t stub_http_open(const char *request);     // incoming connection with request data
+
+class WiFiClient : public Client
+{
+public:
+  WiFiClient() : sock(STUB_NO_SOCKET) { }
+  WiFiClient(uint8_t sock) : sock(sock) { }
+  int connect(IPAddress ip, uint16_t port);
+  int connect(const char *host, uint16_t port);
+  int beginConnect(IPAddress ip, uint16_t port);
+  int connectResult();
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t *buf, size_t size);
+  using Print::write;
+  int available();
+  int read();
+  int read(uint8_t *buf, size_t size);
+  int peek();
+  void flush() { }
+  void stop();
+  uint8_t connected();
+  operator bool() { return sock != STUB_NO_SOCKET; }
+  bool operator==(const WiFiClient &other) const { return sock == other.sock; }
+  bool operator!=(const WiFiClient &other) const { return sock != other.sock; }
+private:
+  uint8_t sock;
+  uint64_t connect_at = 0;
+};
+
+class WiFiServer
+{
+public:
+  WiFiServer(uint16_t) { }
+  void begin() { }
+  WiFiClient available(uint8_t *status = NULL);
+};
+
+class WiFiClass
+{
+public:
+  int status();
+  int begin(const char *ssid);
+  int begin(const char *ssid, const char *key) { return begin(ssid); }
+  int beginAP(const char *) { stub_wifi_status = WL_AP_LISTENING; return stub_wifi_status; }
+  void config(IPAddress, IPAddress, IPAddress, IPAddress) { }
+  void disconnect() { stub_wifi_status = WL_DISCONNECTED; }
+  void end() { stub_wifi_status = WL_NO_SHIELD; }
+  void hostname(const char *) { }
+  String firmwareVersion() { return String("19.6.1"); }
+  uint8_t *macAddress(uint8_t *mac) { for (int i = 0; i < 6; i++) mac[i] = 0x10 + i; return mac; }
+  IPAddress localIP() { return IPAddress(192, 168, 1, 42); }
+  IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+  IPAddress gatewayIP() { return IPAddress(192, 168, 1, 1); }
+  int32_t RSSI() { return -60; }
+  unsigned long getTime() { return 1700000000UL + millis() / 1000; }
+  int hostByName(const char *, IPAddress &ip) { delay(stub_dns_ms); ip = IPAddress(192, 168, 1, 2); return 1; }
+  int beginHostByName(const char *) { resolve_at = stub_us + stub_dns_ms * 1000ULL; return 1; }
+  int hostByNameResult(IPAddress &ip) { if (stub_us < resolve_at) return 0; ip = IPAddress(192, 168, 1, 2); return 1; }
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  void lowPowerMode() { }
+  void noLowPowerMode() { }
+
+private:
+  unsigned long _timeout = 60000;
+  uint64_t connected_at = 0, resolve_at = 0;
+  bool connecting = false;
+};
+
+extern WiFiClass WiFi;
@@ -0,0 +1,82 @@
+/*
+  Host stub of Wire. A test can attach a device model to stub_wire_tx, it
+  gets the bytes of each beginTransmission()...endTransmission(). Otherwise
+  the slave models in stub_i2c_model (sensors.cpp) answer, if the address
+  is present in stub_i2c_devices. Each byte costs 9 clocks of bus time.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+class TwoWire;
+
+// returns the endTransmission() status (0 = ACK), not set: NACK
+extern uint8_t (*stub_wire_tx)(TwoWire *wire, uint8_t addr, const uint8_t *data, size_t len);
+
+// I2C slave, used by Wire and the I2CQueue stub
+class StubI2CDevice
+{
+public:
+  virtual bool write(const uint8_t *data, size_t len) = 0; // false: NACK
+  virtual size_t read(uint8_t *data, size_t len) = 0;      // 0: address NACK
+};
+
+extern bool stub_i2c_devices[128];           // devices answering their address
+extern StubI2CDevice *stub_i2c_model[128];   // slave models, NULL: ACK only
+
+class TwoWire : public Stream
+{
+public:
+  void begin() { }
+  void end() { }
+  void setClock(uint32_t clock) { _clock = clock; }
+  void beginTransmission(uint8_t addr) { tx_addr = addr; tx.clear(); }
+  uint8_t endTransmission(bool = true)
+  {
+    uint8_t ret;
+
+    bus_time(tx.size() + 1);
+    if (stub_wire_tx != NULL) {
+      ret = stub_wire_tx(this, tx_addr, (const uint8_t*)tx.data(), tx.size());
+    } else if (!stub_i2c_devices[tx_addr & 0x7F]) {
+      ret = 2;
+    } else if (stub_i2c_model[tx_addr & 0x7F] != NULL) {
+      ret = stub_i2c_model[tx_addr & 0x7F]->write((const uint8_t*)tx.data(), tx.size()) ? 0 : 3;
+    } else {
+      ret = 0;
+    }
+    tx.clear();
+    return ret;
+  }
+  uint8_t requestFrom(uint8_t addr, size_t len, bool = true)
+  {
+    StubI2CDevice *dev = stub_i2c_devices[addr & 0x7F] ? stub_i2c_model[addr & 0x7F] : NULL;
+
+    rx_len = rx_pos = 0;
+    if (len > sizeof(rx)) {
+      len = sizeof(rx);
+    }
+    if (dev != NULL) {
+      rx_len = dev->read(rx, len);
+    }
+    bus_time(rx_len + 1);
+    return rx_len;
+  }
+  size_t write(uint8_t c) { tx += (char)c; return 1; }
+  using Print::write;
+  int available() { return rx_len - rx_pos; }
+  int read() { return (rx_pos < rx_len) ? rx[rx_pos++] : -1; }
+  int peek() { return (rx_pos < rx_len) ? rx[rx_pos] : -1; }
+
+private:
+  void bus_time(size_t bytes) { stub_advance((bytes * 9 * 1000000ULL) / _clock); }
+
+  uint8_t tx_addr = 0;
+  std::string tx;
+  uint8_t rx[32];
+  size_t rx_len = 0, rx_pos = 0;
+  uint32_t _clock = 100000;
+};
+
+extern TwoWire Wire, Wire1;
@@ -0,0 +1,4 @@
+#pragma once
+
+extern long stub_flash_budget;                          // bytes until power loss, -1 = no power loss
+extern unsigned long stub_flash_writes, stub_flash_erases; // pages, rows
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <lmic.h>
+
+#define NUM_DIO 3
+
+struct lmic_pinmap {
+  u1_t nss;
+  u1_t rxtx;
+  u1_t rst;
+  u1_t dio[NUM_DIO];
+};
+
+const u1_t LMIC_UNUSED_PIN = 0xff;
+
+extern const lmic_pinmap lmic_pins;
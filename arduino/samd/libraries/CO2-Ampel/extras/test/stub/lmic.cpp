@@ -0,0 +1,93 @@
+/*
+  Host stub of LMIC, see lmic.h.
+*/
+
+#include <lmic.h>
+
+lmic_t LMIC;
+unsigned long stub_lora_rx_ms = 2500; // RX2 ends about 2.5s after TX start at SF7
+unsigned long stub_lora_tx = 0;
+unsigned long stub_lora_gap_max = 0;
+static unsigned long stub_lora_t_tx = 0, stub_lora_t_run = 0;
+
+__attribute__((weak)) void onEvent(ev_t) //sketch without LORA
+{
+}
+
+void os_init(void)
+{
+}
+
+void os_runloop_once(void)
+{
+  unsigned long t = micros();
+
+  if (LMIC.opmode & OP_TXRXPEND) {
+    if ((t - stub_lora_t_run) > stub_lora_gap_max) {
+      stub_lora_gap_max = t - stub_lora_t_run;
+    }
+    if ((t - stub_lora_t_tx) >= (stub_lora_rx_ms * 1000UL)) {
+      LMIC.opmode &= ~OP_TXRXPEND;
+      onEvent(EV_TXCOMPLETE);
+    }
+  }
+  stub_lora_t_run = t;
+}
+
+void LMIC_reset(void)
+{
+  LMIC.opmode = OP_NONE;
+}
+
+void LMIC_setSession(u4_t, devaddr_t, xref2u1_t, xref2u1_t)
+{
+}
+
+bit_t LMIC_setupChannel(u1_t, u4_t, u2_t, s1_t)
+{
+  return 1;
+}
+
+void LMIC_setLinkCheckMode(bit_t)
+{
+}
+
+void LMIC_setDrTxpow(dr_t dr, s1_t)
+{
+  LMIC.datarate = dr;
+}
+
+int LMIC_setTxData2(u1_t, xref2u1_t data, u1_t dlen, u1_t)
+{
+  if (LMIC.opmode & OP_TXRXPEND) {
+    return -1;
+  }
+  memcpy(LMIC.frame, data, dlen);
+  LMIC.dataLen = dlen;
+  LMIC.opmode |= OP_TXRXPEND;
+  stub_lora_t_tx = stub_lora_t_run = micros();
+  stub_lora_tx++;
+  return 0;
+}
+
+rps_t updr2rps(dr_t dr)
+{
+  return dr;
+}
+
+// LoRa time on air (SX1276 data sheet), CR 4/5, explicit header, CRC,
+// 8 symbols preamble, low data rate optimization for SF11/SF12
+ostime_t calcAirTime(rps_t rps, u1_t plen)
+{
+  if (rps >= DR_FSK) {
+    return us2osticks((plen + 8) * 8 * 20); // 50kbit/s
+  }
+  int sf = (rps == DR_SF7B) ? 7 : 12 - rps;
+  int bw = (rps == DR_SF7B) ? 250000 : 125000;
+  int de = (sf >= 11) ? 1 : 0;
+  int n = 8 * plen - 4 * sf + 28 + 16;
+  int sym = 8 + ((n > 0) ? ((n + 4 * (sf - 2 * de) - 1) / (4 * (sf - 2 * de))) * 5 : 0);
+  int64_t tsym = ((int64_t)1000000 << sf) / bw; // us
+
+  return us2osticks((sym + 12.25) * tsym);
+}
@@ -0,0 +1,66 @@
+/*
+  Host stub of LMIC (EU868). LMIC_setTxData2() starts a transaction that
+  ends stub_lora_rx_ms after the uplink (TX airtime, RX1, RX2) with
+  EV_TXCOMPLETE from os_runloop_once(). stub_lora_gap_max records the
+  longest time between two os_runloop_once() calls while OP_TXRXPEND is
+  set, the real stack misses its RX windows if that gets too long.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+
+typedef uint8_t  u1_t;
+typedef int8_t   s1_t;
+typedef uint16_t u2_t;
+typedef int16_t  s2_t;
+typedef uint32_t u4_t;
+typedef int32_t  s4_t;
+typedef uint8_t  bit_t;
+typedef u1_t     dr_t;
+typedef u2_t     rps_t;
+typedef u4_t     devaddr_t;
+typedef s4_t     ostime_t;
+typedef u1_t    *xref2u1_t;
+
+#define OSTICKS_PER_SEC  32768
+#define osticks2us(os)   ((s4_t)(((os)*(int64_t)1000000) / OSTICKS_PER_SEC))
+#define us2osticks(us)   ((ostime_t)(((int64_t)(us) * OSTICKS_PER_SEC) / 1000000))
+
+enum { OP_NONE = 0x0000, OP_TXDATA = 0x0008, OP_TXRXPEND = 0x0080 };
+enum _ev_t { EV_SCAN_TIMEOUT = 1, EV_BEACON_FOUND, EV_BEACON_MISSED, EV_BEACON_TRACKED, EV_JOINING,
+             EV_JOINED, EV_RFU1, EV_JOIN_FAILED, EV_REJOIN_FAILED, EV_TXCOMPLETE, EV_LOST_TSYNC,
+             EV_RESET, EV_RXCOMPLETE, EV_LINK_DEAD, EV_LINK_ALIVE };
+typedef enum _ev_t ev_t;
+enum _dr_eu868_t { DR_SF12 = 0, DR_SF11, DR_SF10, DR_SF9, DR_SF8, DR_SF7, DR_SF7B, DR_FSK, DR_NONE };
+enum { BAND_MILLI = 0, BAND_CENTI = 1, BAND_DECI = 2, BAND_AUX = 3 };
+#define DR_RANGE_MAP(drlo, drhi) (((u2_t)0xFFFF << (drlo)) & ((u2_t)0xFFFF >> (15 - (drhi))))
+
+struct lmic_t {
+  u2_t opmode;
+  dr_t datarate;
+  dr_t dn2Dr;
+  u1_t dataLen;
+  u1_t frame[64];
+};
+extern lmic_t LMIC;
+
+extern unsigned long stub_lora_rx_ms;   // end of the transaction after TX start
+extern unsigned long stub_lora_tx;      // uplinks sent
+extern unsigned long stub_lora_gap_max; // us, longest gap between os_runloop_once() while pending
+
+void os_init(void);
+void os_runloop_once(void);
+void LMIC_reset(void);
+void LMIC_setSession(u4_t netid, devaddr_t devaddr, xref2u1_t nwkKey, xref2u1_t artKey);
+bit_t LMIC_setupChannel(u1_t channel, u4_t freq, u2_t drmap, s1_t band);
+void LMIC_setLinkCheckMode(bit_t enabled);
+void LMIC_setDrTxpow(dr_t dr, s1_t txpow);
+int LMIC_setTxData2(u1_t port, xref2u1_t data, u1_t dlen, u1_t confirmed);
+rps_t updr2rps(dr_t dr);
+ostime_t calcAirTime(rps_t rps, u1_t plen);
+
+void os_getArtEui(u1_t *buf);
+void os_getDevEui(u1_t *buf);
+void os_getDevKey(u1_t *buf);
+void onEvent(ev_t ev);
@@ -0,0 +1,226 @@
+/*
+  I2C slave models of the CO2 sensors, see sensors.h.
+*/
+
+#include "sensors.h"
+
+Scd30Slave stub_scd30;
+Scd4xSlave stub_scd4x;
+
+uint8_t stub_crc8(const uint8_t *data) //Polynom 0x31, Startwert 0xFF
+{
+  uint8_t crc = 0xFF;
+
+  for (int i = 0; i < 2; i++) {
+    crc ^= data[i];
+    for (int b = 0; b < 8; b++) {
+      crc = (crc & 0x80) ? ((crc << 1) ^ 0x31) : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+//--- Sensirion ---
+
+size_t SensirionSlave::read(uint8_t *data, size_t len)
+{
+  size_t n = 0;
+
+  for (unsigned int i = 0; i < words && n < len; i++) {
+    uint8_t w[3] = { (uint8_t)(word[i] >> 8), (uint8_t)word[i], 0 };
+    w[2] = stub_crc8(w);
+    for (int j = 0; j < 3 && n < len; j++) {
+      data[n++] = w[j];
+    }
+  }
+  words = 0; //Antwort nur einmal
+  return n;
+}
+
+bool SensirionSlave::command(const uint8_t *data, size_t len, uint16_t *cmd, uint16_t *arg)
+{
+  if (len < 2) {
+    return false;
+  }
+  *cmd = (data[0] << 8) | data[1];
+  if (len >= 5) {
+    if (stub_crc8(&data[2]) != data[4]) {
+      return false;
+    }
+    *arg = (data[2] << 8) | data[3];
+  }
+  words = 0;
+  return true;
+}
+
+//--- SCD30 ---
+
+bool Scd30Slave::write(const uint8_t *data, size_t len)
+{
+  uint16_t cmd, arg = 0;
+
+  if (!command(data, len, &cmd, &arg)) {
+    return false;
+  }
+  switch (cmd) {
+    case 0x0010: //start continuous measurement, Druck
+      if (!running) {
+        t_read = millis();
+      }
+      running = true;
+      pressure = arg;
+      break;
+    case 0x0104: //stop
+      running = false;
+      break;
+    case 0x4600: //measurement interval
+      if (len >= 5) {
+        interval = arg;
+      }
+      respond(interval);
+      break;
+    case 0x0202: //data ready
+      respond(ready() ? 1 : 0);
+      break;
+    case 0x0300: //read measurement
+      if (ready()) {
+        t_read = millis();
+        reads++;
+        put(stub_co2);
+        put(stub_temp);
+        put(stub_humi);
+      }
+      break;
+    case 0x5306: //ASC
+      if (len >= 5) {
+        asc = arg;
+      }
+      respond(asc);
+      break;
+    case 0x5204: //FRC
+      if (len >= 5) {
+        frc = arg;
+      }
+      respond(frc);
+      break;
+    case 0x5403: //temperature offset
+      if (len >= 5) {
+        offset = arg;
+      }
+      respond(offset);
+      break;
+    case 0x5102: //altitude
+      if (len >= 5) {
+        altitude = arg;
+      }
+      respond(altitude);
+      break;
+    case 0xD100: //firmware
+      respond(0x0342);
+      break;
+    case 0xD304: //soft reset
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+void Scd30Slave::put(float f)
+{
+  uint32_t u;
+
+  memcpy(&u, &f, sizeof(u));
+  respond(u >> 16);
+  respond(u & 0xFFFF);
+}
+
+//--- SCD4x ---
+
+bool Scd4xSlave::write(const uint8_t *data, size_t len)
+{
+  uint16_t cmd, arg = 0;
+  unsigned int ms = 1;
+
+  if (busy() || !command(data, len, &cmd, &arg)) {
+    violations++;
+    return false;
+  }
+  if (periodic && cmd != 0xEC05 && cmd != 0x3F86 && cmd != 0xE000) { //im Messbetrieb nur Lesen, Stop und Druck
+    violations++;
+    return false;
+  }
+  switch (cmd) {
+    case 0x21B1: //start periodic measurement
+      ms = 0;
+      periodic = measuring = true;
+      t_meas = millis();
+      break;
+    case 0xEC05: //read measurement
+      if (ready()) {
+        uint16_t t = (uint16_t)((stub_temp + 45) * 65536 / 175);
+        uint16_t h = (uint16_t)(stub_humi * 65536 / 100);
+        reads++;
+        respond((uint16_t)stub_co2);
+        respond(t);
+        respond(h);
+        t_meas = millis();
+        measuring = periodic;
+      }
+      break;
+    case 0x3F86: //stop periodic measurement
+      ms = 500;
+      periodic = measuring = false;
+      break;
+    case 0xE000: //set ambient pressure
+      pressure = arg;
+      break;
+    case 0x241D: //set temperature offset
+      offset = arg;
+      break;
+    case 0x2318: //get temperature offset
+      respond(offset);
+      break;
+    case 0x2427: //set sensor altitude
+      altitude = arg;
+      break;
+    case 0x2322: //get sensor altitude
+      respond(altitude);
+      break;
+    case 0x2416: //set automatic self calibration
+      asc = arg;
+      break;
+    case 0x2313: //get automatic self calibration
+      respond(asc);
+      break;
+    case 0x362F: //perform forced recalibration
+      ms = 400;
+      frc = arg;
+      respond(0x8000 + (int16_t)(arg - (uint16_t)stub_co2));
+      break;
+    case 0x219D: //measure single shot
+      ms = 5000;
+      measuring = true;
+      t_meas = millis();
+      break;
+    case 0x3615: //persist settings
+      ms = 800;
+      break;
+    case 0x36E0: //power down
+    case 0x36F6: //wake up
+      break;
+    default:
+      violations++;
+      return false;
+  }
+  busy_until = stub_us + ms * 1000ULL;
+  return true;
+}
+
+size_t Scd4xSlave::read(uint8_t *data, size_t len)
+{
+  if (busy() || words == 0) { //NACK: Befehl laeuft noch oder keine neuen Messwerte
+    return 0;
+  }
+  return SensirionSlave::read(data, len);
+}
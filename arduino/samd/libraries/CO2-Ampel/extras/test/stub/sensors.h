@@ -0,0 +1,80 @@
+/*
+  I2C slave models of the CO2 sensors for the Wire and I2CQueue stubs,
+  the real drivers and the sketch talk to them byte by byte. They measure
+  the simulated air (stub_co2, ...) and follow the interface descriptions:
+  16-bit words with Sensirion CRC-8, the response belongs to the last
+  command.
+
+  SCD30 (0x61): a new measurement every measurement interval after
+  start continuous measurement, data ready 0x0202, read measurement 0x0300
+  (CO2, temperature, humidity as big-endian float).
+
+  SCD4x (0x62): periodic measurement every 5s, single shot after 5s. While
+  a command executes (data sheet execution time) the sensor does not
+  acknowledge its address. Commands not allowed during periodic
+  measurement are not acknowledged either, both count as violations.
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+extern float stub_co2, stub_temp, stub_humi, stub_pres; // simulated air
+
+uint8_t stub_crc8(const uint8_t *data); // Sensirion CRC-8 of a 16-bit word
+
+class SensirionSlave : public StubI2CDevice
+{
+public:
+  size_t read(uint8_t *data, size_t len);
+
+protected:
+  bool command(const uint8_t *data, size_t len, uint16_t *cmd, uint16_t *arg); // false: CRC error
+  void respond(uint16_t w) { word[words++] = w; }
+
+  uint16_t word[9];
+  unsigned int words = 0;
+};
+
+class Scd30Slave : public SensirionSlave
+{
+public:
+  Scd30Slave() { stub_i2c_model[0x61] = this; }
+  bool write(const uint8_t *data, size_t len);
+
+  unsigned long reads = 0;
+  uint16_t pressure = 0;
+
+private:
+  bool ready() { return running && (millis() - t_read) >= interval * 1000UL; }
+  void put(float f);
+
+  bool running = false;
+  unsigned long t_read = 0;
+  uint16_t interval = 2, asc = 0, frc = 400, offset = 0, altitude = 0;
+};
+
+class Scd4xSlave : public SensirionSlave
+{
+public:
+  Scd4xSlave() { stub_i2c_model[0x62] = this; }
+  bool write(const uint8_t *data, size_t len);
+  size_t read(uint8_t *data, size_t len);
+
+  bool busy() { return stub_us < busy_until; }
+
+  bool periodic = false;
+  unsigned long reads = 0, violations = 0;
+  uint16_t offset = 1489, altitude = 0, pressure = 1013, asc = 1, frc = 0; // offset: 4 Grad C (Werkseinstellung)
+
+private:
+  bool ready() { return measuring && (millis() - t_meas) >= 5000; }
+
+  bool measuring = false;
+  unsigned long t_meas = 0;
+  uint64_t busy_until = 0;
+};
+
+extern Scd30Slave stub_scd30;
+extern Scd4xSlave stub_scd4x;
@@ -0,0 +1,5 @@
+/*
+  Empty: Adafruit_SSD1306 includes it on every non-ARM target.
+*/
+
+#pragma once
@@ -0,0 +1,35 @@
+/*
+  Minimal test helpers: CHECK() reports the failed condition with its line
+  and counts it, test_done() returns the exit code.
+*/
+
+#pragma once
+
+#include <stdio.h>
+
+static int test_failed = 0, test_checks = 0;
+
+#define CHECK(cond) \
+  do { \
+    test_checks++; \
+    if (!(cond)) { \
+      test_failed++; \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+    } \
+  } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    long long _a = (a), _b = (b); \
+    test_checks++; \
+    if (_a != _b) { \
+      test_failed++; \
+      printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+    } \
+  } while (0)
+
+static int test_done(void)
+{
+  printf("%d checks, %d failed\n", test_checks, test_failed);
+  return (test_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+/*
+  LMIC AES backend with cached key schedules (LMIC/src/aes/cached.c):
+  FIPS-197 and RFC 4493 (CMAC) vectors, and the same results as the
+  original LMIC backend (aes/lmic.c, linked as ref_os_aes) for random
+  frames with alternating keys.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+
+#define AES_ENC      0x00
+#define AES_MIC      0x02
+#define AES_CTR      0x04
+#define AES_MICNOAUX 0x08
+
+extern "C" {
+  uint32_t os_aes(uint8_t mode, uint8_t *buf, uint16_t len);
+  uint32_t ref_os_aes(uint8_t mode, uint8_t *buf, uint16_t len);
+  extern uint32_t AESKEY[4], AESAUX[4], REF_AESKEY[4], REF_AESAUX[4];
+
+  //aus lmic.c
+  uint32_t os_rmsbf4(const uint8_t *buf)
+  {
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+  }
+
+  void os_wmsbf4(uint8_t *buf, uint32_t v)
+  {
+    buf[0] = v >> 24;
+    buf[1] = v >> 16;
+    buf[2] = v >> 8;
+    buf[3] = v;
+  }
+}
+
+static void hex(uint8_t *dst, const char *s)
+{
+  for (; s[0] && s[1]; s += 2) {
+    unsigned int b;
+    sscanf(s, "%2x", &b);
+    *dst++ = b;
+  }
+}
+
+static bool equal(const void *a, const char *s)
+{
+  uint8_t b[64];
+
+  hex(b, s);
+  return memcmp(a, b, strlen(s)/2) == 0;
+}
+
+static void test_vectors(void)
+{
+  uint8_t buf[64], msg[64];
+
+  //FIPS-197 C.1
+  hex((uint8_t*)AESKEY, "000102030405060708090a0b0c0d0e0f");
+  hex(buf, "00112233445566778899aabbccddeeff");
+  os_aes(AES_ENC, buf, 16);
+  CHECK(equal(buf, "69c4e0d86a7b0430d8cdb78070b4c55a"));
+
+  //RFC 4493: CMAC ohne AESAUX (Join), Laenge 0, 16, 40, 64
+  static const struct { unsigned int len; const char *tag; } cmac[] = {
+    {  0, "bb1d6929e95937287fa37d129b756746" },
+    { 16, "070a16b46b4d4144f79bdd9dd04a287c" },
+    { 40, "dfa66747de9ae63030ca32611497c827" },
+    { 64, "51f0bebf7e3b9d92fc49741779363cfe" },
+  };
+  hex((uint8_t*)AESKEY, "2b7e151628aed2a6abf7158809cf4f3c");
+  hex(msg, "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+           "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+  for (unsigned int i = 0; i < sizeof(cmac)/sizeof(cmac[0]); i++) {
+    memcpy(buf, msg, cmac[i].len);
+    uint32_t mic = os_aes(AES_MIC|AES_MICNOAUX, buf, cmac[i].len);
+    CHECK(equal(AESAUX, cmac[i].tag));
+    CHECK_EQ(mic, os_rmsbf4((uint8_t*)AESAUX));
+  }
+
+  //mit AESAUX (B0-Block): erster Block der Nachricht in AESAUX
+  memcpy(AESAUX, msg, 16);
+  memcpy(buf, msg+16, 24);
+  os_aes(AES_MIC, buf, 24);
+  CHECK(equal(AESAUX, cmac[2].tag));
+}
+
+static uint32_t rnd = 1;
+
+static uint8_t rnd8(void)
+{
+  rnd = rnd * 1103515245 + 12345;
+  return rnd >> 16;
+}
+
+static void test_reference(void) //wie LMIC: AppSKey fuer die Nutzdaten, NwkSKey fuer den MIC, gelegentlich neue Schluessel
+{
+  uint8_t keys[3][16], aux[16], frame[64] = { }, ref[64] = { };
+  unsigned int bad = 0;
+
+  for (unsigned int k = 0; k < 3; k++) {
+    for (unsigned int i = 0; i < 16; i++) {
+      keys[k][i] = rnd8();
+    }
+  }
+  for (int n = 0; n < 2000; n++) {
+    unsigned int len = rnd8() % 60, key = (rnd8() % 8 == 0) ? 2 : 0;
+    uint32_t mic, mic_ref;
+
+    if (rnd8() % 50 == 0) { //neue Session
+      keys[rnd8() % 3][rnd8() % 16] ^= 1;
+    }
+    for (unsigned int i = 0; i < 16; i++) {
+      aux[i] = rnd8();
+    }
+    for (unsigned int i = 0; i < len; i++) {
+      frame[i] = ref[i] = rnd8();
+    }
+
+    //CTR (Nutzdaten)
+    memcpy(AESKEY, keys[key], 16);  memcpy(AESAUX, aux, 16);
+    memcpy(REF_AESKEY, keys[key], 16);  memcpy(REF_AESAUX, aux, 16);
+    os_aes(AES_CTR, frame, len);
+    ref_os_aes(AES_CTR, ref, len);
+    if (memcmp(frame, ref, len) != 0) {
+      bad++;
+    }
+
+    //MIC (ab 1 Byte, die alten Backends rechnen die leere Nachricht falsch)
+    memcpy(AESKEY, keys[1], 16);  memcpy(AESAUX, aux, 16);
+    memcpy(REF_AESKEY, keys[1], 16);  memcpy(REF_AESAUX, aux, 16);
+    mic = os_aes(AES_MIC, frame, len+1);
+    mic_ref = ref_os_aes(AES_MIC, ref, len+1);
+    if (mic != mic_ref) {
+      bad++;
+    }
+
+    //Join: ENC und MIC ohne AESAUX mit dem DevKey
+    memcpy(AESKEY, keys[2], 16);
+    memcpy(REF_AESKEY, keys[2], 16);
+    os_aes(AES_ENC, frame, 32);
+    ref_os_aes(AES_ENC, ref, 32);
+    if (memcmp(frame, ref, 32) != 0) {
+      bad++;
+    }
+    memcpy(AESKEY, keys[2], 16);
+    memcpy(REF_AESKEY, keys[2], 16);
+    if (os_aes(AES_MIC|AES_MICNOAUX, frame, len+1) != ref_os_aes(AES_MIC|AES_MICNOAUX, ref, len+1)) {
+      bad++;
+    }
+  }
+  CHECK_EQ(bad, 0);
+}
+
+int main()
+{
+  test_vectors();
+  test_reference();
+
+  return test_done();
+}
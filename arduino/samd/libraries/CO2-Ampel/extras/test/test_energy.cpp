@@ -0,0 +1,86 @@
+/*
+  Energy model of the battery mode (LOW_POWER): average current on the
+  3.3 V rail per configuration, from the duty cycle of low_power() and
+  typical currents of the data sheets. The Makefile passes the
+  LOW_POWER_*, HELLIGKEIT and NUM_LEDS values of the sketch, the table
+  also shows other intervals. Prints the figures and checks the
+  LOW_POWER_SCD4X break-even interval given in the sketch.
+*/
+
+#include <stdio.h>
+#include "test.h"
+
+//Stroeme in mA (typisch), Ladungen in mAs
+#define MCU_RUN      7.0    //SAMD21 48MHz aktiv
+#define MCU_STBY     0.004  //SAMD21 STANDBY mit RTC
+#define WINC_ON     35.0    //WINC1500 verbunden, Mittelwert mit Power-Save
+#define WINC_OFF     0.004  //WINC1500 Chip Enable aus (WiFi.end())
+#define SCD_PERIODIC 15.0   //SCD41 periodische Messung
+#define SCD_SHOT    75.0    //SCD41 Einzelmessung, mAs pro Messung
+#define SCD_IDLE     0.2    //SCD41 Idle
+#define SCD_SLEEP    0.001  //SCD41 power down
+#define LED_IDLE     0.6    //WS2812 pro LED, auch aus (keine Abschaltung auf der Platine)
+#define LED_CHANNEL 12.0    //WS2812 pro LED und Farbe bei 100%, gruen = 1 Farbe
+#define OLED_ON      8.0    //SSD1306 an
+#define OLED_OFF     0.01   //SSD1306 DISPLAYOFF
+#define AWAKE        0.06   //s aktiv pro Messung (I2C, Druck, Ampel, Display)
+#define CATCH_UP     0.0004 //s aktiv pro s Standby: millis() nachfuehren (SysTick_DefaultHandler() je ms)
+
+static double leds_on(void) //mA, Ampel gruen
+{
+  return NUM_LEDS * LED_CHANNEL * HELLIGKEIT / 255.0;
+}
+
+static double normal(bool wifi) //mA, Normalbetrieb
+{
+  return MCU_RUN + SCD_PERIODIC + (wifi ? WINC_ON : WINC_OFF) + NUM_LEDS * LED_IDLE + leds_on() + OLED_ON;
+}
+
+//mA im Standby-Betrieb: alle interval s eine Messung, show s Anzeige, scd_off: LOW_POWER_SCD4X
+static double low_power(unsigned int interval, unsigned int show, bool scd_off)
+{
+  double q = 0; //mAs pro Messintervall
+
+  q += (scd_off ? 2 : 1) * SCD_SHOT; //nach dem Aufwachen eine Messung verwerfen
+  q += (scd_off ? SCD_SLEEP : SCD_IDLE) * interval;
+  q += MCU_RUN * (AWAKE + CATCH_UP * interval) + MCU_STBY * interval;
+  q += NUM_LEDS * LED_IDLE * interval + leds_on() * show;
+  q += OLED_ON * show + OLED_OFF * (interval - show);
+  q += WINC_OFF * interval;
+  return q / interval;
+}
+
+int main()
+{
+  static const unsigned int intervals[] = { 60, 300, 600, 1800 };
+  double config = low_power(LOW_POWER_INTERVALL, LOW_POWER_ANZEIGE, LOW_POWER_SCD4X);
+  unsigned int even = 0;
+
+  printf("normal with WiFi:    %5.1f mA\n", normal(true));
+  printf("normal without WiFi: %5.1f mA\n", normal(false));
+  printf("LOW_POWER_INTERVALL %u, LOW_POWER_ANZEIGE %u, LOW_POWER_SCD4X %u: %.2f mA\n",
+         LOW_POWER_INTERVALL, LOW_POWER_ANZEIGE, LOW_POWER_SCD4X, config);
+  printf("interval  display 2s  display 2s, SCD4X off  display off  display off, SCD4X off\n");
+  for (unsigned int i = 0; i < sizeof(intervals)/sizeof(intervals[0]); i++) {
+    unsigned int t = intervals[i];
+    printf("%5us    %6.2f mA   %6.2f mA              %6.2f mA    %6.2f mA\n",
+           t, low_power(t, 2, false), low_power(t, 2, true), low_power(t, 0, false), low_power(t, 0, true));
+  }
+
+  //ab welchem Intervall lohnt LOW_POWER_SCD4X (Sketch: ca. 6min)
+  for (unsigned int t = 10; t <= 3600; t++) {
+    if (low_power(t, LOW_POWER_ANZEIGE, true) < low_power(t, LOW_POWER_ANZEIGE, false)) {
+      even = t;
+      break;
+    }
+  }
+  printf("LOW_POWER_SCD4X pays off from %u s\n", even);
+  CHECK(even >= 5*60 && even <= 7*60);
+
+  //Untergrenze: Ruhestrom der WS2812
+  CHECK(low_power(3600, 0, true) > NUM_LEDS * LED_IDLE);
+  CHECK(low_power(3600, 0, true) < NUM_LEDS * LED_IDLE * 1.2);
+  CHECK(config < normal(false) / 5);
+
+  return test_done();
+}
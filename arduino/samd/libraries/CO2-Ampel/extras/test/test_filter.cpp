@@ -0,0 +1,201 @@
+/*
+  co2_filter() and ampel_level(): a reproducible trace of a class room (one
+  lesson, then an opened window) sampled like the SCD30 (2s) and the SCD4x
+  (5s), with noise and single spikes, is replayed through the filter. Checks the
+  spike rejection of the median, the EMA step response for both sample
+  spacings against the fixed point formula, and that the traffic light
+  does not flap at a threshold. Prints the time per sample on the host.
+*/
+
+#include SKETCH
+#include <sensors.h>
+#include <chrono>
+#include "test.h"
+
+#define TRACE_S    3600 //1h Aufzeichnung
+#define SPIKE      1800 //ppm, einzelne Ausreisser
+#define SPIKE_EVERY  37 //jeder 37. Messwert
+
+static unsigned long rnd = 1;
+
+static int noise(void) //-8...+8 ppm, reproduzierbar
+{
+  rnd = rnd * 1103515245UL + 12345UL;
+  return (int)((rnd >> 16) % 17) - 8;
+}
+
+static double air(unsigned long t) //CO2 im Raum ohne Rauschen, t in s
+{
+  if (t < 40*60) {
+    return 450 + 30.0 * t / 60; //40min Unterricht: 30ppm/min
+  }
+  return 500 + 1150 * exp(-(double)(t - 40*60) / 180); //Fenster auf
+}
+
+static void filter_reset(void)
+{
+  memset(&co2_filter_state, 0, sizeof(co2_filter_state));
+}
+
+static void sample_at(uint64_t t0, unsigned long ms) //virtuelle Uhr auf t0 + ms
+{
+  uint64_t t = t0 + ms * 1000ULL;
+
+  if (t > stub_us) {
+    stub_advance(t - stub_us);
+  }
+}
+
+//Aufzeichnung abspielen, mit und ohne Ausreisser, max. Abweichungen in ppm
+static void replay(unsigned int interval, unsigned int *spike_dev, unsigned int *track_dev)
+{
+  unsigned int clean[TRACE_S/2 + 1], n = 0;
+  uint64_t t0;
+
+  *spike_dev = *track_dev = 0;
+  for (int spikes = 0; spikes < 2; spikes++) {
+    filter_reset();
+    rnd = 1;
+    t0 = stub_us;
+    n = 0;
+    for (unsigned long t = 0; t <= TRACE_S; t += interval, n++) {
+      int raw = (int)(air(t) + 0.5) + noise();
+
+      sample_at(t0, t * 1000UL);
+      if (spikes && (n % SPIKE_EVERY) == SPIKE_EVERY - 1) {
+        raw += SPIKE;
+      }
+      unsigned int out = co2_filter(raw);
+      if (spikes == 0) {
+        clean[n] = out;
+        unsigned int d = fabs(out - air(t));
+        if (d > *track_dev) {
+          *track_dev = d;
+        }
+      } else {
+        unsigned int d = abs((int)out - (int)clean[n]);
+        if (d > *spike_dev) {
+          *spike_dev = d;
+        }
+      }
+    }
+  }
+}
+
+//Sprung 500 -> 1500ppm, Vergleich mit der Festkomma-Formel, Zeit bis 63% und 95%
+static void step(unsigned int interval)
+{
+  unsigned long ms = interval * 1000UL;
+  double a = (double)((ms * 256UL) / (ms + FILTER_TAU*1000UL)) / 256, y = 500;
+  unsigned int t63 = 0, t95 = 0, err = 0;
+  uint64_t t0;
+
+  filter_reset();
+  t0 = stub_us;
+  for (unsigned int i = 0; i < 10; i++) {
+    sample_at(t0, i * ms);
+    co2_filter(500);
+  }
+  t0 = stub_us;
+  for (unsigned int i = 1; i <= 60 / interval; i++) {
+    sample_at(t0, i * ms);
+    unsigned int out = co2_filter(1500);
+    if (i >= FILTER_MEDIAN/2 + 1) { //der Median gibt den Sprung einen Messwert spaeter weiter
+      y += a * (1500 - y);
+    }
+    if (abs((int)out - (int)(y + 0.5)) > (int)err) {
+      err = abs((int)out - (int)(y + 0.5));
+    }
+    if (t63 == 0 && out >= 500 + 632) {
+      t63 = i * interval;
+    }
+    if (t95 == 0 && out >= 500 + 950) {
+      t95 = i * interval;
+    }
+  }
+  printf("step %us: a=%.3f, 63%% after %us, 95%% after %us, max %u ppm from formula\n", interval, a, t63, t95, err);
+  CHECK(err <= 1);
+  CHECK(t63 > 0 && t63 <= FILTER_TAU + 2*interval);
+  CHECK(t95 > 0 && t95 <= 4*FILTER_TAU + 2*interval);
+}
+
+//an der Schwelle zu rot: Messwerte um range[2] +/-10ppm
+static void boundary(unsigned int interval)
+{
+  unsigned int th = settings.range[2], changes = 0, crossings = 0, above, level, last;
+  uint64_t t0;
+
+  for (int i = 0; i < 10; i++) {
+    ampel_level(th - 200); //Ausgangslage gruen/gelb
+  }
+  filter_reset();
+  t0 = stub_us;
+  last = ampel_level(co2_filter(th - 5));
+  above = 0;
+  for (unsigned long t = interval; t <= 30*60; t += interval) {
+    int raw = th + 10 * sin(t / 40.0) + noise();
+
+    sample_at(t0, t * 1000UL);
+    unsigned int out = co2_filter(raw);
+    if ((out >= th) != above) { //Wechsel ohne Hysterese
+      above = (out >= th);
+      crossings++;
+    }
+    level = ampel_level(out);
+    if (level != last) {
+      changes++;
+      last = level;
+    }
+  }
+  printf("threshold %u ppm, %us: %u crossings, %u level changes\n", th, interval, crossings, changes);
+  CHECK(crossings > 4); //ohne Hysterese wuerde die Ampel flattern
+  CHECK(changes <= 1);
+
+  //deutlich unter Schwelle-Hysterese: zurueck
+  for (unsigned long t = 0; t < 120; t += interval) {
+    sample_at(stub_us, interval * 1000UL);
+    level = ampel_level(co2_filter(th - ampel_settings.hysterese[2] - 30));
+  }
+  CHECK(level < 3);
+}
+
+int main()
+{
+  unsigned int spike_dev, track_dev;
+
+  stub_i2c_devices[ADDR_SCD30] = true;
+  setup();
+
+  //Ausreisser: Median verwirft sie, Abweichung zur Aufzeichnung ohne Ausreisser
+  replay(2, &spike_dev, &track_dev);
+  printf("SCD30 2s: spikes +%u ppm change the output by max %u ppm, max %u ppm from the room\n", SPIKE, spike_dev, track_dev);
+  CHECK(spike_dev <= 20);
+  CHECK(track_dev <= 60);
+  replay(5, &spike_dev, &track_dev);
+  printf("SCD4x 5s: spikes +%u ppm change the output by max %u ppm, max %u ppm from the room\n", SPIKE, spike_dev, track_dev);
+  CHECK(spike_dev <= 20);
+  CHECK(track_dev <= 80);
+
+  //Sprungantwort des EMA
+  step(2);
+  step(5);
+
+  //Hysterese
+  boundary(2);
+  boundary(5);
+
+  //Laufzeit pro Messwert (Host)
+  const unsigned long n = 1000000;
+  unsigned int sum = 0;
+  filter_reset();
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long i = 0; i < n; i++) {
+    stub_advance(2000000);
+    sum += co2_filter(600 + (i & 63));
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / n;
+  printf("co2_filter(): %.1f ns per sample (host, FILTER_MEDIAN %d, FILTER_MITTEL %d)\n", ns, FILTER_MEDIAN, FILTER_MITTEL);
+  CHECK(sum > 0);
+
+  return test_done();
+}
@@ -0,0 +1,117 @@
+/*
+  FlashLog on the host flash (stub/FlashStorage.cpp): rotation through the
+  blocks, restart and power loss at every byte of a write.
+*/
+
+#include <FlashLog.h>
+#include "flash.h"
+#include "test.h"
+
+#define LOG_SIZE 8192
+
+FlashLog(flashlog, LOG_SIZE);
+
+static const uint8_t *flash_data = _dataflashlog;
+
+struct settings
+{
+  uint8_t fill[40];
+};
+
+static bool read_latest(uint32_t *value, settings *s) //Neustart: Log neu einlesen
+{
+  FlashLogClass log(flash_data, LOG_SIZE);
+
+  log.begin();
+  return log.read(1, value, sizeof(*value)) && log.read(0, s, sizeof(*s));
+}
+
+static void test_rotation(void)
+{
+  settings s;
+  uint32_t i, v, seq, last, n;
+
+  flashlog.begin();
+  memset(&s, 7, sizeof(s));
+  CHECK(flashlog.write(0, &s, sizeof(s)));
+  for (i = 1; i <= 2000; i++) {
+    if (!flashlog.write(1, &i, sizeof(i))) {
+      break;
+    }
+  }
+  CHECK_EQ(i, 2001);
+  CHECK(flashlog.erases() > 0);
+
+  //nach dem Neustart: neuester Wert, Einstellungen ueberleben die Rotation
+  memset(&s, 0, sizeof(s));
+  CHECK(read_latest(&v, &s));
+  CHECK_EQ(v, 2000);
+  CHECK_EQ(s.fill[0], 7);
+
+  //equals(): Vergleich mit dem neuesten Eintrag
+  CHECK(flashlog.equals(0, &s, sizeof(s)));
+  s.fill[1] = 8;
+  CHECK(!flashlog.equals(0, &s, sizeof(s)));
+  CHECK(!flashlog.equals(0, &s, sizeof(s)-1));
+
+  //readNext(): aelteste bis neueste Eintraege, lueckenlos
+  FlashLogClass log(flash_data, LOG_SIZE);
+  log.begin();
+  seq = last = n = 0;
+  while ((seq = log.readNext(1, seq, &v, sizeof(v))) != 0) {
+    if (n > 0) {
+      CHECK_EQ(v, last+1);
+    }
+    last = v;
+    n++;
+  }
+  CHECK_EQ(last, 2000);
+  CHECK(n >= (LOG_SIZE - 2*FLASHLOG_BLOCK_SIZE) / FLASHLOG_PAGE_SIZE); //ein Block bleibt geloescht, einer wird gerade beschrieben
+}
+
+static void test_power_loss(void)
+{
+  settings s;
+  uint32_t v, expect, i;
+  long budget;
+  unsigned int fails = 0, torn = 0;
+
+  memset((void *)flash_data, 0, LOG_SIZE);
+  FlashLogClass init(flash_data, LOG_SIZE);
+  init.begin();
+  memset(&s, 7, sizeof(s));
+  init.write(0, &s, sizeof(s));
+  expect = 0;
+  init.write(1, &expect, sizeof(expect));
+
+  //Stromausfall nach budget Bytes, auch waehrend der Garbage Collection
+  for (i = 1; i <= 400; i++) {
+    FlashLogClass log(flash_data, LOG_SIZE);
+    log.begin();
+    budget = (i * 7) % (FLASHLOG_PAGE_SIZE + 2*sizeof(settings));
+    stub_flash_budget = budget;
+    log.write(1, &i, sizeof(i));
+    stub_flash_budget = -1;
+
+    memset(&s, 0, sizeof(s));
+    if (!read_latest(&v, &s) || (s.fill[0] != 7) || ((v != i) && (v != expect))) {
+      fails++;
+      continue;
+    }
+    if (v != i) {
+      torn++;
+    }
+    expect = v;
+  }
+  CHECK_EQ(fails, 0);
+  CHECK(torn > 0);
+  CHECK(expect > 300);
+}
+
+int main()
+{
+  test_rotation();
+  test_power_loss();
+
+  return test_done();
+}
@@ -0,0 +1,186 @@
+/*
+  Measurement history (/history): averaging through the three tiers,
+  insert and query time on the host, and the 1h values restored from the
+  flash log after a restart, whose age is unknown and left empty in the
+  CSV instead of continuing the ages of the values since the restart.
+*/
+
+#include SKETCH
+#include <chrono>
+#include <string>
+#include <vector>
+#include "test.h"
+
+class Sink : public Print //Antwort sammeln
+{
+public:
+  size_t write(uint8_t c) { out += (char)c; return 1; }
+  size_t write(const uint8_t *buf, size_t size) { out.append((const char*)buf, size); return size; }
+
+  std::string out;
+};
+
+static double now_ns(void)
+{
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void history_clear(void) //Neustart: RAM leer, Flash-Log bleibt
+{
+  for (int t = 0; t < 3; t++) {
+    history[t].head = history[t].count = history[t].n = history[t].restored = 0;
+    memset(history[t].sum, 0, sizeof(history[t].sum));
+  }
+  history_flash_n = 0;
+}
+
+static void samples(unsigned long n, unsigned int co2) //n Werte im Abstand HISTORY_INTERVALL
+{
+  co2_value = co2;
+  for (unsigned long i = 0; i < n; i++) {
+    history_sample();
+    if (history_flash_n >= HISTORY_FLASH_BLOCK) {
+      history_save();
+    }
+  }
+}
+
+static std::vector<std::string> query(unsigned int tier) //CSV-Zeilen ohne HTTP-Header
+{
+  Sink sink;
+  std::vector<std::string> rows;
+  size_t pos, end;
+
+  http_begin(&sink, 1);
+  http_history(tier);
+  http_end();
+  pos = sink.out.find("\r\n\r\n") + 4;
+  while ((end = sink.out.find("\r\n", pos)) != std::string::npos) {
+    rows.push_back(sink.out.substr(pos, end - pos));
+    pos = end + 2;
+  }
+  return rows;
+}
+
+static void test_tiers(void)
+{
+  std::vector<std::string> rows;
+  const unsigned long per_5min = 5*60 / HISTORY_INTERVALL, per_hour = 60*60 / HISTORY_INTERVALL;
+
+  history_clear();
+
+  //3h: je Stunde ein anderer Wert
+  samples(per_hour, 500);
+  samples(per_hour, 700);
+  samples(per_hour, 900);
+  CHECK_EQ(history[0].count, HISTORY_1_ANZAHL);
+  CHECK_EQ(history[1].count, 3*60/5);
+  CHECK_EQ(history[2].count, 3);
+  CHECK_EQ(history[2].restored, 0);
+
+  rows = query(2);
+  CHECK_EQ(rows.size(), 4);
+  CHECK(rows[0] == "s,c,t,h,p,l");
+  CHECK(rows[1].compare(0, 10, "-10800,500") == 0);
+  CHECK(rows[2].compare(0, 9, "-7200,700") == 0);
+  CHECK(rows[3].compare(0, 9, "-3600,900") == 0);
+
+  //5min-Mittelwert ueber einen Wechsel
+  samples(per_5min/2, 400);
+  samples(per_5min/2, 600);
+  rows = query(1);
+  CHECK(rows.back().compare(0, 8, "-300,500") == 0);
+}
+
+static void test_restore(void)
+{
+  std::vector<std::string> rows;
+  const unsigned long per_hour = 60*60 / HISTORY_INTERVALL;
+
+  //12h vor dem Neustart, 4 Werte pro Flash-Eintrag
+  flash_log.begin();
+  history_clear();
+  for (unsigned int h = 0; h < 12; h++) {
+    samples(per_hour, 400 + h*10);
+  }
+  CHECK_EQ(history_flash_n, 0);
+
+  //Neustart
+  history_clear();
+  history_restore();
+  CHECK_EQ(history[2].count, 12);
+  CHECK_EQ(history[2].restored, 12);
+  rows = query(2);
+  CHECK_EQ(rows.size(), 13);
+  CHECK(rows[1].compare(0, 4, ",400") == 0); //Alter unbekannt
+  CHECK(rows[12].compare(0, 4, ",510") == 0);
+
+  //2h nach dem Neustart: nur diese Werte haben ein Alter
+  samples(per_hour, 800);
+  samples(per_hour, 900);
+  rows = query(2);
+  CHECK_EQ(rows.size(), 15);
+  CHECK(rows[12].compare(0, 4, ",510") == 0);
+  CHECK(rows[13].compare(0, 9, "-7200,800") == 0);
+  CHECK(rows[14].compare(0, 9, "-3600,900") == 0);
+
+  //Ringpuffer voll: die alten Werte werden zuerst ueberschrieben
+  HISTORY_ENTRY e = history[2].entry[0];
+  for (unsigned int i = 0; i < HISTORY_3_ANZAHL - 14 + 5; i++) {
+    history_add(2, &e);
+  }
+  CHECK_EQ(history[2].count, HISTORY_3_ANZAHL);
+  CHECK_EQ(history[2].restored, 12 - 5);
+  rows = query(2);
+  CHECK(rows[7].compare(0, 1, ",") == 0);
+  CHECK(rows[8].compare(0, 1, "-") == 0);
+  for (unsigned int i = 0; i < 7; i++) {
+    history_add(2, &e);
+  }
+  CHECK_EQ(history[2].restored, 0);
+  rows = query(2);
+  CHECK(rows[1].compare(0, 1, "-") == 0);
+}
+
+static void bench(void)
+{
+  const unsigned long n = 200000;
+  double t0, insert, q[3];
+  size_t bytes[3];
+
+  history_clear();
+  t0 = now_ns();
+  for (unsigned long i = 0; i < n; i++) {
+    co2_value = 400 + (i & 255);
+    history_sample();
+  }
+  insert = (now_ns() - t0) / n;
+
+  for (int t = 0; t < 3; t++) {
+    const int rep = 20;
+    t0 = now_ns();
+    for (int r = 0; r < rep; r++) {
+      bytes[t] = 0;
+      for (const std::string &row : query(t)) {
+        bytes[t] += row.size() + 2;
+      }
+    }
+    q[t] = (now_ns() - t0) / rep;
+  }
+  printf("insert: %.1f ns per history_sample() (host)\n", insert);
+  for (int t = 0; t < 3; t++) {
+    printf("query tier %d: %u rows, %u bytes in %.0f us (host)\n", t+1, history[t].count, (unsigned int)bytes[t], q[t] / 1000);
+  }
+  CHECK_EQ(history[0].count, HISTORY_1_ANZAHL);
+  CHECK_EQ(history[1].count, HISTORY_2_ANZAHL);
+  CHECK_EQ(history[2].count, HISTORY_3_ANZAHL);
+}
+
+int main()
+{
+  test_tiers();
+  test_restore();
+  bench();
+
+  return test_done();
+}
@@ -0,0 +1,372 @@
+/*
+  HTTP request parser (http_parse(), http_form(), http_query()), a fuzzer
+  for it and requests through webserver_service(). The send path of
+  http_request() against the former sprintf() into a 1 KB stack buffer:
+  same content, bytes/s and peak stack on the host (stack painting).
+*/
+
+#include SKETCH
+#include <chrono>
+#include "test.h"
+
+static unsigned int feed(HTTP_CONN *c, const char *s, bool reset = false) //Zeichen einzeln, Anzahl vollstaendiger Anfragen
+{
+  unsigned int n = 0;
+
+  for (; *s; s++) {
+    if (http_parse(c, *s)) {
+      n++;
+      if (reset || (s[1] != 0)) {
+        http_reset(c);
+      }
+    }
+  }
+  return n;
+}
+
+static void test_get(void)
+{
+  HTTP_CONN c;
+
+  http_reset(&c);
+  CHECK_EQ(feed(&c, "GET /history?s=2&n=5 HTTP/1.1\r\nHost: co2ampel\r\nAccept: */*\r\n\r\n"), 1);
+  CHECK_EQ(c.method, HTTP_GET);
+  CHECK(strcmp(c.path, "/history") == 0);
+  CHECK(strcmp(c.query, "s=2&n=5") == 0);
+  CHECK_EQ(c.close, 0);
+  CHECK_EQ(http_query(&c, "s", 1), 2);
+  CHECK_EQ(http_query(&c, "n", 0), 5);
+  CHECK_EQ(http_query(&c, "x", 7), 7);
+
+  //Leerzeilen vor der Anfrage, nur \n als Zeilenende
+  http_reset(&c);
+  CHECK_EQ(feed(&c, "\r\n\nGET / HTTP/1.1\nHost: a\n\n"), 1);
+  CHECK(strcmp(c.path, "/") == 0);
+  CHECK(c.query[0] == 0);
+
+  //unvollstaendig: erst die Leerzeile beendet die Anfrage
+  http_reset(&c);
+  CHECK_EQ(feed(&c, "GET /json HTTP/1.1\r\nHost: a\r\n"), 0);
+  CHECK_EQ(feed(&c, "\r\n"), 1);
+}
+
+static void test_close(void)
+{
+  HTTP_CONN c;
+
+  http_reset(&c);
+  CHECK_EQ(feed(&c, "GET / HTTP/1.0\r\n\r\n"), 1);
+  CHECK_EQ(c.close, 1); //HTTP/1.0 ohne Keep-Alive
+
+  http_reset(&c);
+  CHECK_EQ(feed(&c, "GET / HTTP/1.1\r\nconnection: Close\r\n\r\n"), 1);
+  CHECK_EQ(c.close, 1);
+
+  http_reset(&c);
+  CHECK_EQ(feed(&c, "PUT / HTTP/1.1\r\nConnection: keep-alive\r\n\r\n"), 1);
+  CHECK_EQ(c.method, HTTP_OTHER);
+  CHECK_EQ(c.close, 0);
+}
+
+static void test_limits(void)
+{
+  HTTP_CONN c;
+  char req[256];
+
+  //zu lange Pfade, Parameter und Headerzeilen werden abgeschnitten
+  http_reset(&c);
+  snprintf(req, sizeof(req), "GET /%s?%s HTTP/1.1\r\nX-Long: %s\r\n\r\n",
+           "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", "q=1111111111111111111111111111111111111", "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb");
+  CHECK_EQ(feed(&c, req), 1);
+  CHECK_EQ(strlen(c.path), sizeof(c.path)-1);
+  CHECK_EQ(strlen(c.query), sizeof(c.query)-1);
+  CHECK(c.path[0] == '/');
+
+  //zwei Anfragen in einem Segment (Pipelining)
+  http_reset(&c);
+  CHECK_EQ(feed(&c, "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\n"), 2);
+  CHECK(strcmp(c.path, "/b") == 0);
+}
+
+static void test_post(void)
+{
+  HTTP_CONN c;
+  const char *body = "1=my+home%20net&2=p%40ss%2fw%zzord&3=ignored&12=x";
+  char req[256];
+
+  http_reset(&c);
+  snprintf(req, sizeof(req), "POST /save HTTP/1.1\r\nContent-Length: %u\r\n\r\n%s", (unsigned int)strlen(body), body);
+  CHECK_EQ(feed(&c, req), 1);
+  CHECK_EQ(c.method, HTTP_POST);
+  CHECK_EQ(c.body, 1);
+  CHECK(strcmp(c.form[0], "my home net") == 0);
+  CHECK(strcmp(c.form[1], "p@ss/wzord") == 0); //ungueltiges %z: das Zeichen nach % wird verworfen
+
+  //Body in Teilen, Ende genau nach Content-Length
+  http_reset(&c);
+  CHECK_EQ(feed(&c, "POST /save HTTP/1.1\r\nContent-Length: 7\r\n\r\n1=a"), 0);
+  CHECK_EQ(feed(&c, "&2=b"), 1);
+  CHECK(strcmp(c.form[0], "a") == 0);
+  CHECK(strcmp(c.form[1], "b") == 0);
+
+  //zu lange Felder werden abgeschnitten
+  HTTP_CONN d;
+  http_reset(&d);
+  d.state = HTTP_BODY;
+  d.length = 1000;
+  for (int i = 0; i < 200; i++) {
+    http_form(&d, (i < 2) ? "1="[i] : 'x');
+  }
+  CHECK_EQ(strlen(d.form[0]), sizeof(d.form[0])-1);
+}
+
+static bool terminated(const char *s, size_t size)
+{
+  return memchr(s, 0, size) != NULL;
+}
+
+static void test_fuzz(void) //zufaellige Folgen aus Anfrage-Bausteinen und Bytes, Puffergrenzen pruefen
+{
+  static const char *token[] = {
+    "GET ", "POST ", "PUT ", "/", "/json", "?", "&", "=", "s=2", "1=", "2=", "%", "%4", "%41", "+",
+    " HTTP/1.1", " HTTP/1.0", "\r\n", "\n", "\r\n\r\n", "Connection: close", "Content-Length: ",
+    "7", "65", "-1", "4294967295", "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", " ", ":"
+  };
+  HTTP_CONN c;
+  uint32_t rnd = 12345;
+  unsigned int done = 0, bad = 0;
+
+  http_reset(&c);
+  for (long n = 0; n < 2000000; n++) {
+    rnd = rnd * 1103515245 + 12345;
+    if ((rnd >> 28) < 12) {
+      const char *t = token[(rnd >> 8) % (sizeof(token)/sizeof(token[0]))];
+      done += feed(&c, t, true);
+    } else {
+      char ch[2] = { (char)(rnd >> 16), 0 };
+      done += feed(&c, ch, true);
+    }
+    if (!terminated(c.path, sizeof(c.path)) || !terminated(c.query, sizeof(c.query)) ||
+        !terminated(c.line, sizeof(c.line)) || !terminated(c.form[0], sizeof(c.form[0])) ||
+        !terminated(c.form[1], sizeof(c.form[1])) || (c.state < HTTP_METHOD) || (c.state > HTTP_BODY)) {
+      bad++;
+      http_reset(&c);
+    }
+    if ((rnd & 0xFFF) == 0) { //Verbindung neu
+      http_reset(&c);
+    }
+  }
+  CHECK_EQ(bad, 0);
+  CHECK(done > 1000);
+}
+
+static void test_server(void)
+{
+  uint8_t s;
+
+  features |= FEATURE_WINC1500;
+  stub_wifi_status = WL_CONNECTED;
+
+  //Anfrage in zwei Segmenten, Antwort und Schliessen (HTTP/1.0)
+  s = stub_http_open("GET /json HTT");
+  for (int i = 0; i < 3; i++) {
+    webserver_service();
+  }
+  CHECK(stub_sock[s].tx.empty());
+  stub_sock[s].rx += "P/1.0\r\n\r\n";
+  for (int i = 0; i < 3; i++) {
+    webserver_service();
+  }
+  CHECK(stub_sock[s].tx.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+  CHECK(stub_sock[s].tx.find("\"c\": 500") != std::string::npos);
+  CHECK(!stub_sock[s].open);
+  stub_sock[s].used = false;
+
+  //unbekannter Pfad: Webseite
+  s = stub_http_open("GET /nix HTTP/1.0\r\n\r\n");
+  for (int i = 0; i < 3; i++) {
+    webserver_service();
+  }
+  CHECK(stub_sock[s].tx.find("<title>CO2-Ampel</title>") != std::string::npos);
+  stub_sock[s].used = false;
+
+  //Keep-Alive: Verbindung wird nach HTTP_TIMEOUT ohne Daten geschlossen
+  s = stub_http_open("GET /json HTTP/1.1\r\n\r\n");
+  for (int i = 0; i < 3; i++) {
+    webserver_service();
+  }
+  CHECK(stub_sock[s].open);
+  delay(HTTP_TIMEOUT*1000UL + 100);
+  webserver_service();
+  CHECK(!stub_sock[s].open);
+  stub_sock[s].used = false;
+
+  //Einstellungen: nur der geaenderte Eintrag wird geschrieben, ohne Aenderung keiner
+  flash_log.begin();
+  settings_save();
+  uint32_t writes = flash_log.writes();
+  s = stub_http_open("GET /ampel?w=5 HTTP/1.0\r\n\r\n");
+  for (int i = 0; i < 3; i++) {
+    webserver_service();
+  }
+  CHECK_EQ(ampel_settings.warnung, 5);
+  CHECK_EQ(flash_log.writes(), writes+1);
+  stub_sock[s].used = false;
+  settings_save();
+  CHECK_EQ(flash_log.writes(), writes+1);
+}
+
+//--- Sendepfad: http_write() in den statischen Sendepuffer gegen das fruehere sprintf() in einen 1kB-Stackpuffer ---
+
+#define STACK_AREA 32768
+
+__attribute__((noinline)) static void stack_paint(void)
+{
+  volatile uint8_t area[STACK_AREA];
+
+  for (size_t i = 0; i < sizeof(area); i++) {
+    area[i] = 0xA5;
+  }
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized" //liest absichtlich, was stack_paint() und der Aufruf dort hinterlassen haben
+__attribute__((noinline)) static size_t stack_used(void) //Bytes unter dem Aufrufer, die seit stack_paint() beschrieben wurden
+{
+  volatile uint8_t area[STACK_AREA];
+  size_t i;
+
+  for (i = 0; (i < sizeof(area)) && (area[i] == 0xA5); i++);
+  return sizeof(area) - i;
+}
+#pragma GCC diagnostic pop
+
+__attribute__((noinline)) static void old_json(Print *client) //vor user-004
+{
+  char buf[1024];
+
+  sprintf(buf,
+      "HTTP/1.1 200 OK\r\n" \
+      "Content-Type: application/json\r\n" \
+      "Connection: close\r\n" \
+      "\r\n" \
+      "{\r\n" \
+      " \"c\": %i,\r\n" \
+      " \"t\": %.1f,\r\n" \
+      " \"h\": %.1f,\r\n" \
+      " \"l\": %i\r\n" \
+      "}\r\n",
+      co2_value, temp_value, humi_value, light_value
+  );
+  client->print(buf);
+}
+
+__attribute__((noinline)) static void old_cmk(Print *client) //vor user-004
+{
+  char buf[1024];
+
+  sprintf(buf,
+      "HTTP/1.1 200 OK\r\n" \
+      "Content-Type: text/plain\r\n" \
+      "Connection: close\r\n" \
+      "\r\n" \
+      "<<<check_mk>>>\r\n" \
+      "AgentOS: arduino\r\n" \
+      "<<<watterott_co2ampel_plugin>>>\r\n" \
+      "co2 %i\r\n" \
+      "temp %.1f\r\n" \
+      "humidity %.1f\r\n" \
+      "lighting %i\r\n" \
+      "<<<local:sep(0)>>>\r\n" \
+      "P \"CO2 level (ppm)\" co2ppm=%i;%i;%i CO2/ventilation control with Watterott CO2-Ampel, thresholds taken from sensor board.\r\n",
+      co2_value, temp_value, humi_value, light_value,
+      co2_value, settings.range[1], settings.range[2]
+  );
+  client->print(buf);
+}
+
+__attribute__((noinline)) static void new_path(HTTP_CONN *c)
+{
+  http_request(c);
+}
+
+struct PathResult
+{
+  size_t bytes, stack;
+  double mb_s;
+};
+
+static PathResult measure(void (*old_fn)(Print *), HTTP_CONN *c, uint8_t s, std::string *out)
+{
+  const unsigned long n = 20000;
+  PathResult r;
+
+  stub_sock[s].tx.clear();
+  stack_paint();
+  if (old_fn != NULL) {
+    old_fn(&c->client);
+  } else {
+    new_path(c);
+  }
+  r.stack = stack_used();
+  *out = stub_sock[s].tx;
+  r.bytes = out->size();
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long i = 0; i < n; i++) {
+    stub_sock[s].tx.clear();
+    if (old_fn != NULL) {
+      old_fn(&c->client);
+    } else {
+      new_path(c);
+    }
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  r.mb_s = (double)r.bytes * n / sec / 1e6;
+  return r;
+}
+
+static void test_writer(void)
+{
+  static const struct { const char *path; void (*old_fn)(Print *); } page[] = {
+    { "/json", old_json },
+    { "/cmk-agent", old_cmk },
+  };
+  HTTP_CONN c;
+  uint8_t s = stub_sock_open();
+  std::string old_out, new_out;
+
+  features &= ~(FEATURE_LPS22HB|FEATURE_BMP280);
+  c.client = WiFiClient(s);
+  for (unsigned int p = 0; p < sizeof(page)/sizeof(page[0]); p++) {
+    http_reset(&c);
+    strcpy(c.path, page[p].path);
+    c.method = HTTP_GET;
+    c.close = 1;
+    PathResult o = measure(page[p].old_fn, &c, s, &old_out);
+    PathResult w = measure(NULL, &c, s, &new_out);
+    printf("%-10s sprintf: %3u bytes, %6.1f MB/s, stack %5u bytes | http_write: %3u bytes, %6.1f MB/s, stack %5u bytes (host)\n",
+           page[p].path, (unsigned int)o.bytes, o.mb_s, (unsigned int)o.stack, (unsigned int)w.bytes, w.mb_s, (unsigned int)w.stack);
+    CHECK(w.stack < o.stack);
+#ifndef __SANITIZE_ADDRESS__ //ASan vergroessert jeden Stackrahmen
+    CHECK(w.stack < 1024); //ohne Stackpuffer und printf
+#endif
+    //gleicher Inhalt, /json hat seitdem den Trend "d" am Ende
+    size_t end = old_out.find("\r\n}");
+    CHECK(new_out.compare(0, (end == std::string::npos) ? old_out.size() : end, old_out, 0, (end == std::string::npos) ? old_out.size() : end) == 0);
+  }
+  stub_sock[s].used = false;
+}
+
+int main()
+{
+  test_get();
+  test_close();
+  test_limits();
+  test_post();
+  test_fuzz();
+  test_server();
+  test_writer();
+
+  return test_done();
+}
@@ -0,0 +1,231 @@
+/*
+  I2CQueue (src/I2CQueue.cpp) on a model of the SERCOM I2C master: the
+  model answers the register writes of the driver like the hardware
+  (MB after address/data byte, SB after a received byte, RXNACK) and
+  raises the SERCOM interrupt through stub_irq.
+*/
+
+#include "../../src/I2CQueue.h"
+#include "test.h"
+
+#include <string>
+
+#define DEV_MEM   0x50 //Speicher: erstes Byte = Adresse, Lesen ab Adresse
+#define DEV_STUCK 0x51 //antwortet nie (haelt den Bus)
+
+static struct
+{
+  uint8_t mem[256], ptr;
+  std::string log;   //Transfers: "W50:0102 R50:2 P" (P = Stop)
+  bool reading, first;
+  unsigned long writes; //Registerzugriffe des Treibers
+} bus;
+
+static Sercom *const sercom = SERCOM0;
+
+static void bus_flag(uint32_t flag)
+{
+  sercom->I2CM.INTFLAG.reg.v = (sercom->I2CM.INTFLAG.reg.v & ~(SERCOM_I2CM_INTFLAG_MB|SERCOM_I2CM_INTFLAG_SB)) | flag;
+}
+
+static void bus_log(const char *fmt, unsigned int v)
+{
+  char tmp[16];
+
+  snprintf(tmp, sizeof(tmp), fmt, v);
+  bus.log += tmp;
+}
+
+static void bus_write(StubReg *r, uint32_t old) //Hardware: Reaktion auf Registerzugriffe
+{
+  SercomI2cm *m = &sercom->I2CM;
+
+  bus.writes++;
+  if (r == &m->INTFLAG.reg) { //Bits mit 1 loeschen
+    r->v = old & ~r->v;
+  } else if (r == &m->INTENSET.reg) {
+    r->v |= old;
+  } else if (r == &m->INTENCLR.reg) {
+    m->INTENSET.reg.v &= ~r->v;
+  } else if (r == &m->ADDR.bit.ADDR) { //(Repeated) Start und Adresse
+    uint8_t addr = r->v >> 1;
+    bus.reading = r->v & 1;
+    bus.first = true;
+    bus_log(bus.reading ? " R%02X:" : " W%02X:", addr);
+    m->STATUS.reg.v &= ~SERCOM_I2CM_STATUS_RXNACK;
+    if (addr == DEV_STUCK) {
+      bus_flag(0);
+    } else if (addr != DEV_MEM) {
+      m->STATUS.reg.v |= SERCOM_I2CM_STATUS_RXNACK;
+      bus_flag(SERCOM_I2CM_INTFLAG_MB);
+    } else if (bus.reading) {
+      m->DATA.reg.v = bus.mem[bus.ptr++];
+      bus_log("%02X", m->DATA.reg.v);
+      bus_flag(SERCOM_I2CM_INTFLAG_SB);
+    } else {
+      bus_flag(SERCOM_I2CM_INTFLAG_MB);
+    }
+  } else if (r == &m->DATA.reg) { //Byte senden
+    if (bus.first) {
+      bus.ptr = r->v;
+    } else {
+      bus.mem[bus.ptr++] = r->v;
+    }
+    bus.first = false;
+    bus_log("%02X", r->v);
+    bus_flag(SERCOM_I2CM_INTFLAG_MB);
+  } else if (r == &m->CTRLB.bit.CMD) {
+    if (r->v == 2) { //naechstes Byte lesen
+      m->DATA.reg.v = bus.mem[bus.ptr++];
+      bus_log("%02X", m->DATA.reg.v);
+      bus_flag(SERCOM_I2CM_INTFLAG_SB);
+    } else if (r->v == 3) { //Stop
+      bus.log += " P";
+      bus_flag(0);
+    }
+  }
+}
+
+static void bus_irq(void)
+{
+  while ((sercom->I2CM.INTFLAG.reg.v & sercom->I2CM.INTENSET.reg.v) && sercom0_handler) {
+    unsigned long writes = bus.writes;
+    sercom0_handler();
+    if (bus.writes == writes) { //Treiber hat nicht reagiert
+      break;
+    }
+  }
+}
+
+static I2CQueue q(SERCOM0, &Wire);
+
+static void reset_log(void)
+{
+  q.wait();
+  bus.log.clear();
+}
+
+static std::string done_order;
+
+static void done(I2CTransfer *t)
+{
+  done_order += (char)('0' + (uintptr_t)t->arg);
+}
+
+static void test_probe(void)
+{
+  reset_log();
+  CHECK(q.probe(DEV_MEM));
+  CHECK(!q.probe(0x10));
+  CHECK(bus.log == " W50: P W10: P");
+  CHECK_EQ(q.errors(), 1);
+}
+
+static void test_transfers(void)
+{
+  static const uint8_t head = 0x10, data[] = { 0xA1, 0xA2, 0xA3 };
+  uint8_t rx[3];
+  I2CTransfer w = { }, r = { };
+
+  //Register + Daten schreiben
+  reset_log();
+  w.addr = DEV_MEM; w.head = &head; w.headLen = 1; w.tx = data; w.txLen = 3;
+  CHECK(q.submit(&w));
+  CHECK(q.wait());
+  CHECK_EQ(w.status, I2C_OK);
+  CHECK(bus.log == " W50:10A1A2A3 P");
+  CHECK_EQ(bus.mem[0x11], 0xA2);
+
+  //Register schreiben, Repeated Start, lesen
+  reset_log();
+  r.addr = DEV_MEM; r.tx = &head; r.txLen = 1; r.rx = rx; r.rxLen = 3;
+  CHECK(q.submit(&r));
+  CHECK(q.wait());
+  CHECK_EQ(r.status, I2C_OK);
+  CHECK(bus.log == " W50:10 R50:A1A2A3 P");
+  CHECK(memcmp(rx, data, 3) == 0);
+
+  //NACK
+  r.addr = 0x11;
+  q.submit(&r);
+  q.wait();
+  CHECK_EQ(r.status, I2C_ERR_NACK);
+}
+
+static void test_queue(void)
+{
+  static const uint8_t d0[] = { 0x20, 1 }, d1[] = { 0x21, 2 }, d2[] = { 0x22, 3 };
+  I2CTransfer t[3] = { };
+  const uint8_t *d[3] = { d0, d1, d2 };
+
+  //mehrere Transfers nacheinander, Callbacks in Reihenfolge
+  reset_log();
+  done_order.clear();
+  for (int i = 0; i < 3; i++) {
+    t[i].addr = DEV_MEM; t[i].tx = d[i]; t[i].txLen = 2; t[i].done = done; t[i].arg = (void*)(uintptr_t)i;
+  }
+  __disable_irq(); //alle einreihen, bevor der erste fertig ist
+  for (int i = 0; i < 3; i++) {
+    CHECK(q.submit(&t[i]));
+  }
+  CHECK(!q.submit(&t[1])); //laeuft noch
+  __enable_irq();
+  CHECK(q.wait());
+  CHECK(done_order == "012");
+  CHECK(bus.log == " W50:2001 P W50:2102 P W50:2203 P");
+
+  //acquire(): Warteschlange wird bis release() zurueckgehalten
+  reset_log();
+  q.acquire();
+  t[0].status = I2C_OK;
+  q.submit(&t[0]);
+  for (int i = 0; i < 10; i++) {
+    millis();
+  }
+  CHECK_EQ(t[0].status, I2C_PENDING);
+  CHECK(bus.log.empty());
+  q.release();
+  CHECK(q.wait());
+  CHECK_EQ(t[0].status, I2C_OK);
+}
+
+static void test_timeout(void)
+{
+  static const uint8_t d[] = { 0x30, 9 };
+  I2CTransfer s = { }, n = { };
+  uint32_t errors = q.errors();
+
+  //haengender Slave: Abbruch nach I2C_TIMEOUT, der naechste Transfer laeuft
+  reset_log();
+  s.addr = DEV_STUCK; s.tx = d; s.txLen = 2;
+  n.addr = DEV_MEM; n.tx = d; n.txLen = 2;
+  q.submit(&s);
+  q.submit(&n);
+  unsigned long t = millis();
+  while (s.status == I2C_PENDING && (millis() - t) < 1000) {
+    q.service();
+  }
+  CHECK_EQ(s.status, I2C_ERR_TIMEOUT);
+  CHECK((millis() - t) >= I2C_TIMEOUT);
+  CHECK(q.wait());
+  CHECK_EQ(n.status, I2C_OK);
+  CHECK_EQ(q.errors(), errors + 1);
+}
+
+int main()
+{
+  stub_reg_write = bus_write;
+  stub_irq = bus_irq;
+  sercom->I2CM.SYNCBUSY.bit.SYSOP.v = 0;
+  q.begin();
+
+  test_probe();
+  test_transfers();
+  test_queue();
+  test_timeout();
+
+  q.end();
+  CHECK(sercom0_handler == NULL);
+
+  return test_done();
+}
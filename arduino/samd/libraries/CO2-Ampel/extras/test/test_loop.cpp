@@ -0,0 +1,228 @@
+/*
+  loop() timing on the virtual clock: WiFi version with SCD30, display and
+  MQTT. Runs setup() and then loop() for some virtual minutes and checks
+  the runtime of the parts measured by the sketch itself (profile_add(),
+  also shown by P?) and of every pass against LOOP_BUDGET, also while the
+  WiFi and MQTT connections are being set up again. MQTT values sent again
+  after a reconnect must carry the same number and time. Last, several
+  HTTP clients with keep-alive: requests/s on the virtual clock with the
+  SPI time of the WINC1500 socket calls.
+*/
+
+#include SKETCH
+#include <map>
+#include "test.h"
+
+static unsigned long pass_max, passes; //us, laengster loop()-Durchlauf
+
+static void run(unsigned long seconds) //loop() fuer seconds virtuelle Sekunden
+{
+  uint64_t end = stub_us + seconds*1000000ULL;
+
+  while (stub_us < end) {
+    uint64_t t = stub_us;
+    loop();
+    if ((stub_us - t) > pass_max) {
+      pass_max = stub_us - t;
+    }
+    passes++;
+    stub_advance(50); //Core: USB, serialEvent
+  }
+}
+
+static void reset_profile(void)
+{
+  memset(profile_sum, 0, sizeof(profile_sum));
+  memset(profile_max, 0, sizeof(profile_max));
+  profile_loops = profile_loop_max = profile_over = 0;
+  pass_max = passes = 0;
+}
+
+static void show_profile(const char *title)
+{
+  static const char *name[PROFILE_NUM] = { "serial", "web", "mqtt", "mqtt_con", "lora", "sensors", "ampel" };
+
+  printf("%s: %lu passes, max %lu us\n", title, passes, pass_max);
+  for (unsigned int p = 0; p < PROFILE_NUM; p++) {
+    printf("  %-8s max %7lu us\n", name[p], profile_max[p]);
+  }
+}
+
+static unsigned int http_get(const char *req) //loop()-Durchlaeufe bis zur Antwort, 0 = keine Antwort
+{
+  uint8_t s = stub_http_open(req);
+  unsigned int n, ret = 0;
+
+  for (n = 1; n <= 1000; n++) {
+    loop();
+    stub_advance(50);
+    if (!stub_sock[s].tx.empty()) {
+      ret = n;
+      break;
+    }
+  }
+  stub_sock[s].used = false;
+  return ret;
+}
+
+static void check_mqtt_numbers(void) //jede Nummer kommt an, Wiederholungen mit denselben n und u
+{
+  std::map<long, long> seen; //n -> u
+  unsigned int dup = 0, bad = 0;
+
+  for (const std::string &msg : stub_mqtt_msgs) {
+    for (size_t pos = msg.find("{\"n\":"); pos != std::string::npos; pos = msg.find("{\"n\":", pos + 1)) {
+      char *end;
+      long n = strtol(msg.c_str() + pos + 5, &end, 10), u = 0;
+      if (strncmp(end, ",\"u\":", 5) == 0) {
+        u = strtol(end + 5, NULL, 10);
+      }
+      if (seen.count(n)) {
+        dup++;
+        bad += (seen[n] != u);
+      }
+      seen[n] = u;
+    }
+  }
+  printf("mqtt: %u values, %u sent again\n", (unsigned int)seen.size(), dup);
+  CHECK(seen.size() > 0);
+  CHECK_EQ(bad, 0);
+  CHECK_EQ(seen.begin()->first, 1);
+  CHECK_EQ(seen.rbegin()->first, (long)seen.size()); //keine Luecke
+  CHECK(seen.rbegin()->second > 1700000000L); //Unix-Zeit
+}
+
+//HTTP-Clients fragen path fuer seconds virtuelle Sekunden ab, jeder sofort nach der letzten Antwort, Anfragen pro s
+static double throughput(const char *path, unsigned int clients, bool keep_alive, unsigned long seconds)
+{
+  std::string req = std::string("GET ") + path + (keep_alive ? " HTTP/1.1\r\nHost: co2ampel\r\n\r\n" : " HTTP/1.0\r\n\r\n");
+  uint8_t s[STUB_SOCKETS];
+  unsigned long done[STUB_SOCKETS] = { 0 }, total = 0, fewest = ~0UL;
+  uint64_t end = stub_us + seconds*1000000ULL;
+
+  for (unsigned int i = 0; i < clients; i++) {
+    s[i] = stub_http_open(req.c_str());
+  }
+  pass_max = 0;
+  while (stub_us < end) {
+    uint64_t t = stub_us;
+    loop();
+    if ((stub_us - t) > pass_max) {
+      pass_max = stub_us - t;
+    }
+    stub_advance(50);
+    for (unsigned int i = 0; i < clients; i++) {
+      StubSocket *sock = &stub_sock[s[i]];
+      if (keep_alive && (sock->tx.size() >= 5) && (sock->tx.compare(sock->tx.size()-5, 5, "0\r\n\r\n") == 0)) {
+        done[i]++;
+        sock->tx.clear();
+        sock->rx += req; //naechste Anfrage auf derselben Verbindung
+      } else if (!keep_alive && !sock->open) {
+        done[i]++;
+        sock->used = false;
+        s[i] = stub_http_open(req.c_str()); //neue Verbindung
+      }
+    }
+  }
+  for (unsigned int i = 0; i < clients; i++) {
+    CHECK(!keep_alive || stub_sock[s[i]].open);
+    stub_sock[s[i]].used = false;
+    total += done[i];
+    fewest = (done[i] < fewest) ? done[i] : fewest;
+  }
+  printf("%s, %u clients%s: %.0f requests/s, slowest client %.0f/s, loop() max %lu us\n",
+         path, clients, keep_alive ? " keep-alive" : "", (double)total / seconds, (double)fewest / seconds, pass_max);
+  CHECK(fewest * clients >= total * 9 / 10); //reihum, kein Client wartet laenger
+  CHECK(pass_max < LOOP_BUDGET*1000UL);
+  return (double)total / seconds;
+}
+
+int main()
+{
+  stub_i2c_devices[ADDR_SCD30] = true;
+  stub_i2c_devices[ADDR_SSD1306] = true;
+
+  setup();
+  CHECK(features & FEATURE_SCD30);
+  CHECK(features & FEATURE_SSD1306);
+  CHECK(features & FEATURE_WINC1500);
+  CHECK_EQ(stub_wifi_status, WL_CONNECTED);
+  CHECK_EQ(ampel_settings.hysterese[2], AMPEL_HYSTERESE); //erster Start: Standardwerte auch im Flash-Log
+
+  //Normalbetrieb: Messwerte, Anzeige, MQTT
+  reset_profile();
+  run(10*60);
+  show_profile("normal");
+  CHECK(passes > 10000);
+  CHECK(stub_mqtt_msgs.size() > 0);
+  CHECK(pass_max < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_SERIAL] < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_WEB] < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_MQTT] < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_MQTT_CONNECT] < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_AMPEL] < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_SENSORS] < LOOP_BUDGET*1000UL);
+
+  //SCD30 per I2C-Warteschlange: jeder neue Wert kommt an, keine Sensorfehler
+  CHECK_EQ(err_co2, 0);
+  stub_co2 = 1234;
+  run(3);
+  CHECK_EQ(co2_value, 1234);
+  stub_co2 = 600;
+
+  //Messwertverlauf: 5min-Mittelwerte, alle Stufen zusammen max. 8kB RAM
+  CHECK(history[1].count >= 1);
+  printf("history %u bytes\n", (unsigned int)(sizeof(history_1) + sizeof(history_2) + sizeof(history_3)));
+  CHECK(sizeof(history_1) + sizeof(history_2) + sizeof(history_3) <= 8192);
+
+  //HTTP-Anfrage wird im naechsten Durchlauf beantwortet
+  CHECK_EQ(http_get("GET /json HTTP/1.0\r\n\r\n"), 1);
+
+  //Broker nicht erreichbar: Verbindungsversuche laufen neben loop() her
+  stub_mqtt_broker = false;
+  reset_profile();
+  run(5*60);
+  show_profile("broker down");
+  CHECK(mqtt_count > 0); //Messwerte bleiben im Puffer
+  CHECK(pass_max < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_WEB] < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_MQTT] < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_MQTT_CONNECT] < LOOP_BUDGET*1000UL);
+  CHECK(profile_max[PROFILE_SENSORS] < LOOP_BUDGET*1000UL);
+  CHECK_EQ(http_get("GET /json HTTP/1.0\r\n\r\n"), 1);
+
+  //Broker wieder da: Puffer wird geleert
+  stub_mqtt_broker = true;
+  run(10*60);
+  CHECK_EQ(mqtt_count, 0);
+  check_mqtt_numbers();
+
+  //WiFi-Abbruch: nur die erfolgreiche Neuverbindung zaehlt, nicht die Versuche
+  uint64_t end = stub_us + 200*1000000ULL;
+  while (stub_us < end) {
+    stub_wifi_status = WL_CONNECTION_LOST;
+    loop();
+    stub_advance(50);
+  }
+  CHECK_EQ(wifi_reconnects, 0);
+  reset_profile();
+  run(70);
+  show_profile("wifi reconnect");
+  CHECK_EQ(stub_wifi_status, WL_CONNECTED);
+  CHECK_EQ(wifi_reconnects, 1);
+  CHECK(mqtt.connected());
+  CHECK(pass_max < LOOP_BUDGET*1000UL);
+  CHECK_EQ(http_get("GET /json HTTP/1.0\r\n\r\n"), 1);
+
+  //Webserver: mehrere Clients mit Keep-Alive, WINC1500 mit 100us pro Socket-Aufruf und 1us pro Byte (SPI)
+  stub_winc_call_us = 100;
+  stub_winc_byte_ns = 1000;
+  double one = throughput("/json", 1, true, 10);
+  double four = throughput("/json", HTTP_CLIENTS, true, 10);
+  throughput("/json", HTTP_CLIENTS, false, 10); //HTTP/1.0, der Stub rechnet den TCP-Verbindungsaufbau nicht
+  throughput("/", HTTP_CLIENTS, true, 10);
+  CHECK(four >= one); //weitere Clients bremsen den Webserver nicht
+  stub_winc_call_us = stub_winc_byte_ns = 0;
+
+  return test_done();
+}
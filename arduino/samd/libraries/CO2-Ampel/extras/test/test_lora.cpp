@@ -0,0 +1,146 @@
+/*
+  LoRaWAN payload (lora_pack()) and the uplink flow: lora_sample() starts
+  an uplink, os_runloop_once() in loop() ends it with EV_TXCOMPLETE. loop()
+  keeps running (web server) during the receive windows.
+*/
+
+#include SKETCH
+#include "test.h"
+
+static unsigned long unpack(const uint8_t *buf, unsigned int *pos, unsigned int bits) //Gegenstueck zu lora_bits()
+{
+  unsigned long value = 0;
+
+  while (bits--) {
+    value = (value << 1) | ((buf[*pos/8] >> (7 - (*pos%8))) & 1);
+    (*pos)++;
+  }
+  return value;
+}
+
+struct payload
+{
+  unsigned long co2, temp, humi, pres, level, rest;
+};
+
+static payload pack(unsigned int level)
+{
+  uint8_t buf[LORA_PAYLOAD];
+  unsigned int pos = 0;
+  payload p;
+
+  lora_pack(buf, level);
+  p.co2   = unpack(buf, &pos, 14);
+  p.temp  = unpack(buf, &pos, 11);
+  p.humi  = unpack(buf, &pos, 8);
+  p.pres  = unpack(buf, &pos, 13);
+  p.level = unpack(buf, &pos, 3);
+  p.rest  = unpack(buf, &pos, 7);
+  return p;
+}
+
+static void test_pack(void)
+{
+  payload p;
+
+  features = FEATURE_LPS22HB;
+  co2_value = 1234; temp_value = 21.46; humi_value = 45.3; pres_value = 1013.25;
+  p = pack(3);
+  CHECK_EQ(p.co2, 1234);
+  CHECK_EQ(p.temp, 615); //(21.46+40)*10
+  CHECK_EQ(p.humi, 91);  //45.3*2
+  CHECK_EQ(p.pres, 7133); //(1013.25-300)*10
+  CHECK_EQ(p.level, 3);
+  CHECK_EQ(p.rest, 0);
+
+  //Grenzen
+  co2_value = 40000; temp_value = -50; humi_value = 200; pres_value = 2000;
+  p = pack(7);
+  CHECK_EQ(p.co2, 16383);
+  CHECK_EQ(p.temp, 0);
+  CHECK_EQ(p.humi, 255);
+  CHECK_EQ(p.pres, 8191);
+  CHECK_EQ(p.level, 7);
+
+  //Drucksensor vorhanden: min. 1, 0 = kein Sensor
+  pres_value = 250;
+  p = pack(0);
+  CHECK_EQ(p.pres, 1);
+  features = 0;
+  pres_value = 1013.25;
+  p = pack(0);
+  CHECK_EQ(p.pres, 0);
+
+  //NaN (Sensorfehler)
+  temp_value = NAN; humi_value = NAN;
+  p = pack(0);
+  CHECK_EQ(p.temp, 0);
+  CHECK_EQ(p.humi, 0);
+}
+
+static void test_uplink(void)
+{
+  unsigned long tx;
+  uint64_t end;
+  uint8_t s;
+
+  stub_i2c_devices[ADDR_SCD30] = true;
+  setup();
+  CHECK(features & FEATURE_RFM9X);
+
+  //erste Nachricht nach LORA_INTERVALL_MIN
+  end = stub_us + (LORA_INTERVALL_MIN + 10)*1000000ULL;
+  while (stub_us < end && stub_lora_tx == 0) {
+    loop();
+    stub_advance(50);
+  }
+  CHECK_EQ(stub_lora_tx, 1);
+  CHECK(LMIC.opmode & OP_TXRXPEND);
+
+  //waehrend der Empfangsfenster: Webserver antwortet, os_runloop_once() ohne lange Luecken
+  stub_lora_gap_max = 0;
+  s = stub_http_open("GET /json HTTP/1.0\r\n\r\n");
+  while (stub_sock[s].open && (LMIC.opmode & OP_TXRXPEND)) {
+    loop();
+    stub_advance(50);
+  }
+  CHECK(!stub_sock[s].open);
+  CHECK(stub_sock[s].tx.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+  CHECK(LMIC.opmode & OP_TXRXPEND);
+  stub_sock[s].used = false;
+
+  //EV_TXCOMPLETE nach den Empfangsfenstern
+  while (stub_us < end) {
+    loop();
+    stub_advance(50);
+  }
+  printf("lora gap max %lu us\n", stub_lora_gap_max);
+  CHECK(stub_lora_gap_max < LOOP_BUDGET*1000UL);
+  CHECK_EQ(stub_lora_tx, 1);
+  CHECK_EQ(lora_tx, 1);
+  CHECK_EQ(LMIC.dataLen, LORA_PAYLOAD);
+  CHECK((LMIC.opmode & OP_TXRXPEND) == 0);
+
+  //ohne Aenderung erst nach LORA_INTERVALL_MAX
+  tx = stub_lora_tx;
+  end = stub_us + (LORA_INTERVALL_MAX - 30)*1000000ULL;
+  while (stub_us < end) {
+    loop();
+    stub_advance(50);
+  }
+  CHECK_EQ(stub_lora_tx, tx);
+  end = stub_us + 60*1000000ULL;
+  while (stub_us < end) {
+    loop();
+    stub_advance(50);
+  }
+  CHECK_EQ(stub_lora_tx, tx+1);
+}
+
+int main()
+{
+  test_pack();
+  test_uplink();
+
+  return test_done();
+}
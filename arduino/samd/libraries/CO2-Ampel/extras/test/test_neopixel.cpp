@@ -0,0 +1,136 @@
+/*
+  Adafruit_NeoPixel SERCOM-SPI + DMA output (samd21SpiEncode() in
+  samd21_spi.c): the SPI buffer is played back as line level at NEO_SPI_HZ
+  and decoded like a WS2812 would. Checks the high times of 0 and 1 bits,
+  the low time between bits, the bit period and the reset latch after the
+  frame against the WS2812B data sheet, and that the decoded bytes are the
+  pixel bytes.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "samd21_spi.h"
+#include "test.h"
+
+//WS2812B Datenblatt (+/-150ns), Zeiten in ns
+#define T0H_MIN    250
+#define T0H_MAX    550
+#define T1H_MIN    650
+#define T1H_MAX    950
+#define TL_MIN     300  //T1L 450-150ns
+#define TL_MAX    5000  //laenger: wird als Reset gewertet
+#define TBIT_MIN   650  //1.25us +/-600ns
+#define TBIT_MAX  1850
+#define RESET_MIN 280000 //WS2812B-V5, aeltere Streifen 50us
+
+#define PIXELS 60 //ein Ring, RGBW
+#define BYTES  (PIXELS * 4)
+
+struct Pulse
+{
+  unsigned int high, low; //Takte
+};
+
+static const double T_SPI = 1e9 / NEO_SPI_HZ; //ns pro SPI-Bit
+
+//Pegel der Datenleitung, MSB zuerst wie SERCOM mit DORD=0
+static std::vector<Pulse> line(const uint8_t *buf, uint32_t len)
+{
+  std::vector<Pulse> pulses;
+  Pulse p = { 0, 0 };
+
+  for (uint32_t i = 0; i < len * 8; i++) {
+    bool level = buf[i / 8] & (0x80 >> (i % 8));
+    if (level) {
+      if (p.low) { //neuer Puls
+        pulses.push_back(p);
+        p.high = p.low = 0;
+      }
+      p.high++;
+    } else {
+      p.low++;
+    }
+  }
+  if (p.high || p.low) {
+    pulses.push_back(p);
+  }
+  return pulses;
+}
+
+static void check_frame(const uint8_t *pixels, uint32_t n, bool print = false)
+{
+  std::vector<uint8_t> buf(NEO_SPI_BYTES(n) + 4, 0xA5); //4 Schutzbytes
+  unsigned int t0h = 0, t1h = 0, tl_min = ~0U, tl_max = 0, tbit_min = ~0U, tbit_max = 0, reset = 0, bad = 0;
+
+  CHECK_EQ(samd21SpiEncode(buf.data(), pixels, n), NEO_SPI_BYTES(n));
+  for (int i = 0; i < 4; i++) {
+    CHECK_EQ(buf[NEO_SPI_BYTES(n) + i], 0xA5);
+  }
+
+  std::vector<Pulse> pulses = line(buf.data(), NEO_SPI_BYTES(n));
+  CHECK_EQ(pulses.size(), n * 8);
+  if (pulses.size() != n * 8) {
+    return;
+  }
+
+  std::vector<uint8_t> out(n, 0);
+  for (uint32_t i = 0; i < n * 8; i++) {
+    unsigned int high = pulses[i].high * T_SPI + 0.5, low = pulses[i].low * T_SPI + 0.5;
+    bool one = high > (T0H_MAX + T1H_MIN) / 2;
+
+    if (one) {
+      out[i / 8] |= 0x80 >> (i % 8);
+      t1h = high;
+      bad += (high < T1H_MIN || high > T1H_MAX);
+    } else {
+      t0h = high;
+      bad += (high < T0H_MIN || high > T0H_MAX);
+    }
+    if (i == n * 8 - 1) { //letztes Bit: Low-Zeit ist der Reset
+      reset = (pulses[i].low - (3 - pulses[i].high)) * T_SPI; //ohne die Low-Zeit des Bits selbst
+      break;
+    }
+    tl_min = (low < tl_min) ? low : tl_min;
+    tl_max = (low > tl_max) ? low : tl_max;
+    tbit_min = (high + low < tbit_min) ? high + low : tbit_min;
+    tbit_max = (high + low > tbit_max) ? high + low : tbit_max;
+  }
+  if (print) {
+    printf("%u bytes: T0H %u ns, T1H %u ns, low %u-%u ns, bit %u-%u ns, reset %u us\n", n, t0h, t1h, tl_min, tl_max, tbit_min, tbit_max, reset / 1000);
+  }
+  CHECK_EQ(bad, 0);
+  CHECK(reset >= RESET_MIN);
+  if (n > 1) {
+    CHECK(tl_min >= TL_MIN && tl_max <= TL_MAX);
+    CHECK(tbit_min >= TBIT_MIN && tbit_max <= TBIT_MAX);
+  }
+  CHECK(memcmp(out.data(), pixels, n) == 0);
+}
+
+int main()
+{
+  uint8_t pixels[BYTES];
+
+  //feste Muster: alle Bits 0, alle 1, abwechselnd
+  memset(pixels, 0x00, sizeof(pixels));
+  check_frame(pixels, BYTES);
+  memset(pixels, 0xFF, sizeof(pixels));
+  check_frame(pixels, BYTES);
+  memset(pixels, 0x55, sizeof(pixels));
+  check_frame(pixels, BYTES);
+
+  //reproduzierbar zufaellig, ein einzelnes Byte
+  srand(1);
+  for (int i = 0; i < BYTES; i++) {
+    pixels[i] = rand();
+  }
+  check_frame(pixels, BYTES, true);
+  check_frame(pixels, 1);
+
+  //Reset unabhaengig von der Streifenlaenge: nur Nullbytes nach dem Frame
+  CHECK(NEO_SPI_LATCH * 8 * T_SPI >= RESET_MIN);
+
+  return test_done();
+}
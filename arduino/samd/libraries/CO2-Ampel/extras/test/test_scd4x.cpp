@@ -0,0 +1,148 @@
+/*
+  SCD4x: the split-phase commands of the Sensirion driver (begin*(),
+  pollCommand(), read*Result()) against the slave model in stub/sensors.cpp,
+  then the sketch with an SCD4x: measurements through I2CQueue and the
+  serial commands T=, A=, C=, T?, A? as task in loop(), without blocking
+  a pass and without a command the sensor would reject.
+*/
+
+#include SKETCH
+#include <sensors.h>
+#include "test.h"
+
+static unsigned long pass_max; //us, laengster loop()-Durchlauf
+
+static void run(unsigned long ms) //loop() fuer ms virtuelle Millisekunden
+{
+  uint64_t end = stub_us + ms*1000ULL;
+
+  while (stub_us < end) {
+    uint64_t t = stub_us;
+    loop();
+    if ((stub_us - t) > pass_max) {
+      pass_max = stub_us - t;
+    }
+    stub_advance(50);
+  }
+}
+
+static std::string serial(const char *cmd) //Befehl senden, Antwort nach max. 3s
+{
+  Serial.in = cmd;
+  Serial.pos = 0;
+  Serial.out.clear();
+  for (int i = 0; i < 3000 && Serial.out.find('\n') == std::string::npos; i++) {
+    run(1);
+  }
+  return Serial.out;
+}
+
+static void test_driver(void)
+{
+  SensirionI2CScd4x drv;
+  uint16_t w, co2;
+  float f, temp, humi;
+  uint64_t t;
+
+  drv.begin(Wire);
+
+  //ohne Befehl: nichts ausstehend
+  CHECK(drv.pollCommand());
+
+  //Stop: 500ms Ausfuehrungszeit, der Aufruf selbst wartet nicht
+  CHECK_EQ(drv.startPeriodicMeasurement(), 0);
+  t = stub_us;
+  CHECK_EQ(drv.beginStopPeriodicMeasurement(), 0);
+  CHECK(stub_us - t < 1000);
+  CHECK(!drv.pollCommand());
+  CHECK(drv.beginSetSensorAltitude(100) != 0); //Sensor beschaeftigt: NACK
+  CHECK_EQ(stub_scd4x.violations, 1);
+  stub_scd4x.violations = 0;
+  delay(490);
+  CHECK(!drv.pollCommand());
+  delay(10);
+  CHECK(drv.pollCommand());
+  CHECK(!stub_scd4x.periodic);
+
+  //Temperaturoffset setzen und lesen
+  CHECK_EQ(drv.beginSetTemperatureOffset(5), 0);
+  delay(1);
+  CHECK(drv.pollCommand());
+  CHECK_EQ(stub_scd4x.offset, 1872); //5*65536/175
+  CHECK_EQ(drv.beginGetTemperatureOffset(), 0);
+  CHECK(drv.readTemperatureOffsetResult(f) != 0); //vor Ablauf der Ausfuehrungszeit
+  delay(1);
+  CHECK_EQ(drv.readTemperatureOffsetResult(f), 0);
+  CHECK(fabs(f - 5) < 0.01);
+
+  //Hoehe
+  CHECK_EQ(drv.beginSetSensorAltitude(420), 0);
+  delay(1);
+  CHECK_EQ(drv.beginGetSensorAltitude(), 0);
+  delay(1);
+  CHECK_EQ(drv.readSensorAltitudeResult(w), 0);
+  CHECK_EQ(w, 420);
+
+  //Kalibrierung auf 500ppm bei 600ppm gemessen: Korrektur -100ppm
+  stub_co2 = 600;
+  CHECK_EQ(drv.beginPerformForcedRecalibration(500), 0);
+  delay(399);
+  CHECK(!drv.pollCommand());
+  delay(1);
+  CHECK_EQ(drv.readForcedRecalibrationResult(w), 0);
+  CHECK_EQ((int)w - 0x8000, -100);
+
+  //Einzelmessung nach 5s
+  CHECK_EQ(drv.beginMeasureSingleShot(), 0);
+  delay(4999);
+  CHECK(!drv.pollCommand());
+  delay(1);
+  CHECK(drv.pollCommand());
+  CHECK_EQ(drv.readMeasurement(co2, temp, humi), 0);
+  CHECK_EQ(co2, 600);
+  CHECK(fabs(temp - stub_temp) < 0.01);
+  CHECK(fabs(humi - stub_humi) < 0.01);
+  CHECK_EQ(stub_scd4x.violations, 0);
+}
+
+int main()
+{
+  stub_i2c_devices[ADDR_SCD4X] = true;
+  test_driver();
+
+  stub_scd4x.offset = 1489; //4 Grad C
+  setup();
+  CHECK(features & FEATURE_SCD4X);
+  CHECK(stub_scd4x.periodic);
+
+  //Messwerte alle 5s per I2C-Warteschlange
+  stub_co2 = 800;
+  run(30000);
+  CHECK_EQ(co2_value, 800);
+  CHECK(stub_scd4x.reads >= 5);
+  CHECK_EQ(err_co2, 0);
+
+  //serielle Befehle: Messung stoppen, Befehl, Messung starten, ohne loop() aufzuhalten
+  pass_max = 0;
+  remote_on = 1;
+  CHECK(serial("T=6\n") == "OK\r\n");
+  CHECK_EQ(stub_scd4x.offset, 2247); //6*65536/175
+  CHECK(stub_scd4x.periodic);
+  CHECK(serial("T?") == "6\r\n");
+  CHECK(serial("A=300\n") == "OK\r\n");
+  CHECK_EQ(stub_scd4x.altitude, 300);
+  CHECK(serial("A?") == "300\r\n");
+  CHECK(serial("C=700\n") == "OK\r\n");
+  CHECK_EQ(stub_scd4x.frc, 700);
+  CHECK(stub_scd4x.periodic);
+  printf("serial commands: loop() max %lu us\n", pass_max);
+  CHECK(pass_max < LOOP_BUDGET*1000UL);
+
+  //Messung laeuft weiter
+  stub_co2 = 900;
+  run(15000);
+  CHECK_EQ(co2_value, 900);
+  CHECK_EQ(stub_scd4x.violations, 0);
+
+  return test_done();
+}
@@ -0,0 +1,177 @@
+/*
+  Adafruit_SSD1306::display() sends only the changed columns: the library
+  talks to a model of the controller RAM (horizontal addressing, page and
+  column address window) via the Wire stub, after every display() the
+  model has to match the buffer.
+*/
+
+#include <Adafruit_SSD1306.h>
+#include "test.h"
+
+#define WIDTH  128
+#define HEIGHT 64
+
+static uint8_t ram[WIDTH*HEIGHT/8]; //Display-RAM des SSD1306
+static unsigned long data_bytes;    //gesendete Datenbytes
+
+static struct
+{
+  uint8_t cmd, need, got, arg[2]; //Befehl und seine Parameter
+  uint8_t p0, p1, x0, x1, page, col;
+} oled;
+
+static unsigned int cmd_args(uint8_t cmd) //Anzahl der Parameter
+{
+  switch (cmd) {
+    case SSD1306_COLUMNADDR:
+    case SSD1306_PAGEADDR:
+      return 2;
+    case SSD1306_MEMORYMODE:
+    case SSD1306_SETCONTRAST:
+    case SSD1306_CHARGEPUMP:
+    case SSD1306_SETMULTIPLEX:
+    case SSD1306_SETDISPLAYOFFSET:
+    case SSD1306_SETDISPLAYCLOCKDIV:
+    case SSD1306_SETPRECHARGE:
+    case SSD1306_SETCOMPINS:
+    case SSD1306_SETVCOMDETECT:
+      return 1;
+  }
+  return 0;
+}
+
+static void oled_cmd(uint8_t c) //Befehle koennen auf mehrere Transfers verteilt sein
+{
+  if (oled.need == 0) {
+    oled.cmd = c;
+    oled.need = cmd_args(c);
+    oled.got = 0;
+    return;
+  }
+  if (oled.got < sizeof(oled.arg)) {
+    oled.arg[oled.got] = c;
+  }
+  if (++oled.got < oled.need) {
+    return;
+  }
+  oled.need = 0;
+  if (oled.cmd == SSD1306_PAGEADDR) {
+    oled.p0 = oled.page = oled.arg[0];
+    oled.p1 = oled.arg[1];
+  } else if (oled.cmd == SSD1306_COLUMNADDR) {
+    oled.x0 = oled.col = oled.arg[0];
+    oled.x1 = oled.arg[1];
+  }
+}
+
+static void oled_data(uint8_t d)
+{
+  ram[oled.page*WIDTH + oled.col] = d;
+  data_bytes++;
+  if (oled.col++ == oled.x1) {
+    oled.col = oled.x0;
+    oled.page = (oled.page == oled.p1) ? oled.p0 : (oled.page + 1);
+  }
+}
+
+static uint8_t oled_tx(TwoWire *, uint8_t addr, const uint8_t *data, size_t len)
+{
+  if (addr != 0x3C || len == 0) {
+    return 2;
+  }
+  for (size_t i = 1; i < len; i++) {
+    if (data[0] == 0x00) {
+      oled_cmd(data[i]);
+    } else if (data[0] == 0x40) {
+      oled_data(data[i]);
+    }
+  }
+  return 0;
+}
+
+class TestDisplay : public Adafruit_SSD1306
+{
+public:
+  TestDisplay() : Adafruit_SSD1306(WIDTH, HEIGHT, &Wire) { }
+  const uint8_t *buf() { return buffer; }
+};
+
+static TestDisplay display;
+
+static bool same(void)
+{
+  return memcmp(ram, display.buf(), sizeof(ram)) == 0;
+}
+
+int main()
+{
+  unsigned long n;
+
+  stub_wire_tx = oled_tx;
+  memset(ram, 0x55, sizeof(ram));
+  CHECK(display.begin(SSD1306_SWITCHCAPVCC, 0x3C));
+
+  //erstes display(): alles
+  display.clearDisplay();
+  display.display();
+  CHECK(same());
+  CHECK_EQ(data_bytes, sizeof(ram));
+
+  //ohne Aenderung: nichts
+  data_bytes = 0;
+  display.display();
+  CHECK_EQ(data_bytes, 0);
+
+  //Pixel, die schon gesetzt sind, aendern nichts
+  display.drawPixel(3, 3, SSD1306_BLACK);
+  display.display();
+  CHECK_EQ(data_bytes, 0);
+
+  //ein Pixel: eine Spalte
+  display.drawPixel(100, 40, SSD1306_WHITE);
+  display.display();
+  CHECK(same());
+  CHECK_EQ(data_bytes, 1);
+
+  //Text in einer Zeile: nur die Spalten des Textes
+  data_bytes = 0;
+  display.setTextColor(SSD1306_WHITE);
+  display.setTextSize(1);
+  display.setCursor(10, 8);
+  display.print("1234");
+  display.display();
+  CHECK(same());
+  CHECK(data_bytes <= 4*6);
+
+  //Zufaellige Aenderungen in allen Drehungen, Modell muss dem Puffer folgen
+  uint32_t rnd = 1;
+  unsigned int bad = 0, full = 0;
+  data_bytes = 0;
+  for (int i = 0; i < 2000; i++) {
+    rnd = rnd * 1103515245 + 12345;
+    display.setRotation((rnd >> 8) & 3);
+    int16_t x = (rnd >> 10) % (WIDTH+16) - 8, y = (rnd >> 18) % (HEIGHT+16) - 8;
+    switch ((rnd >> 26) % 5) {
+      case 0: display.drawPixel(x, y, SSD1306_INVERSE); break;
+      case 1: display.fillRect(x, y, (rnd >> 3) % 40, (rnd >> 5) % 20, (rnd & 1) ? SSD1306_WHITE : SSD1306_BLACK); break;
+      case 2: display.drawFastHLine(x, y, (rnd >> 4) % 100, SSD1306_INVERSE); break;
+      case 3: display.drawFastVLine(x, y, (rnd >> 4) % 60, SSD1306_WHITE); break;
+      case 4: display.setCursor(x, y); display.print(i); break;
+    }
+    if ((rnd >> 29) == 0) {
+      memset(ram, 0x55, sizeof(ram)); //Display-RAM verloren (z.B. Reset): alles neu senden
+      display.getBuffer();
+      full++;
+    }
+    display.display();
+    if (!same()) {
+      bad++;
+    }
+  }
+  CHECK_EQ(bad, 0);
+  n = (data_bytes - full*sizeof(ram)) / 2000; //Bytes pro display() ohne die vollstaendigen
+  printf("%lu bytes per display() instead of %u\n", n, (unsigned int)sizeof(ram));
+  CHECK(n < sizeof(ram)/4);
+
+  return test_done();
+}
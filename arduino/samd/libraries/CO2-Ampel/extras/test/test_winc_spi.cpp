@@ -0,0 +1,226 @@
+/*
+  WiFi101 bus wrapper: spi_rw_block() of nm_bus_wrapper_samd21.cpp (built
+  with WINC1501_SPI_SERCOM=SERCOM1) against a model of the SERCOM SPI
+  master, and the same file without it as reference (ref_nm_bus_ioctl, the
+  WINC1501_SPI.transfer() loop through the same model). Checks that never
+  more than 2 bytes are in flight, that the receive buffer does not
+  overflow, and that both paths send and receive the same bytes. Prints
+  the modelled time per 1472 byte block (one UDP/TCP payload) at 48 MHz.
+*/
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <vector>
+#include "test.h"
+
+extern "C" {
+#include "bus_wrapper/include/nm_bus_wrapper.h"
+sint8 ref_nm_bus_ioctl(uint8 u8Cmd, void* pvParameter);
+}
+
+//Takte der CPU (48MHz)
+#define CPU_MHZ    48
+#define SPI_MHZ    12                        //wifi_SPISettings
+#define BYTE_CLK   (8 * CPU_MHZ / SPI_MHZ)   //ein Byte auf dem Bus
+#define CALL_CLK   12                        //Aufruf von SPIClass::transfer()
+
+int8_t gi8Winc1501CsPin = 10;
+
+extern "C" void nm_bsp_reset(void) { }
+extern "C" void nm_bsp_sleep(uint32 u32TimeMsec) { }
+
+//SERCOM-SPI-Master: DATA schreibt in den Sendepuffer, von dort ins
+//Schieberegister, empfangene Bytes in den 2-stufigen Empfangspuffer
+static struct
+{
+  unsigned int access;          //Takte pro Registerzugriff (mit Schleife)
+  uint64_t clk;                 //CPU-Takte
+  bool tx_full, shifting;
+  uint8_t tx, shift;
+  uint64_t tx_clk, shift_end, idle_clk;
+  uint8_t rx[2];
+  unsigned int rx_n;
+  unsigned long written, read, in_flight_max, overflow, underflow, lost_tx;
+  std::vector<uint8_t> mosi;    //beim WINC angekommen
+  std::vector<uint8_t> miso;    //vom WINC gesendet
+} bus;
+
+static SercomSpi *spi = &SERCOM1->SPI;
+
+static uint8_t winc(uint8_t in) //Antwort des WINC, haengt von Position und letztem Byte ab
+{
+  uint8_t out = (uint8_t)(bus.mosi.size() * 7 + (bus.mosi.empty() ? 0 : bus.mosi.back() * 13) + 0x5A);
+
+  bus.mosi.push_back(in);
+  bus.miso.push_back(out);
+  return out;
+}
+
+static void bus_sync(void) //Hardware bis bus.clk nachfuehren
+{
+  for (;;) {
+    if (bus.shifting && bus.shift_end <= bus.clk) {
+      uint8_t b = winc(bus.shift);
+      if (bus.rx_n < 2) {
+        bus.rx[bus.rx_n++] = b;
+      } else {
+        bus.overflow++; //BUFOVF: Byte verloren
+      }
+      bus.shifting = false;
+      bus.idle_clk = bus.shift_end;
+    } else if (!bus.shifting && bus.tx_full) {
+      uint64_t start = (bus.tx_clk > bus.idle_clk) ? bus.tx_clk : bus.idle_clk;
+      bus.shift = bus.tx;
+      bus.shift_end = start + BYTE_CLK;
+      bus.shifting = true;
+      bus.tx_full = false;
+    } else {
+      break;
+    }
+  }
+}
+
+static void bus_read(StubReg *r)
+{
+  bus.clk += bus.access;
+  bus_sync();
+  if (r == &spi->INTFLAG.bit.DRE) {
+    r->v = !bus.tx_full;
+  } else if (r == &spi->INTFLAG.bit.RXC) {
+    r->v = (bus.rx_n > 0);
+  } else if (r == &spi->DATA.reg) {
+    if (bus.rx_n == 0) {
+      bus.underflow++;
+      return;
+    }
+    r->v = bus.rx[0];
+    bus.rx[0] = bus.rx[1];
+    bus.rx_n--;
+    bus.read++;
+  }
+}
+
+static void bus_write(StubReg *r, uint32_t old)
+{
+  if (r != &spi->DATA.reg) {
+    return;
+  }
+  bus.clk += bus.access;
+  bus_sync();
+  if (bus.tx_full) {
+    bus.lost_tx++; //ohne DRE geschrieben
+    return;
+  }
+  bus.tx = r->v;
+  bus.tx_full = true;
+  bus.tx_clk = bus.clk;
+  bus.written++;
+  if (bus.written - bus.read > bus.in_flight_max) {
+    bus.in_flight_max = bus.written - bus.read;
+  }
+}
+
+static uint8_t transfer(uint8_t data) //SERCOM::transferDataSPI() des Cores
+{
+  bus.clk += CALL_CLK;
+  spi->DATA.reg = data;
+  while (!spi->INTFLAG.bit.RXC) {
+  }
+  return spi->DATA.reg;
+}
+
+static void bus_reset(unsigned int access)
+{
+  bus.access = access;
+  bus.clk = bus.shift_end = bus.idle_clk = 0;
+  bus.tx_full = bus.shifting = false;
+  bus.rx_n = 0;
+  bus.written = bus.read = bus.in_flight_max = bus.overflow = bus.underflow = bus.lost_tx = 0;
+  bus.mosi.clear();
+  bus.miso.clear();
+}
+
+struct Result
+{
+  std::vector<uint8_t> mosi, miso, buf;
+  uint64_t clk;
+  unsigned long in_flight_max;
+};
+
+//ein Aufruf von nm_bus_ioctl(): tx = senden (MISO verworfen), sonst empfangen (MOSI 0)
+static Result rw(bool block, bool tx, uint16 size, unsigned int access)
+{
+  Result r;
+  tstrNmSpiRw param;
+
+  r.buf.resize(size);
+  for (uint16 i = 0; i < size; i++) {
+    r.buf[i] = tx ? (uint8_t)(i * 31 + 1) : 0xEE;
+  }
+  param.pu8InBuf = tx ? r.buf.data() : NULL;
+  param.pu8OutBuf = tx ? NULL : r.buf.data();
+  param.u16Sz = size;
+
+  bus_reset(access);
+  CHECK_EQ(block ? nm_bus_ioctl(NM_BUS_IOCTL_RW, &param) : ref_nm_bus_ioctl(NM_BUS_IOCTL_RW, &param), M2M_SUCCESS);
+  CHECK_EQ(bus.written, size);
+  CHECK_EQ(bus.read, size);
+  CHECK_EQ(bus.overflow, 0);
+  CHECK_EQ(bus.underflow, 0);
+  CHECK_EQ(bus.lost_tx, 0);
+  CHECK(!bus.tx_full && !bus.shifting && bus.rx_n == 0);
+  r.mosi = bus.mosi;
+  r.miso = bus.miso;
+  r.clk = bus.clk;
+  r.in_flight_max = bus.in_flight_max;
+  return r;
+}
+
+static void compare(bool tx, uint16 size, unsigned int access)
+{
+  Result blk = rw(true, tx, size, access), ref = rw(false, tx, size, access);
+
+  CHECK(blk.in_flight_max <= 2);
+  CHECK(blk.mosi == ref.mosi);
+  CHECK(blk.miso == ref.miso);
+  CHECK(blk.buf == ref.buf);
+  if (tx) {
+    CHECK(blk.mosi == blk.buf);
+  } else {
+    CHECK(blk.miso == blk.buf);
+    CHECK_EQ(blk.mosi[size - 1], 0);
+  }
+}
+
+int main()
+{
+  static const uint16 sizes[] = { 1, 2, 3, 4, 256, 1472 };
+  static const unsigned int access[] = { 2, 6, 20, 40 }; //40: CPU langsamer als der Bus
+
+  stub_reg_read = bus_read;
+  stub_reg_write = bus_write;
+  stub_spi_transfer = transfer;
+
+  for (unsigned int a = 0; a < sizeof(access)/sizeof(access[0]); a++) {
+    for (unsigned int s = 0; s < sizeof(sizes)/sizeof(sizes[0]); s++) {
+      compare(true, sizes[s], access[a]);
+      compare(false, sizes[s], access[a]);
+    }
+  }
+
+  //1472 Bytes mit 6 Takten pro Registerzugriff
+  for (int tx = 1; tx >= 0; tx--) {
+    Result blk = rw(true, tx, 1472, 6), ref = rw(false, tx, 1472, 6);
+    double us_blk = (double)blk.clk / CPU_MHZ, us_ref = (double)ref.clk / CPU_MHZ;
+
+    printf("%s 1472 bytes: spi_rw_block() %.1f us (%.2f MB/s), transfer() loop %.1f us (%.2f MB/s), bus limit %.1f us\n",
+           tx ? "write" : "read ", us_blk, 1472 / us_blk, us_ref, 1472 / us_ref, 1472.0 * BYTE_CLK / CPU_MHZ);
+    CHECK(blk.clk < ref.clk);
+    CHECK(blk.clk < 1472ULL * BYTE_CLK * 11 / 10); //max. 10% ueber der Bus-Zeit
+  }
+
+  stub_reg_read = NULL;
+  stub_reg_write = NULL;
+  stub_spi_transfer = NULL;
+  return test_done();
+}
@@ -0,0 +1,20 @@
+/*
+  ArduinoBearSSL settings for the CO2-Ampel (MQTT_TLS).
+
+  MQTT is request/response, so one shared 1 kB record buffer is enough
+  (max_fragment_length 1024) and saves about 7 kB RAM per connection.
+  The broker must support the extension: a broker that ignores it sends
+  larger records (usually already its certificate) and the connection
+  fails on the first one over 1 kB. Therefore off by default.
+
+  The option is set here and not in the sketch, because BearSSLClient.cpp
+  has to be compiled with the same buffer size as the sketch.
+*/
+
+#pragma once
+
+#define MQTT_TLS_LOW_MEMORY 0 // 1 = one shared 1 kB record buffer instead of the 8 kB input buffer
+
+#if MQTT_TLS_LOW_MEMORY
+  #define BEAR_SSL_CLIENT_LOW_MEMORY 1024
+#endif
@@ -0,0 +1,274 @@
+/*
+  Interrupt driven I2C master transfer queue for SERCOM0 (Wire) and
+  SERCOM2 (Wire1) of the CO2-Ampel variant.
+*/
+
+#include "I2CQueue.h"
+
+#define I2CM_INT (SERCOM_I2CM_INTENSET_MB | SERCOM_I2CM_INTENSET_SB | SERCOM_I2CM_INTENSET_ERROR)
+
+#define CMD_READ 2 // ACK and read the next byte
+#define CMD_STOP 3
+
+static I2CQueue *queue0 = NULL; // SERCOM0
+static I2CQueue *queue2 = NULL; // SERCOM2
+
+static void queue0_handler(void)
+{
+  queue0->onService();
+}
+
+static void queue2_handler(void)
+{
+  queue2->onService();
+}
+
+static inline void sync_sysop(Sercom *sercom)
+{
+  while (sercom->I2CM.SYNCBUSY.bit.SYSOP);
+}
+
+I2CQueue::I2CQueue(Sercom *sercom, TwoWire *wire) :
+  sercom(sercom), wire(wire),
+  current(NULL), first(NULL), last(NULL),
+  pos(0), reading(false), lock(0),
+  t_start(0), _errors(0)
+{
+}
+
+void I2CQueue::begin()
+{
+  sercom->I2CM.INTENCLR.reg = I2CM_INT;
+  if (sercom == SERCOM0) {
+    queue0 = this;
+    sercom0_handler = queue0_handler;
+  } else if (sercom == SERCOM2) {
+    queue2 = this;
+    sercom2_handler = queue2_handler;
+  }
+}
+
+void I2CQueue::end()
+{
+  wait();
+  sercom->I2CM.INTENCLR.reg = I2CM_INT;
+  if (queue0 == this) {
+    sercom0_handler = NULL;
+    queue0 = NULL;
+  } else if (queue2 == this) {
+    sercom2_handler = NULL;
+    queue2 = NULL;
+  }
+}
+
+I2CQueue *I2CQueue::find(TwoWire *wire)
+{
+  if (queue0 && queue0->wire == wire) {
+    return queue0;
+  }
+  if (queue2 && queue2->wire == wire) {
+    return queue2;
+  }
+  return NULL;
+}
+
+bool I2CQueue::submit(I2CTransfer *t)
+{
+  uint32_t primask;
+
+  if (t->status == I2C_PENDING) {
+    return false;
+  }
+  t->status = I2C_PENDING;
+  t->next = NULL;
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if (current == NULL && lock == 0) {
+    start(t);
+  } else {
+    if (first == NULL) {
+      first = t;
+    } else {
+      last->next = t;
+    }
+    last = t;
+  }
+  __set_PRIMASK(primask);
+
+  return true;
+}
+
+void I2CQueue::start(I2CTransfer *t)
+{
+  current = t;
+  pos = 0;
+  reading = (t->headLen == 0) && (t->txLen == 0) && (t->rxLen != 0);
+  t_start = millis();
+
+  sercom->I2CM.INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR;
+  sercom->I2CM.INTENSET.reg = I2CM_INT;
+  // Waits for an idle bus, e.g. behind the STOP of the previous transfer
+  sercom->I2CM.ADDR.bit.ADDR = (t->addr << 1) | (reading ? 1 : 0);
+  sync_sysop(sercom);
+}
+
+void I2CQueue::stop()
+{
+  sercom->I2CM.CTRLB.bit.CMD = CMD_STOP;
+  sync_sysop(sercom);
+}
+
+void I2CQueue::finish(int8_t status)
+{
+  I2CTransfer *t = current;
+
+  if (status != I2C_OK) {
+    _errors++;
+  }
+  current = NULL;
+  t->status = status;
+
+  if (first != NULL && lock == 0) {
+    I2CTransfer *next = first;
+    first = next->next;
+    start(next);
+  } else {
+    sercom->I2CM.INTENCLR.reg = I2CM_INT;
+  }
+
+  if (t->done) {
+    t->done(t);
+  }
+}
+
+void I2CQueue::onService()
+{
+  uint8_t flags = sercom->I2CM.INTFLAG.reg;
+  uint16_t status = sercom->I2CM.STATUS.reg;
+  I2CTransfer *t = current;
+
+  if (t == NULL) {
+    sercom->I2CM.INTENCLR.reg = I2CM_INT;
+    return;
+  }
+
+  if (flags & SERCOM_I2CM_INTFLAG_ERROR) {
+    sercom->I2CM.INTFLAG.reg = SERCOM_I2CM_INTFLAG_ERROR;
+    stop();
+    finish(I2C_ERR_BUS);
+  } else if (flags & SERCOM_I2CM_INTFLAG_MB) {
+    if (status & (SERCOM_I2CM_STATUS_BUSERR | SERCOM_I2CM_STATUS_ARBLOST)) {
+      stop();
+      finish(I2C_ERR_BUS);
+    } else if ((status & SERCOM_I2CM_STATUS_RXNACK) || reading) {
+      // A read reports its address NACK with MB instead of SB
+      stop();
+      finish(I2C_ERR_NACK);
+    } else if (pos < t->headLen) {
+      sercom->I2CM.DATA.reg = t->head[pos++];
+    } else if (pos < t->headLen + t->txLen) {
+      sercom->I2CM.DATA.reg = t->tx[pos++ - t->headLen];
+    } else if (t->rxLen != 0) {
+      // Repeated start
+      reading = true;
+      pos = 0;
+      sercom->I2CM.ADDR.bit.ADDR = (t->addr << 1) | 1;
+      sync_sysop(sercom);
+    } else {
+      stop();
+      finish(I2C_OK);
+    }
+  } else if (flags & SERCOM_I2CM_INTFLAG_SB) {
+    t->rx[pos++] = sercom->I2CM.DATA.reg;
+    if (pos < t->rxLen) {
+      sercom->I2CM.CTRLB.bit.ACKACT = 0;
+      sercom->I2CM.CTRLB.bit.CMD = CMD_READ;
+      sync_sysop(sercom);
+    } else {
+      // NACK the last byte
+      sercom->I2CM.CTRLB.bit.ACKACT = 1;
+      stop();
+      finish(I2C_OK);
+    }
+  }
+}
+
+void I2CQueue::service()
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (current != NULL && (millis() - t_start) > I2C_TIMEOUT) {
+    stop();
+    // Force the bus state to idle, a slave may still hold SDA low
+    sercom->I2CM.STATUS.reg = SERCOM_I2CM_STATUS_BUSSTATE(1);
+    sync_sysop(sercom);
+    finish(I2C_ERR_TIMEOUT);
+  }
+  __set_PRIMASK(primask);
+}
+
+bool I2CQueue::wait(uint32_t timeout)
+{
+  uint32_t t = millis();
+
+  while (current != NULL || (first != NULL && lock == 0)) {
+    service();
+    if ((millis() - t) > timeout) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void I2CQueue::acquire()
+{
+  lock++;
+  while (current != NULL) {
+    service();
+  }
+}
+
+void I2CQueue::release()
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if (lock != 0 && --lock == 0 && current == NULL && first != NULL) {
+    I2CTransfer *t = first;
+    first = t->next;
+    start(t);
+  }
+  __set_PRIMASK(primask);
+}
+
+bool I2CQueue::probe(uint8_t addr)
+{
+  I2CTransfer t = { };
+
+  t.addr = addr;
+  submit(&t);
+  while (t.status == I2C_PENDING) {
+    service();
+  }
+
+  return (t.status == I2C_OK);
+}
+
+void i2c_bus_acquire(TwoWire *wire)
+{
+  I2CQueue *q = I2CQueue::find(wire);
+  if (q) {
+    q->acquire();
+  }
+}
+
+void i2c_bus_release(TwoWire *wire)
+{
+  I2CQueue *q = I2CQueue::find(wire);
+  if (q) {
+    q->release();
+  }
+}
@@ -0,0 +1,98 @@
+/*
+  Interrupt driven I2C master transfer queue for SERCOM0 (Wire) and
+  SERCOM2 (Wire1) of the CO2-Ampel variant.
+
+  Transfers are owned by the caller and must stay valid until their status
+  is no longer I2C_PENDING. Completion callbacks run in interrupt context.
+  Synchronous drivers (Adafruit_I2CDevice, SensirionI2CCommunication, SCD30,
+  ECCX08) share the bus through acquire()/release(), they hold it with
+  I2CBusLock of the variant, which calls i2c_bus_acquire()/i2c_bus_release().
+*/
+
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define I2C_OK           0
+#define I2C_PENDING      1
+#define I2C_ERR_NACK    -1 // address or data not acknowledged
+#define I2C_ERR_BUS     -2 // bus error or arbitration lost
+#define I2C_ERR_TIMEOUT -3
+
+#define I2C_TIMEOUT 100 // ms per transfer
+
+struct I2CTransfer {
+  uint8_t addr;                         // 7-bit address
+  uint8_t headLen;                      // bytes sent before tx (register, control byte)
+  const uint8_t *head;
+  const uint8_t *tx;                    // write, then read with repeated start
+  uint8_t *rx;
+  uint16_t txLen, rxLen;                // all zero: address probe
+  volatile int8_t status;
+  void (*done)(I2CTransfer *t);         // optional, interrupt context
+  void *arg;                            // for the callback
+  I2CTransfer *next;
+};
+
+class I2CQueue {
+public:
+  I2CQueue(Sercom *sercom, TwoWire *wire);
+
+  /**
+   * Install the interrupt hook, call after wire->begin()
+   */
+  void begin();
+  void end();
+
+  /**
+   * Queue a transfer
+   * @return false, if the transfer is still pending
+   */
+  bool submit(I2CTransfer *t);
+
+  /**
+   * Abort a transfer after I2C_TIMEOUT ms, call from loop()
+   */
+  void service();
+
+  /**
+   * Finish all queued transfers
+   * @return false on timeout
+   */
+  bool wait(uint32_t timeout = 1000);
+
+  /**
+   * Exclusive use of the bus for synchronous drivers, waits for the running
+   * transfer and holds back the queue until release(). Calls can be nested.
+   */
+  void acquire();
+  void release();
+
+  /**
+   * Check if a device acknowledges its address (blocking)
+   */
+  bool probe(uint8_t addr);
+
+  bool busy() { return (current != NULL) || (first != NULL); }
+  uint32_t errors() { return _errors; }
+
+  void onService();
+  static I2CQueue *find(TwoWire *wire);
+
+private:
+  void start(I2CTransfer *t);
+  void stop();
+  void finish(int8_t status);
+
+  Sercom *sercom;
+  TwoWire *wire;
+  I2CTransfer * volatile current;
+  I2CTransfer * volatile first;
+  I2CTransfer *last;
+  uint16_t pos;
+  bool reading;
+  volatile uint8_t lock;
+  uint32_t t_start;
+  uint32_t _errors;
+};
@@ -0,0 +1,266 @@
+/*
+  Append-only, wear-levelled record log in flash memory.
+
+  Copyright (c) 2015-2016 Arduino LLC.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "FlashLog.h"
+
+#define FLASHLOG_MAGIC 0x4C46
+
+// Size of a record in flash, rounded up to whole pages
+#define RECORD_SIZE(n) ((sizeof(FlashLogHeader) + (n) + FLASHLOG_PAGE_SIZE - 1) / FLASHLOG_PAGE_SIZE * FLASHLOG_PAGE_SIZE)
+
+// CRC-16/CCITT
+static uint16_t crc16(uint16_t crc, const uint8_t *data, uint32_t size)
+{
+  while (size--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+  }
+  return crc;
+}
+
+static uint16_t record_crc(const FlashLogHeader *h, const void *data)
+{
+  uint16_t crc = crc16(0xFFFF, (const uint8_t *)h, offsetof(FlashLogHeader, crc));
+  crc = crc16(crc, (const uint8_t *)&h->seq, sizeof(h->seq));
+  return crc16(crc, (const uint8_t *)data, h->size);
+}
+
+FlashLogClass::FlashLogClass(const void *flash_addr, uint32_t size) :
+  flash(flash_addr, size),
+  base((const uint8_t *)flash_addr),
+  blocks(size / FLASHLOG_BLOCK_SIZE),
+  _head(0), _offset(0), _seq(0),
+  _writes(0), _erases(0)
+{
+  memset(_latest, 0, sizeof(_latest));
+}
+
+const FlashLogHeader *FlashLogClass::record(uint32_t block, uint32_t offset)
+{
+  return (const FlashLogHeader *)(base + (block * FLASHLOG_BLOCK_SIZE) + offset);
+}
+
+bool FlashLogClass::valid(const FlashLogHeader *h, uint32_t room)
+{
+  if (room < sizeof(FlashLogHeader) || h->magic != FLASHLOG_MAGIC) {
+    return false;
+  }
+  if (RECORD_SIZE(h->size) > room) {
+    return false;
+  }
+  return (h->crc == record_crc(h, h + 1));
+}
+
+bool FlashLogClass::erased(uint32_t block, uint32_t offset)
+{
+  const uint32_t *p = (const uint32_t *)record(block, offset);
+  const uint32_t *end = (const uint32_t *)record(block, FLASHLOG_BLOCK_SIZE);
+  while (p < end) {
+    if (*p++ != 0xFFFFFFFF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Next valid record at or behind offset, skips the pages of a torn write
+const FlashLogHeader *FlashLogClass::find(uint32_t block, uint32_t *offset)
+{
+  const FlashLogHeader *h;
+
+  while (*offset < FLASHLOG_BLOCK_SIZE) {
+    h = record(block, *offset);
+    if (valid(h, FLASHLOG_BLOCK_SIZE - *offset)) {
+      return h;
+    }
+    if (erased(block, *offset)) {
+      break;
+    }
+    *offset += FLASHLOG_PAGE_SIZE;
+  }
+  return NULL;
+}
+
+void FlashLogClass::begin()
+{
+  uint32_t block, offset;
+  const FlashLogHeader *h;
+  bool found = false;
+
+  _seq = 0;
+  memset(_latest, 0, sizeof(_latest));
+
+  for (block = 0; block < blocks; block++) {
+    for (offset = 0; (h = find(block, &offset)) != NULL; offset += RECORD_SIZE(h->size)) {
+      if (h->type < FLASHLOG_TYPES && (_latest[h->type] == NULL || h->seq > _latest[h->type]->seq)) {
+        _latest[h->type] = h;
+      }
+      if (!found || h->seq > _seq) {
+        _seq = h->seq;
+        _head = block;
+        found = true;
+      }
+    }
+  }
+
+  // Empty, never written or otherwise unusable (the linker fills it with 0)
+  if (!found) {
+    flash.erase(base, blocks * FLASHLOG_BLOCK_SIZE);
+    _erases += blocks;
+    _head = 0;
+    _offset = 0;
+    return;
+  }
+
+  // Write behind the last valid record, a torn write only dirties its own
+  // pages (find() stops at the first erased page or the end of the block)
+  for (offset = 0; (h = find(_head, &offset)) != NULL; offset += RECORD_SIZE(h->size));
+  _offset = offset;
+
+  // The block behind the head is the spare, it must be empty
+  if (!erased(next(_head), 0)) {
+    collect(next(_head));
+  }
+}
+
+void FlashLogClass::program(uint8_t type, const void *data, uint16_t size)
+{
+  uint8_t page[FLASHLOG_PAGE_SIZE];
+  FlashLogHeader *h = (FlashLogHeader *)page;
+  const uint8_t *dst = (const uint8_t *)record(_head, _offset);
+  uint32_t n;
+
+  h->magic = FLASHLOG_MAGIC;
+  h->type  = type;
+  h->flags = 0xFF;
+  h->size  = size;
+  h->seq   = ++_seq;
+  h->crc   = record_crc(h, data);
+
+  // First page holds the header and the start of the data
+  memset(page + sizeof(FlashLogHeader), 0xFF, sizeof(page) - sizeof(FlashLogHeader));
+  n = sizeof(page) - sizeof(FlashLogHeader);
+  if (n > size) {
+    n = size;
+  }
+  memcpy(page + sizeof(FlashLogHeader), data, n);
+  flash.write(dst, page, sizeof(page));
+  if (size > n) {
+    flash.write(dst + sizeof(page), (const uint8_t *)data + n, size - n);
+  }
+
+  if (type < FLASHLOG_TYPES) {
+    _latest[type] = (const FlashLogHeader *)dst;
+  }
+  _offset += RECORD_SIZE(size);
+  _writes++;
+}
+
+bool FlashLogClass::collect(uint32_t block)
+{
+  uint32_t offset;
+  const FlashLogHeader *h;
+  bool complete = true;
+
+  // Copy the latest record of each type forward (data is read from flash)
+  for (offset = 0; (h = find(block, &offset)) != NULL; offset += RECORD_SIZE(h->size)) {
+    if (h->type < FLASHLOG_TYPES && _latest[h->type] == h) {
+      if (_offset + RECORD_SIZE(h->size) <= FLASHLOG_BLOCK_SIZE) {
+        program(h->type, h + 1, h->size);
+      } else {
+        complete = false;
+      }
+    }
+  }
+
+  // Never erase the only copy of a latest record
+  if (!complete) {
+    return false;
+  }
+  flash.erase(record(block, 0), FLASHLOG_BLOCK_SIZE);
+  _erases++;
+
+  return true;
+}
+
+bool FlashLogClass::write(uint8_t type, const void *data, uint16_t size)
+{
+  if (blocks < 3 || RECORD_SIZE(size) > FLASHLOG_BLOCK_SIZE) {
+    return false;
+  }
+
+  // Move on until the record fits, the records copied forward by collect()
+  // may fill the new head. The spare must be erased, it is not if a previous
+  // collect() could not copy everything.
+  for (uint32_t i = 0; _offset + RECORD_SIZE(size) > FLASHLOG_BLOCK_SIZE; i++) {
+    if (i >= blocks - 2 || !erased(next(_head), 0)) {
+      return false;
+    }
+    _head = next(_head);
+    _offset = 0;
+    collect(next(_head));
+  }
+
+  program(type, data, size);
+
+  return true;
+}
+
+bool FlashLogClass::read(uint8_t type, void *data, uint16_t size)
+{
+  const FlashLogHeader *h = (type < FLASHLOG_TYPES) ? _latest[type] : NULL;
+
+  if (h == NULL || h->size != size) {
+    return false;
+  }
+  memcpy(data, h + 1, size);
+
+  return true;
+}
+
+bool FlashLogClass::equals(uint8_t type, const void *data, uint16_t size)
+{
+  const FlashLogHeader *h = (type < FLASHLOG_TYPES) ? _latest[type] : NULL;
+
+  return h != NULL && h->size == size && memcmp(data, h + 1, size) == 0;
+}
+
+uint32_t FlashLogClass::readNext(uint8_t type, uint32_t seq, void *data, uint16_t size)
+{
+  uint32_t block, offset;
+  const FlashLogHeader *h, *found = NULL;
+
+  for (block = 0; block < blocks; block++) {
+    for (offset = 0; (h = find(block, &offset)) != NULL; offset += RECORD_SIZE(h->size)) {
+      if (h->type == type && h->size == size && h->seq > seq && (found == NULL || h->seq < found->seq)) {
+        found = h;
+      }
+    }
+  }
+
+  if (found == NULL) {
+    return 0;
+  }
+  memcpy(data, found + 1, size);
+
+  return found->seq;
+}
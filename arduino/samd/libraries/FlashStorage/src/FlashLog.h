@@ -0,0 +1,112 @@
+/*
+  Append-only, wear-levelled record log in flash memory.
+
+  Copyright (c) 2015-2016 Arduino LLC.  All right reserved.
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+  See the GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include "FlashStorage.h"
+
+// The log is split into blocks which are erased as a whole (SAMD21: 4 rows,
+// SAMD51: one 8kB erase block). Records are page aligned and never cross a
+// block boundary, so a record can be at most one block minus its header.
+#if defined(__SAMD51__)
+  #define FLASHLOG_PAGE_SIZE  512
+  #define FLASHLOG_BLOCK_SIZE 8192
+#else
+  #define FLASHLOG_PAGE_SIZE  64
+  #define FLASHLOG_BLOCK_SIZE 1024
+#endif
+
+// Number of record types whose latest record survives garbage collection
+#define FLASHLOG_TYPES 8
+
+// Reserve a log of at least 3 blocks (one of them is always kept erased)
+#define FlashLog(name, size) \
+  __attribute__((__aligned__(FLASHLOG_BLOCK_SIZE))) \
+  static const uint8_t PPCAT(_data,name)[((size)+FLASHLOG_BLOCK_SIZE-1)/FLASHLOG_BLOCK_SIZE*FLASHLOG_BLOCK_SIZE] = { }; \
+  FlashLogClass name(PPCAT(_data,name), ((size)+FLASHLOG_BLOCK_SIZE-1)/FLASHLOG_BLOCK_SIZE*FLASHLOG_BLOCK_SIZE);
+
+typedef struct {
+  uint16_t magic;
+  uint8_t  type;
+  uint8_t  flags;
+  uint16_t size;
+  uint16_t crc;
+  uint32_t seq;
+} FlashLogHeader;
+
+class FlashLogClass {
+public:
+  FlashLogClass(const void *flash_addr, uint32_t size);
+
+  /**
+   * Scan the log, find the write position and finish an interrupted
+   * garbage collection. A log without any valid record is formatted.
+   */
+  void begin();
+
+  /**
+   * Append a record. Once the current block is full the log moves on to the
+   * next (erased) block and frees the oldest one: the latest record of every
+   * type that still lives there is copied forward, then the block is erased.
+   * A block is only erased once all of these records have been copied.
+   * @param type record type (0...FLASHLOG_TYPES-1)
+   * @return true on success, false if the record is too big or no block
+   *         could be freed
+   */
+  bool write(uint8_t type, const void *data, uint16_t size);
+
+  /**
+   * Read the latest record of a type
+   * @return true, if a record with matching type and size was found
+   */
+  bool read(uint8_t type, void *data, uint16_t size);
+
+  /**
+   * Compare data with the latest record of a type (in place, without a copy)
+   * @return true, if the latest record has the same size and content
+   */
+  bool equals(uint8_t type, const void *data, uint16_t size);
+
+  /**
+   * Read the oldest record of a type that is newer than seq
+   * Start with seq = 0 and pass the returned value to iterate oldest to newest.
+   * @return sequence number of the record, 0 if there is none
+   */
+  uint32_t readNext(uint8_t type, uint32_t seq, void *data, uint16_t size);
+
+  uint32_t writes() { return _writes; }
+  uint32_t erases() { return _erases; }
+
+private:
+  const FlashLogHeader *record(uint32_t block, uint32_t offset);
+  bool valid(const FlashLogHeader *h, uint32_t room);
+  bool erased(uint32_t block, uint32_t offset);
+  const FlashLogHeader *find(uint32_t block, uint32_t *offset);
+  uint32_t next(uint32_t block) { return (block + 1) % blocks; }
+  void program(uint8_t type, const void *data, uint16_t size);
+  bool collect(uint32_t block);
+
+  FlashClass flash;
+  const uint8_t *base;
+  const uint32_t blocks;
+  uint32_t _head, _offset, _seq;
+  uint32_t _writes, _erases;
+  const FlashLogHeader *_latest[FLASHLOG_TYPES];
+};
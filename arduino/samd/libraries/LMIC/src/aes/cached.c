@@ -0,0 +1,288 @@
+/*******************************************************************************
+ * Copyright (c) 2014-2015 IBM Corporation.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *    IBM Zurich Research Lab - initial API, implementation and documentation
+ *******************************************************************************/
+
+/*
+ * AES-128 with cached key schedules. LMIC loads AESKEY before every
+ * os_aes() call, an uplink alternates between AppSKey (payload) and
+ * NwkSKey (MIC) and a join runs five operations with the DevKey. The
+ * round keys and the CMAC subkeys K1/K2 of the last AES_KEYS keys are kept,
+ * so a repeated key costs a 16 byte compare instead of the key expansion
+ * and the extra block encryption for the subkeys.
+ *
+ * The round function uses one 1 KB table (the first table of the original
+ * implementation) and rotates it for the other three columns.
+ */
+
+#include "../lmic/oslmic.h"
+
+#if defined(USE_CACHED_AES)
+
+#define AES_KEYS 2 // cached key schedules
+
+static CONST_TABLE(u4_t, AES_RCON)[10] = {
+    0x01000000, 0x02000000, 0x04000000, 0x08000000, 0x10000000,
+    0x20000000, 0x40000000, 0x80000000, 0x1B000000, 0x36000000
+};
+
+static CONST_TABLE(u1_t, AES_S)[256] = {
+  0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+  0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+  0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+  0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+  0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+  0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+  0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+  0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+  0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+  0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+  0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+  0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+  0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+  0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+  0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+  0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16,
+};
+
+static CONST_TABLE(u4_t, AES_T)[256] = {
+  0xC66363A5, 0xF87C7C84, 0xEE777799, 0xF67B7B8D, 0xFFF2F20D, 0xD66B6BBD, 0xDE6F6FB1, 0x91C5C554,
+  0x60303050, 0x02010103, 0xCE6767A9, 0x562B2B7D, 0xE7FEFE19, 0xB5D7D762, 0x4DABABE6, 0xEC76769A,
+  0x8FCACA45, 0x1F82829D, 0x89C9C940, 0xFA7D7D87, 0xEFFAFA15, 0xB25959EB, 0x8E4747C9, 0xFBF0F00B,
+  0x41ADADEC, 0xB3D4D467, 0x5FA2A2FD, 0x45AFAFEA, 0x239C9CBF, 0x53A4A4F7, 0xE4727296, 0x9BC0C05B,
+  0x75B7B7C2, 0xE1FDFD1C, 0x3D9393AE, 0x4C26266A, 0x6C36365A, 0x7E3F3F41, 0xF5F7F702, 0x83CCCC4F,
+  0x6834345C, 0x51A5A5F4, 0xD1E5E534, 0xF9F1F108, 0xE2717193, 0xABD8D873, 0x62313153, 0x2A15153F,
+  0x0804040C, 0x95C7C752, 0x46232365, 0x9DC3C35E, 0x30181828, 0x379696A1, 0x0A05050F, 0x2F9A9AB5,
+  0x0E070709, 0x24121236, 0x1B80809B, 0xDFE2E23D, 0xCDEBEB26, 0x4E272769, 0x7FB2B2CD, 0xEA75759F,
+  0x1209091B, 0x1D83839E, 0x582C2C74, 0x341A1A2E, 0x361B1B2D, 0xDC6E6EB2, 0xB45A5AEE, 0x5BA0A0FB,
+  0xA45252F6, 0x763B3B4D, 0xB7D6D661, 0x7DB3B3CE, 0x5229297B, 0xDDE3E33E, 0x5E2F2F71, 0x13848497,
+  0xA65353F5, 0xB9D1D168, 0x00000000, 0xC1EDED2C, 0x40202060, 0xE3FCFC1F, 0x79B1B1C8, 0xB65B5BED,
+  0xD46A6ABE, 0x8DCBCB46, 0x67BEBED9, 0x7239394B, 0x944A4ADE, 0x984C4CD4, 0xB05858E8, 0x85CFCF4A,
+  0xBBD0D06B, 0xC5EFEF2A, 0x4FAAAAE5, 0xEDFBFB16, 0x864343C5, 0x9A4D4DD7, 0x66333355, 0x11858594,
+  0x8A4545CF, 0xE9F9F910, 0x04020206, 0xFE7F7F81, 0xA05050F0, 0x783C3C44, 0x259F9FBA, 0x4BA8A8E3,
+  0xA25151F3, 0x5DA3A3FE, 0x804040C0, 0x058F8F8A, 0x3F9292AD, 0x219D9DBC, 0x70383848, 0xF1F5F504,
+  0x63BCBCDF, 0x77B6B6C1, 0xAFDADA75, 0x42212163, 0x20101030, 0xE5FFFF1A, 0xFDF3F30E, 0xBFD2D26D,
+  0x81CDCD4C, 0x180C0C14, 0x26131335, 0xC3ECEC2F, 0xBE5F5FE1, 0x359797A2, 0x884444CC, 0x2E171739,
+  0x93C4C457, 0x55A7A7F2, 0xFC7E7E82, 0x7A3D3D47, 0xC86464AC, 0xBA5D5DE7, 0x3219192B, 0xE6737395,
+  0xC06060A0, 0x19818198, 0x9E4F4FD1, 0xA3DCDC7F, 0x44222266, 0x542A2A7E, 0x3B9090AB, 0x0B888883,
+  0x8C4646CA, 0xC7EEEE29, 0x6BB8B8D3, 0x2814143C, 0xA7DEDE79, 0xBC5E5EE2, 0x160B0B1D, 0xADDBDB76,
+  0xDBE0E03B, 0x64323256, 0x743A3A4E, 0x140A0A1E, 0x924949DB, 0x0C06060A, 0x4824246C, 0xB85C5CE4,
+  0x9FC2C25D, 0xBDD3D36E, 0x43ACACEF, 0xC46262A6, 0x399191A8, 0x319595A4, 0xD3E4E437, 0xF279798B,
+  0xD5E7E732, 0x8BC8C843, 0x6E373759, 0xDA6D6DB7, 0x018D8D8C, 0xB1D5D564, 0x9C4E4ED2, 0x49A9A9E0,
+  0xD86C6CB4, 0xAC5656FA, 0xF3F4F407, 0xCFEAEA25, 0xCA6565AF, 0xF47A7A8E, 0x47AEAEE9, 0x10080818,
+  0x6FBABAD5, 0xF0787888, 0x4A25256F, 0x5C2E2E72, 0x381C1C24, 0x57A6A6F1, 0x73B4B4C7, 0x97C6C651,
+  0xCBE8E823, 0xA1DDDD7C, 0xE874749C, 0x3E1F1F21, 0x964B4BDD, 0x61BDBDDC, 0x0D8B8B86, 0x0F8A8A85,
+  0xE0707090, 0x7C3E3E42, 0x71B5B5C4, 0xCC6666AA, 0x904848D8, 0x06030305, 0xF7F6F601, 0x1C0E0E12,
+  0xC26161A3, 0x6A35355F, 0xAE5757F9, 0x69B9B9D0, 0x17868691, 0x99C1C158, 0x3A1D1D27, 0x279E9EB9,
+  0xD9E1E138, 0xEBF8F813, 0x2B9898B3, 0x22111133, 0xD26969BB, 0xA9D9D970, 0x078E8E89, 0x339494A7,
+  0x2D9B9BB6, 0x3C1E1E22, 0x15878792, 0xC9E9E920, 0x87CECE49, 0xAA5555FF, 0x50282878, 0xA5DFDF7A,
+  0x038C8C8F, 0x59A1A1F8, 0x09898980, 0x1A0D0D17, 0x65BFBFDA, 0xD7E6E631, 0x844242C6, 0xD06868B8,
+  0x824141C3, 0x299999B0, 0x5A2D2D77, 0x1E0F0F11, 0x7BB0B0CB, 0xA85454FC, 0x6DBBBBD6, 0x2C16163A,
+};
+
+#define u1(v)        ((u1_t)(v))
+#define ror(v,n)     (((v) >> (n)) | ((v) << (32-(n))))
+#define T0(v)        TABLE_GET_U4(AES_T, (v)>>24)
+#define T1(v)        ror(TABLE_GET_U4(AES_T, u1((v)>>16)),  8)
+#define T2(v)        ror(TABLE_GET_U4(AES_T, u1((v)>> 8)), 16)
+#define T3(v)        ror(TABLE_GET_U4(AES_T, u1(v)), 24)
+#define S0(v)        ((u4_t)TABLE_GET_U1(AES_S, (v)>>24)<<24)
+#define S1(v)        ((u4_t)TABLE_GET_U1(AES_S, u1((v)>>16))<<16)
+#define S2(v)        ((u4_t)TABLE_GET_U1(AES_S, u1((v)>> 8))<< 8)
+#define S3(v)         (u4_t)TABLE_GET_U1(AES_S, u1(v))
+
+typedef struct {
+    u1_t key[16];
+    u4_t rk[44];    // round keys, MSBF words
+    u4_t k1[4];     // CMAC subkeys
+    u4_t k2[4];
+} aeskey_t;
+
+// global area for passing parameters (aux, key)
+u4_t AESAUX[16/sizeof(u4_t)];
+u4_t AESKEY[16/sizeof(u4_t)];
+
+static aeskey_t aeskeys[AES_KEYS];
+static u1_t aeskeysUsed; // number of valid entries
+static u1_t aeskeyNext;  // entry to replace next
+
+static void aes_load (u4_t* b, xref2cu1_t buf) {
+    b[0] = os_rmsbf4(buf);
+    b[1] = os_rmsbf4(buf+4);
+    b[2] = os_rmsbf4(buf+8);
+    b[3] = os_rmsbf4(buf+12);
+}
+
+static void aes_store (xref2u1_t buf, const u4_t* b) {
+    os_wmsbf4(buf,    b[0]);
+    os_wmsbf4(buf+4,  b[1]);
+    os_wmsbf4(buf+8,  b[2]);
+    os_wmsbf4(buf+12, b[3]);
+}
+
+// encrypt one block in place
+static void aes_block (const u4_t* rk, u4_t* b) {
+    u4_t a0, a1, a2, a3, t0, t1, t2, t3;
+    int r;
+
+    a0 = b[0] ^ rk[0];
+    a1 = b[1] ^ rk[1];
+    a2 = b[2] ^ rk[2];
+    a3 = b[3] ^ rk[3];
+    for( r=1; r<10; r++ ) {
+        rk += 4;
+        t0 = rk[0] ^ T0(a0) ^ T1(a1) ^ T2(a2) ^ T3(a3);
+        t1 = rk[1] ^ T0(a1) ^ T1(a2) ^ T2(a3) ^ T3(a0);
+        t2 = rk[2] ^ T0(a2) ^ T1(a3) ^ T2(a0) ^ T3(a1);
+        t3 = rk[3] ^ T0(a3) ^ T1(a0) ^ T2(a1) ^ T3(a2);
+        a0 = t0;
+        a1 = t1;
+        a2 = t2;
+        a3 = t3;
+    }
+    rk += 4;
+    b[0] = rk[0] ^ S0(a0) ^ S1(a1) ^ S2(a2) ^ S3(a3);
+    b[1] = rk[1] ^ S0(a1) ^ S1(a2) ^ S2(a3) ^ S3(a0);
+    b[2] = rk[2] ^ S0(a2) ^ S1(a3) ^ S2(a0) ^ S3(a1);
+    b[3] = rk[3] ^ S0(a3) ^ S1(a0) ^ S2(a1) ^ S3(a2);
+}
+
+// CMAC subkey doubling in GF(2^128)
+static void aes_dbl (u4_t* d, const u4_t* s) {
+    u4_t msb = s[0] >> 31;
+    d[0] = (s[0] << 1) | (s[1] >> 31);
+    d[1] = (s[1] << 1) | (s[2] >> 31);
+    d[2] = (s[2] << 1) | (s[3] >> 31);
+    d[3] = (s[3] << 1) ^ (msb ? 0x87 : 0);
+}
+
+// return the cached key schedule for AESKEY, expand it on a miss
+static const aeskey_t* aes_key () {
+    aeskey_t* k;
+    u4_t b;
+    int i;
+
+    for( i=0; i<aeskeysUsed; i++ ) {
+        if( memcmp(aeskeys[i].key, AESkey, 16) == 0 ) {
+            aeskeyNext = (i+1) % AES_KEYS; // keep the entry used last
+            return &aeskeys[i];
+        }
+    }
+
+    k = &aeskeys[aeskeyNext];
+    aeskeyNext = (aeskeyNext+1) % AES_KEYS;
+    if( aeskeysUsed < AES_KEYS )
+        aeskeysUsed++;
+
+    os_copyMem(k->key, AESkey, 16);
+    aes_load(k->rk, AESkey);
+    b = k->rk[3];
+    for( i=4; i<44; i++ ) {
+        if( i%4==0 ) {
+            // b = SubWord(RotWord(b)) xor Rcon[i/4]
+            b = S0(b<<8) ^ S1(b<<8) ^ S2(b<<8) ^ S3(b>>24) ^ TABLE_GET_U4(AES_RCON, (i-4)/4);
+        }
+        k->rk[i] = b ^= k->rk[i-4];
+    }
+
+    k->k1[0] = k->k1[1] = k->k1[2] = k->k1[3] = 0;
+    aes_block(k->rk, k->k1);
+    aes_dbl(k->k1, k->k1);
+    aes_dbl(k->k2, k->k1);
+    return k;
+}
+
+// xor the CMAC subkey into the last block and encrypt it
+static u4_t aes_micfinal (const aeskey_t* k, u4_t* x, const u4_t* sub) {
+    x[0] ^= sub[0];
+    x[1] ^= sub[1];
+    x[2] ^= sub[2];
+    x[3] ^= sub[3];
+    aes_block(k->rk, x);
+    aes_store(AESaux, x);
+    return x[0];
+}
+
+// RFC4493 CMAC over AESAUX (unless AES_MICNOAUX) and buf
+static u4_t aes_mic (const aeskey_t* k, u1_t mode, xref2u1_t buf, u2_t len) {
+    u4_t x[4], b[4];
+    u1_t last[16];
+
+    if( mode & AES_MICNOAUX ) {
+        x[0] = x[1] = x[2] = x[3] = 0;
+    } else {
+        aes_load(x, AESaux);
+        if( len == 0 ) // AESAUX is the only block
+            return aes_micfinal(k, x, k->k1);
+        aes_block(k->rk, x);
+    }
+    while( len > 16 ) {
+        aes_load(b, buf);
+        x[0] ^= b[0];
+        x[1] ^= b[1];
+        x[2] ^= b[2];
+        x[3] ^= b[3];
+        aes_block(k->rk, x);
+        buf += 16;
+        len -= 16;
+    }
+    // last block, incomplete ones are padded with 0x80 and zeroes
+    os_clearMem(last, 16);
+    os_copyMem(last, buf, len);
+    if( len < 16 )
+        last[len] = 0x80;
+    aes_load(b, last);
+    x[0] ^= b[0];
+    x[1] ^= b[1];
+    x[2] ^= b[2];
+    x[3] ^= b[3];
+    return aes_micfinal(k, x, (len == 16) ? k->k1 : k->k2);
+}
+
+// AES-CTR with AESAUX as counter block, the last word (MSBF) is incremented
+// per block like in the original implementation
+static void aes_ctr (const aeskey_t* k, xref2u1_t buf, u2_t len) {
+    u4_t s[4];
+    u1_t ks[16];
+    u1_t i;
+
+    while( len > 0 ) {
+        aes_load(s, AESaux);
+        aes_block(k->rk, s);
+        aes_store(ks, s);
+        for( i=0; i<16 && len>0; i++, len-- )
+            *buf++ ^= ks[i];
+        os_wmsbf4(AESaux+12, os_rmsbf4(AESaux+12)+1);
+    }
+}
+
+u4_t os_aes (u1_t mode, xref2u1_t buf, u2_t len) {
+    const aeskey_t* k = aes_key();
+    u4_t b[4];
+
+    switch( mode & ~AES_MICNOAUX ) {
+        case AES_MIC:
+            return aes_mic(k, mode, buf, len);
+
+        case AES_ENC:
+            for( ; len >= 16; buf += 16, len -= 16 ) {
+                aes_load(b, buf);
+                aes_block(k->rk, b);
+                aes_store(buf, b);
+            }
+            break;
+
+        case AES_CTR:
+            aes_ctr(k, buf, len);
+            break;
+    }
+    return 0;
+}
+
+#endif // defined(USE_CACHED_AES)
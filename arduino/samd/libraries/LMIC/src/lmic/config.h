@@ -78,6 +78,13 @@
 // own LoRaWAN library. It also uses lookup tables, but smaller
 // byte-oriented ones, making it use a lot less flash space (but it is
 // also about twice as slow as the original).
-#define USE_IDEETRON_AES
+// #define USE_IDEETRON_AES
+//
+// This selects a table-based implementation that keeps the expanded
+// key schedules and CMAC subkeys of the last two keys (AppSKey and
+// NwkSKey for an uplink), so they are not derived again for every
+// frame. It needs about 1.3 KB of flash for its tables and 450 bytes of
+// RAM for the cached keys.
+#define USE_CACHED_AES
 
 #endif // _lmic_config_h_
@@ -47,6 +47,7 @@ static void clearRxBuffer(TwoWire& i2cBus) {
 uint16_t SensirionI2CCommunication::sendFrame(uint8_t address,
                                               SensirionI2CTxFrame& frame,
                                               TwoWire& i2cBus) {
+    I2CBusLock lock(&i2cBus);
     i2cBus.beginTransmission(address);
     size_t writtenBytes = i2cBus.write(frame._buffer, frame._index);
     uint8_t i2c_error = i2cBus.endTransmission();
@@ -73,6 +74,7 @@ uint16_t SensirionI2CCommunication::receiveFrame(uint8_t address,
                                                  size_t numBytes,
                                                  SensirionI2CRxFrame& frame,
                                                  TwoWire& i2cBus) {
+    I2CBusLock lock(&i2cBus);
     size_t readAmount;
     size_t i = 0;
 
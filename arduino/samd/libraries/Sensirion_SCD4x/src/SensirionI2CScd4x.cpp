@@ -554,3 +554,179 @@ uint16_t SensirionI2CScd4x::wakeUp() {
     delay(20);
     return NoError;
 }
+
+uint16_t SensirionI2CScd4x::beginCommand(uint16_t command,
+                                         uint16_t executionTime) {
+    uint16_t error;
+    uint8_t buffer[2];
+    SensirionI2CTxFrame txFrame(buffer, 2);
+
+    error = txFrame.addCommand(command);
+    if (error) {
+        return error;
+    }
+
+    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
+                                                 *_i2cBus);
+    if (error) {
+        return error;
+    }
+    _commandPending = true;
+    _commandTime = executionTime;
+    _commandStart = micros();
+    return NoError;
+}
+
+uint16_t SensirionI2CScd4x::beginCommand(uint16_t command, uint16_t argument,
+                                         uint16_t executionTime) {
+    uint16_t error;
+    uint8_t buffer[5];
+    SensirionI2CTxFrame txFrame(buffer, 5);
+
+    error = txFrame.addCommand(command);
+    error |= txFrame.addUInt16(argument);
+    if (error) {
+        return error;
+    }
+
+    error = SensirionI2CCommunication::sendFrame(SCD4X_I2C_ADDRESS, txFrame,
+                                                 *_i2cBus);
+    if (error) {
+        return error;
+    }
+    _commandPending = true;
+    _commandTime = executionTime;
+    _commandStart = micros();
+    return NoError;
+}
+
+uint16_t SensirionI2CScd4x::readResult(uint16_t* words, size_t numWords) {
+    uint16_t error;
+    uint8_t buffer[9];
+    SensirionI2CRxFrame rxFrame(buffer, 9);
+
+    if (!pollCommand()) {
+        return ReadError | NoDataError;
+    }
+
+    error = SensirionI2CCommunication::receiveFrame(
+        SCD4X_I2C_ADDRESS, numWords * 3, rxFrame, *_i2cBus);
+    if (error) {
+        return error;
+    }
+
+    for (size_t i = 0; i < numWords; i++) {
+        error |= rxFrame.getUInt16(words[i]);
+    }
+    return error;
+}
+
+bool SensirionI2CScd4x::pollCommand() {
+    if (_commandPending &&
+        (micros() - _commandStart) >= _commandTime * 1000UL) {
+        _commandPending = false;
+    }
+    return !_commandPending;
+}
+
+uint16_t SensirionI2CScd4x::beginReadMeasurement() {
+    return beginCommand(0xEC05, 1);
+}
+
+uint16_t SensirionI2CScd4x::readMeasurementResult(uint16_t& co2,
+                                                  float& temperature,
+                                                  float& humidity) {
+    uint16_t error;
+    uint16_t words[3];
+
+    error = readResult(words, 3);
+    if (error) {
+        return error;
+    }
+
+    co2 = words[0];
+    temperature = static_cast<float>(words[1] * 175.0 / 65536.0 - 45.0);
+    humidity = static_cast<float>(words[2] * 100.0 / 65536.0);
+    return NoError;
+}
+
+uint16_t SensirionI2CScd4x::beginStopPeriodicMeasurement() {
+    return beginCommand(0x3F86, 500);
+}
+
+uint16_t SensirionI2CScd4x::beginSetTemperatureOffset(float tOffset) {
+    uint16_t tOffsetTicks =
+        static_cast<uint16_t>(tOffset * 65536.0 / 175.0 + 0.5f);
+    return beginCommand(0x241D, tOffsetTicks, 1);
+}
+
+uint16_t SensirionI2CScd4x::beginSetSensorAltitude(uint16_t sensorAltitude) {
+    return beginCommand(0x2427, sensorAltitude, 1);
+}
+
+uint16_t SensirionI2CScd4x::beginSetAmbientPressure(uint16_t ambientPressure) {
+    return beginCommand(0xE000, ambientPressure, 1);
+}
+
+uint16_t SensirionI2CScd4x::beginGetTemperatureOffset() {
+    return beginCommand(0x2318, 1);
+}
+
+uint16_t SensirionI2CScd4x::readTemperatureOffsetResult(float& tOffset) {
+    uint16_t error;
+    uint16_t tOffsetTicks;
+
+    error = readResult(&tOffsetTicks, 1);
+    if (error) {
+        return error;
+    }
+
+    tOffset = static_cast<float>(tOffsetTicks * 175.0 / 65536.0);
+    return NoError;
+}
+
+uint16_t SensirionI2CScd4x::beginGetSensorAltitude() {
+    return beginCommand(0x2322, 1);
+}
+
+uint16_t SensirionI2CScd4x::readSensorAltitudeResult(uint16_t& sensorAltitude) {
+    return readResult(&sensorAltitude, 1);
+}
+
+uint16_t SensirionI2CScd4x::beginPerformForcedRecalibration(
+    uint16_t targetCo2Concentration) {
+    return beginCommand(0x362F, targetCo2Concentration, 400);
+}
+
+uint16_t
+SensirionI2CScd4x::readForcedRecalibrationResult(uint16_t& frcCorrection) {
+    return readResult(&frcCorrection, 1);
+}
+
+uint16_t SensirionI2CScd4x::beginPersistSettings() {
+    return beginCommand(0x3615, 800);
+}
+
+uint16_t SensirionI2CScd4x::beginPerformSelfTest() {
+    return beginCommand(0x3639, 10000);
+}
+
+uint16_t SensirionI2CScd4x::readSelfTestResult(uint16_t& sensorStatus) {
+    return readResult(&sensorStatus, 1);
+}
+
+uint16_t SensirionI2CScd4x::beginPerformFactoryReset() {
+    return beginCommand(0x3632, 800);
+}
+
+uint16_t SensirionI2CScd4x::beginReinit() {
+    return beginCommand(0x3646, 20);
+}
+
+uint16_t SensirionI2CScd4x::beginMeasureSingleShot() {
+    return beginCommand(0x219D, 5000);
+}
+
+uint16_t SensirionI2CScd4x::beginMeasureSingleShotRhtOnly() {
+    return beginCommand(0x2196, 50);
+}
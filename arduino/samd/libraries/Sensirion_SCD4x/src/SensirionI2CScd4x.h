@@ -395,8 +395,214 @@ class SensirionI2CScd4x {
      */
     uint16_t wakeUp(void);
 
+    /**
+     * Split-phase commands
+     *
+     * The begin*() functions send a command and return immediately instead of
+     * blocking for the execution time given in the datasheet. Completion is
+     * reported by pollCommand(). Commands with a response are read out with
+     * the matching read*Result() function once pollCommand() returned true.
+     * Only one split-phase command can be pending at a time.
+     */
+
+    /**
+     * beginReadMeasurement() - Split-phase version of readMeasurement(). Read
+     * the values with readMeasurementResult() after pollCommand() returned
+     * true.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginReadMeasurement(void);
+
+    /**
+     * readMeasurementResult() - Read the measurement requested with
+     * beginReadMeasurement().
+     *
+     * @param co2 CO₂ concentration in ppm
+     *
+     * @param temperature Temperature in °C
+     *
+     * @param humidity Relative humidity in %RH
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t readMeasurementResult(uint16_t& co2, float& temperature,
+                                   float& humidity);
+
+    /**
+     * beginStopPeriodicMeasurement() - Split-phase version of
+     * stopPeriodicMeasurement(), execution time 500 ms.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginStopPeriodicMeasurement(void);
+
+    /**
+     * beginSetTemperatureOffset() - Split-phase version of
+     * setTemperatureOffset(), execution time 1 ms.
+     *
+     * @param tOffset Temperature offset in °C
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginSetTemperatureOffset(float tOffset);
+
+    /**
+     * beginSetSensorAltitude() - Split-phase version of setSensorAltitude(),
+     * execution time 1 ms.
+     *
+     * @param sensorAltitude Sensor altitude in meters.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginSetSensorAltitude(uint16_t sensorAltitude);
+
+    /**
+     * beginSetAmbientPressure() - Split-phase version of setAmbientPressure(),
+     * execution time 1 ms.
+     *
+     * @param ambientPressure Ambient pressure in hPa.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginSetAmbientPressure(uint16_t ambientPressure);
+
+    /**
+     * beginGetTemperatureOffset() - Split-phase version of
+     * getTemperatureOffset(), execution time 1 ms. Read the offset with
+     * readTemperatureOffsetResult() after pollCommand() returned true.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginGetTemperatureOffset(void);
+
+    /**
+     * readTemperatureOffsetResult() - Read the result of
+     * beginGetTemperatureOffset().
+     *
+     * @param tOffset Temperature offset in °C
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t readTemperatureOffsetResult(float& tOffset);
+
+    /**
+     * beginGetSensorAltitude() - Split-phase version of getSensorAltitude(),
+     * execution time 1 ms. Read the altitude with readSensorAltitudeResult()
+     * after pollCommand() returned true.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginGetSensorAltitude(void);
+
+    /**
+     * readSensorAltitudeResult() - Read the result of beginGetSensorAltitude().
+     *
+     * @param sensorAltitude Sensor altitude in meters.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t readSensorAltitudeResult(uint16_t& sensorAltitude);
+
+    /**
+     * beginPerformForcedRecalibration() - Split-phase version of
+     * performForcedRecalibration(), execution time 400 ms. Read the correction
+     * with readForcedRecalibrationResult() after pollCommand() returned true.
+     *
+     * @param targetCo2Concentration Target CO₂ concentration in ppm.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginPerformForcedRecalibration(uint16_t targetCo2Concentration);
+
+    /**
+     * readForcedRecalibrationResult() - Read the result of
+     * beginPerformForcedRecalibration().
+     *
+     * @param frcCorrection FRC correction value in CO₂ ppm or 0xFFFF if the
+     * command failed. Convert value to CO₂ ppm with: value - 0x8000
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t readForcedRecalibrationResult(uint16_t& frcCorrection);
+
+    /**
+     * beginPersistSettings() - Split-phase version of persistSettings(),
+     * execution time 800 ms.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginPersistSettings(void);
+
+    /**
+     * beginPerformSelfTest() - Split-phase version of performSelfTest(),
+     * execution time 10 s. Read the status with readSelfTestResult() after
+     * pollCommand() returned true.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginPerformSelfTest(void);
+
+    /**
+     * readSelfTestResult() - Read the result of beginPerformSelfTest().
+     *
+     * @param sensorStatus 0 means no malfunction detected
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t readSelfTestResult(uint16_t& sensorStatus);
+
+    /**
+     * beginPerformFactoryReset() - Split-phase version of
+     * performFactoryReset(), execution time 800 ms.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginPerformFactoryReset(void);
+
+    /**
+     * beginReinit() - Split-phase version of reinit(), execution time 20 ms.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginReinit(void);
+
+    /**
+     * beginMeasureSingleShot() - Split-phase version of measureSingleShot(),
+     * execution time 5 s. Read the values with readMeasurement() after
+     * pollCommand() returned true.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginMeasureSingleShot(void);
+
+    /**
+     * beginMeasureSingleShotRhtOnly() - Split-phase version of
+     * measureSingleShotRhtOnly(), execution time 50 ms.
+     *
+     * @return 0 on success, an error code otherwise
+     */
+    uint16_t beginMeasureSingleShotRhtOnly(void);
+
+    /**
+     * pollCommand() - Check whether the command started with a begin*()
+     * function has completed, i.e. its execution time has elapsed.
+     *
+     * @return true if no command is pending, false otherwise
+     */
+    bool pollCommand(void);
+
   private:
+    uint16_t beginCommand(uint16_t command, uint16_t executionTime);
+    uint16_t beginCommand(uint16_t command, uint16_t argument,
+                          uint16_t executionTime);
+    uint16_t readResult(uint16_t* words, size_t numWords);
+
     TwoWire* _i2cBus = nullptr;
+    bool _commandPending = false;
+    uint16_t _commandTime = 0;
+    uint32_t _commandStart = 0;  // micros(), a millis() tick could end
+                                 // a 1 ms command at once
 };
 
 #endif /* SENSIRIONI2CSCD4X_H */
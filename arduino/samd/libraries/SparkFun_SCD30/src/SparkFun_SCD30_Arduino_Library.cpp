@@ -272,6 +272,8 @@ bool SCD30::dataAvailable()
 //Returns true if success
 bool SCD30::readMeasurement()
 {
+  I2CBusLock lock(_i2cPort); //Hold the shared bus (I2CQueue) until the data is read
+
   //Verify we have data from the sensor
   if (dataAvailable() == false)
     return (false);
@@ -377,6 +379,7 @@ bool SCD30::readMeasurement()
 //Returns true if the CRC is valid.
 bool SCD30::getSettingValue(uint16_t registerAddress, uint16_t *val)
 {
+  I2CBusLock lock(_i2cPort);
   _i2cPort->beginTransmission(SCD30_ADDRESS);
   _i2cPort->write(registerAddress >> 8);   //MSB
   _i2cPort->write(registerAddress & 0xFF); //LSB
@@ -410,6 +413,7 @@ bool SCD30::getSettingValue(uint16_t registerAddress, uint16_t *val)
 //Gets two bytes from SCD30
 uint16_t SCD30::readRegister(uint16_t registerAddress)
 {
+  I2CBusLock lock(_i2cPort);
   _i2cPort->beginTransmission(SCD30_ADDRESS);
   _i2cPort->write(registerAddress >> 8);   //MSB
   _i2cPort->write(registerAddress & 0xFF); //LSB
@@ -436,6 +440,7 @@ bool SCD30::sendCommand(uint16_t command, uint16_t arguments)
   data[1] = arguments & 0xFF;
   uint8_t crc = computeCRC8(data, 2); //Calc CRC on the arguments only, not the command
 
+  I2CBusLock lock(_i2cPort);
   _i2cPort->beginTransmission(SCD30_ADDRESS);
   _i2cPort->write(command >> 8);     //MSB
   _i2cPort->write(command & 0xFF);   //LSB
@@ -451,6 +456,7 @@ bool SCD30::sendCommand(uint16_t command, uint16_t arguments)
 //Sends just a command, no arguments, no CRC
 bool SCD30::sendCommand(uint16_t command)
 {
+  I2CBusLock lock(_i2cPort);
   _i2cPort->beginTransmission(SCD30_ADDRESS);
   _i2cPort->write(command >> 8);   //MSB
   _i2cPort->write(command & 0xFF); //LSB
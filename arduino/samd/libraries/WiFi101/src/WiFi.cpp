@@ -388,7 +388,8 @@ uint8_t WiFiClass::begin()
 
 	memset(_ssid, 0, M2M_MAX_SSID_LEN);
 
-	if (!(_status & WL_CONNECTED)) {
+	if (!(_status & WL_CONNECTED) && (_timeout != 0 || (_status & WL_DISCONNECTED))) {
+		// timeout 0: still connecting, the DHCP callback needs WL_STA_MODE
 		_mode = WL_RESET_MODE;
 	} else {
 		m2m_wifi_get_connection_info();
@@ -447,7 +448,8 @@ uint8_t WiFiClass::startConnect(const char *ssid, uint8_t u8SecType, const void
 			break;
 		}
 	}
-	if (!(_status & WL_CONNECTED)) {
+	if (!(_status & WL_CONNECTED) && (_timeout != 0 || (_status & WL_DISCONNECTED))) {
+		// timeout 0: still connecting, the DHCP callback needs WL_STA_MODE
 		_mode = WL_RESET_MODE;
 	}
 
@@ -1050,6 +1052,32 @@ int WiFiClass::hostByName(const char* aHostname, IPAddress& aResult)
 	}
 }
 
+int WiFiClass::beginHostByName(const char* aHostname)
+{
+	IPAddress ip;
+
+	_resolve = 0;
+	if (ip.fromString(aHostname)) {
+		_resolve = ip;
+		return 1;
+	}
+
+	return gethostbyname((uint8 *)aHostname) >= 0;
+}
+
+int WiFiClass::hostByNameResult(IPAddress& aResult)
+{
+	m2m_wifi_handle_events(NULL);
+
+	if (_resolve == 0) {
+		return 0;
+	}
+
+	aResult = _resolve;
+	_resolve = 0;
+	return 1;
+}
+
 void WiFiClass::refresh(void)
 {
 	// Update state machine:
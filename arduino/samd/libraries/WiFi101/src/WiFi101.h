@@ -149,6 +149,10 @@ public:
 
 	int hostByName(const char* hostname, IPAddress& result);
 	int hostByName(const String &hostname, IPAddress& result) { return hostByName(hostname.c_str(), result); }
+	// split-phase hostByName(): poll hostByNameResult() until it returns 1,
+	// it does not time out (shares the result with ping(), RSSI() and getTime())
+	int beginHostByName(const char* hostname);
+	int hostByNameResult(IPAddress& result);
 
 	int ping(const char* hostname, uint8_t ttl = 128);
 	int ping(const String &hostname, uint8_t ttl = 128);
@@ -165,7 +169,7 @@ public:
 	void handleEvent(uint8_t u8MsgType, void *pvMsg);
 	void handleResolve(uint8_t * hostName, uint32_t hostIp);
 	void handlePingResponse(uint32 u32IPAddr, uint32 u32RTT, uint8 u8ErrorCode);
-	void setTimeout(unsigned long timeout);
+	void setTimeout(unsigned long timeout); // begin() waits max. timeout ms, 0: returns at once, poll status()
 
 private:
 	int _init;
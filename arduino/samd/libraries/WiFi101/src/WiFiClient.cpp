@@ -94,6 +94,48 @@ int WiFiClient::connect(IPAddress ip, uint16_t port, uint8_t opt, const uint8_t
 	return 1;
 }
 
+int WiFiClient::beginConnect(IPAddress ip, uint16_t port)
+{
+	struct sockaddr_in addr;
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = _htons(port);
+	addr.sin_addr.s_addr = ip;
+
+	if (connected()) {
+		stop();
+	}
+
+	if ((_socket = WiFiSocket.create(AF_INET, SOCK_STREAM, 0)) < 0) {
+		return 0;
+	}
+
+	if (!WiFiSocket.beginConnect(_socket, (struct sockaddr *)&addr, sizeof(struct sockaddr_in))) {
+		WiFiSocket.close(_socket);
+		_socket = -1;
+		return 0;
+	}
+
+	return 1;
+}
+
+int WiFiClient::connectResult()
+{
+	int result;
+
+	if (_socket < 0) {
+		return -1;
+	}
+
+	result = WiFiSocket.connectResult(_socket);
+	if (result < 0) {
+		WiFiSocket.close(_socket);
+		_socket = -1;
+	}
+
+	return result;
+}
+
 size_t WiFiClient::write(uint8_t b)
 {
 	return write(&b, 1);
@@ -40,6 +40,11 @@ public:
 	int connectSSL(const char* host, uint16_t port);
 	virtual int connect(IPAddress ip, uint16_t port);
 	virtual int connect(const char* host, uint16_t port);
+	// split-phase connect: returns 1 if the SYN is on its way, then poll
+	// connectResult() (1 = connected, 0 = pending, -1 = refused, socket closed),
+	// call stop() to give up
+	int beginConnect(IPAddress ip, uint16_t port);
+	int connectResult();
 	virtual size_t write(uint8_t);
 	virtual size_t write(const uint8_t *buf, size_t size);
 	virtual int available();
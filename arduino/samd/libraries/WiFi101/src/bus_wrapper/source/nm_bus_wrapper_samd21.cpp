@@ -54,6 +54,13 @@
   #define WINC1501_SPI SPI
 #endif
 
+/*
+ * Variants may define the SERCOM registers behind WINC1501_SPI, e.g.
+ *   #define WINC1501_SPI_SERCOM SERCOM1
+ * spi_rw() then moves whole buffers with a register loop instead of
+ * calling WINC1501_SPI.transfer() for every byte.
+ */
+
 extern "C" {
 
 #include "bsp/include/nm_bsp.h"
@@ -72,6 +79,31 @@ tstrNmBusCapabilities egstrNmBusCapabilities =
 
 static const SPISettings wifi_SPISettings(12000000L, MSBFIRST, SPI_MODE0);
 
+#if defined(WINC1501_SPI_SERCOM)
+static void spi_rw_block(uint8* pu8Mosi, uint8* pu8Miso, uint16 u16Sz, uint8 u8SkipMosi, uint8 u8SkipMiso)
+{
+	SercomSpi *pstrSpi = &WINC1501_SPI_SERCOM->SPI;
+	uint16 u16Tx = u16Sz, u16Rx = u16Sz;
+
+	/* Keep the double buffered DATA register filled, but never have more
+	   than 2 bytes in flight so the receive buffer can't overflow. */
+	while (u16Rx) {
+		if (u16Tx && ((u16Rx - u16Tx) < 2) && pstrSpi->INTFLAG.bit.DRE) {
+			pstrSpi->DATA.reg = *pu8Mosi;
+			u16Tx--;
+			if (!u8SkipMosi)
+				pu8Mosi++;
+		}
+		if (pstrSpi->INTFLAG.bit.RXC) {
+			*pu8Miso = pstrSpi->DATA.reg;
+			u16Rx--;
+			if (!u8SkipMiso)
+				pu8Miso++;
+		}
+	}
+}
+#endif
+
 static sint8 spi_rw(uint8* pu8Mosi, uint8* pu8Miso, uint16 u16Sz)
 {
 	uint8 u8Dummy = 0;
@@ -92,6 +124,9 @@ static sint8 spi_rw(uint8* pu8Mosi, uint8* pu8Miso, uint16 u16Sz)
 	WINC1501_SPI.beginTransaction(wifi_SPISettings);
 	digitalWrite(gi8Winc1501CsPin, LOW);
 
+#if defined(WINC1501_SPI_SERCOM)
+	spi_rw_block(pu8Mosi, pu8Miso, u16Sz, u8SkipMosi, u8SkipMiso);
+#else
 	while (u16Sz) {
 		*pu8Miso = WINC1501_SPI.transfer(*pu8Mosi);
 			
@@ -101,6 +136,7 @@ static sint8 spi_rw(uint8* pu8Mosi, uint8* pu8Miso, uint16 u16Sz)
 		if (!u8SkipMosi)
 			pu8Mosi++;
 	}
+#endif
 
 	digitalWrite(gi8Winc1501CsPin, HIGH);
 	WINC1501_SPI.endTransaction();
@@ -313,6 +313,7 @@ sint8 hif_send(uint8 u8Gid,uint8 u8Opcode,uint8 *pu8CtrlBuf,uint16 u16CtrlBufSiz
 	sint8		ret = M2M_ERR_SEND;
 	volatile tstrHifHdr	strHif;
 
+	hif_trace(HIF_TRACE_SEND, 1);
 	strHif.u8Opcode		= u8Opcode&(~NBIT7);
 	strHif.u8Gid		= u8Gid;
 	strHif.u16Length	= M2M_HIF_HDR_OFFSET;
@@ -424,12 +425,14 @@ sint8 hif_send(uint8 u8Gid,uint8 u8Opcode,uint8 *pu8CtrlBuf,uint16 u16CtrlBufSiz
 	}
 	/*actual sleep ret = M2M_SUCCESS*/
  	ret = hif_chip_sleep();
+	hif_trace(HIF_TRACE_SEND, 0);
 	return ret;
 ERR1:
 	/*reset the count but no actual sleep as it already bus error*/
 	hif_chip_sleep_sc();
 ERR2:
 	/*logical error*/
+	hif_trace(HIF_TRACE_SEND, 0);
 	return ret;
 }
 
@@ -636,6 +639,11 @@ sint8 hif_handle_isr(void)
 	}
 #endif
 
+	if (!gstrHifCxt.u8Interrupt) {
+		return ret;
+	}
+
+	hif_trace(HIF_TRACE_ISR, 1);
 	while (gstrHifCxt.u8Interrupt) {
 		/*must be at that place because of the race of interrupt increment and that decrement*/
 		/*when the interrupt enabled*/
@@ -645,6 +653,7 @@ sint8 hif_handle_isr(void)
 			ret = hif_isr();
 #ifdef ARDUINO
 			if (hif_receive_blocked) {
+				hif_trace(HIF_TRACE_ISR, 0);
 				return ret;
 			}
 #endif
@@ -657,9 +666,22 @@ sint8 hif_handle_isr(void)
 			}
 		}
 	}
+	hif_trace(HIF_TRACE_ISR, 0);
 
 	return ret;
 }
+
+/**
+*	@fn		hif_trace(uint8 u8Id, uint8 u8Begin)
+*	@brief	Called when the host interface starts (u8Begin = 1) and finishes (u8Begin = 0)
+*			a bus transaction. Empty by default, the application may override it to
+*			measure the time spent on the SPI bus.
+*/
+void __attribute__((weak)) hif_trace(uint8 u8Id, uint8 u8Begin)
+{
+	(void)u8Id;
+	(void)u8Begin;
+}
 /*
 *	@fn		hif_receive
 *	@brief	Host interface interrupt serviece routine
@@ -243,6 +243,17 @@ NMI_API sint8 hif_Resp_handler(uint8 *pu8Buffer, uint16 u16BufferSize);
 */
 NMI_API sint8 hif_handle_isr(void);
 
+/**
+*	@fn		hif_trace(uint8 u8Id, uint8 u8Begin)
+*	@brief
+			Trace hook, called at the start (u8Begin = 1) and end (u8Begin = 0) of
+			hif_handle_isr() (u8Id = HIF_TRACE_ISR, only if an interrupt is pending)
+			and hif_send() (u8Id = HIF_TRACE_SEND). Weak and empty, override to profile the bus.
+*/
+#define HIF_TRACE_ISR	0
+#define HIF_TRACE_SEND	1
+NMI_API void hif_trace(uint8 u8Id, uint8 u8Begin);
+
 #ifdef __cplusplus
 }
 #endif
@@ -133,27 +133,52 @@ sint8 WiFiSocketClass::setopt(SOCKET socket, uint8 u8Level, uint8 option_name, c
 }
 
 sint8 WiFiSocketClass::connect(SOCKET sock, struct sockaddr *pstrAddr, uint8 u8AddrLen)
+{
+	sint8 result;
+
+	if (!beginConnect(sock, pstrAddr, u8AddrLen)) {
+		return 0;
+	}
+
+	unsigned long start = millis();
+
+	while ((result = connectResult(sock)) == 0 && millis() - start < 20000);
+
+	if (result <= 0) {
+		_info[sock].state = SOCKET_STATE_IDLE;
+		return 0;
+	}
+
+	return 1;
+}
+
+sint8 WiFiSocketClass::beginConnect(SOCKET sock, struct sockaddr *pstrAddr, uint8 u8AddrLen)
 {
 	if (::connect(sock, pstrAddr, u8AddrLen) < 0) {
 		return 0;
 	}
 
 	_info[sock].state = SOCKET_STATE_CONNECTING;
+	_info[sock].recvMsg.strRemoteAddr.sin_port = ((struct sockaddr_in*)pstrAddr)->sin_port;
+	_info[sock].recvMsg.strRemoteAddr.sin_addr.s_addr = ((struct sockaddr_in*)pstrAddr)->sin_addr.s_addr;
 
-	unsigned long start = millis();
+	return 1;
+}
 
-	while (_info[sock].state == SOCKET_STATE_CONNECTING && millis() - start < 20000) {
-		m2m_wifi_handle_events(NULL);
+sint8 WiFiSocketClass::connectResult(SOCKET sock)
+{
+	m2m_wifi_handle_events(NULL);
+
+	if (_info[sock].state == SOCKET_STATE_CONNECTING) {
+		return 0;
 	}
 
 	if (_info[sock].state != SOCKET_STATE_CONNECTED) {
 		_info[sock].state = SOCKET_STATE_IDLE;
-		return 0;
+		return -1;
 	}
 
 	_info[sock].recvMsg.s16BufferSize = 0;
-	_info[sock].recvMsg.strRemoteAddr.sin_port = ((struct sockaddr_in*)pstrAddr)->sin_port;
-	_info[sock].recvMsg.strRemoteAddr.sin_addr.s_addr = ((struct sockaddr_in*)pstrAddr)->sin_addr.s_addr;
 	recv(sock, NULL, 0, 0);
 
 	return 1;
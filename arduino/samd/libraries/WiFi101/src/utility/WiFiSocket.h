@@ -38,6 +38,10 @@ public:
   sint8 listen(SOCKET sock, uint8 backlog);
   sint8 setopt(SOCKET socket, uint8 u8Level, uint8 option_name, const void *option_value, uint16 u16OptionLen);
   sint8 connect(SOCKET sock, struct sockaddr *pstrAddr, uint8 u8AddrLen);
+  // split-phase connect: beginConnect() returns at once, poll connectResult()
+  // until it is not 0 (1 = connected, -1 = refused), it does not time out
+  sint8 beginConnect(SOCKET sock, struct sockaddr *pstrAddr, uint8 u8AddrLen);
+  sint8 connectResult(SOCKET sock);
   uint8 connected(SOCKET sock);
   uint8 listening(SOCKET sock);
   uint8 bound(SOCKET sock);
@@ -124,6 +124,33 @@ SERCOM sercom3(SERCOM3);
 SERCOM sercom4(SERCOM4);
 SERCOM sercom5(SERCOM5);
 
+// Wire/Wire1
+void SERCOM0_Wire_Handler(void) __attribute__((weak));
+void SERCOM2_Wire_Handler(void) __attribute__((weak));
+void (*sercom0_handler)(void) = NULL;
+void (*sercom2_handler)(void) = NULL;
+
+void __attribute__((weak)) i2c_bus_acquire(TwoWire *wire) { (void)wire; }
+void __attribute__((weak)) i2c_bus_release(TwoWire *wire) { (void)wire; }
+
+void SERCOM0_Handler()
+{
+  if (sercom0_handler) {
+    sercom0_handler();
+  } else if (SERCOM0_Wire_Handler) {
+    SERCOM0_Wire_Handler();
+  }
+}
+
+void SERCOM2_Handler()
+{
+  if (sercom2_handler) {
+    sercom2_handler();
+  } else if (SERCOM2_Wire_Handler) {
+    SERCOM2_Wire_Handler();
+  }
+}
+
 
 // Serial1
 Uart Serial1(&sercom5, PIN_SERIAL1_RX, PIN_SERIAL1_TX, PAD_SERIAL1_RX, PAD_SERIAL1_TX);
@@ -112,17 +112,21 @@ static const uint8_t SCK  = PIN_SPI_SCK;
 #define PIN_WIRE_SDA        (6u)
 #define PIN_WIRE_SCL        (7u)
 #define PERIPH_WIRE         sercom0 // sercom0 or sercom2
-#define WIRE_IT_HANDLER     SERCOM0_Handler
+#define WIRE_IT_HANDLER     SERCOM0_Wire_Handler // called by SERCOM0_Handler in variant.cpp
 static const uint8_t SDA = PIN_WIRE_SDA;
 static const uint8_t SCL = PIN_WIRE_SCL;
 
 #define PIN_WIRE1_SDA       (8u) // ATECC
 #define PIN_WIRE1_SCL       (9u) // ATECC
 #define PERIPH_WIRE1        sercom2 // sercom2 or sercom4
-#define WIRE1_IT_HANDLER    SERCOM2_Handler
+#define WIRE1_IT_HANDLER    SERCOM2_Wire_Handler // called by SERCOM2_Handler in variant.cpp
 static const uint8_t SDA1 = PIN_WIRE1_SDA;
 static const uint8_t SCL1 = PIN_WIRE1_SCL;
 
+// ATECC608 for ArduinoECCX08, keeps the clock of the shared bus
+#define CRYPTO_WIRE         Wire1
+#define CRYPTO_WIRE_CLOCK   100000
+
 // USB
 // ---
 #define PIN_USB_DM          (23u)
@@ -136,6 +140,7 @@ static const uint8_t SCL1 = PIN_WIRE1_SCL;
 #define WINC1501_CHIP_EN_PIN (10u) // enable pin
 #define WINC1501_INTN_PIN    (13u) // int pin
 #define WINC1501_SPI         SPI
+#define WINC1501_SPI_SERCOM  SERCOM1 // registers of WINC1501_SPI, block transfers
 #define WINC1501_SPI_CS_PIN  (14u) // cs pin
 
 // Needed for SD library
@@ -156,6 +161,29 @@ extern SERCOM sercom3;
 extern SERCOM sercom4;
 extern SERCOM sercom5;
 
+// Interrupt hooks for SERCOM0/SERCOM2, e.g. interrupt driven I2C (I2CQueue),
+// the Wire handler is called if not set
+extern void (*sercom0_handler)(void);
+extern void (*sercom2_handler)(void);
+
+// I2C bus arbitration for drivers using Wire/Wire1 directly, an interrupt
+// driven driver sharing the bus (I2CQueue) overrides the weak hooks in
+// variant.cpp to finish its own transfers first
+class TwoWire;
+void i2c_bus_acquire(TwoWire *wire);
+void i2c_bus_release(TwoWire *wire);
+
+// Holds the bus for the lifetime of the object
+class I2CBusLock
+{
+  public:
+    I2CBusLock(TwoWire *wire) : _wire(wire) { i2c_bus_acquire(_wire); }
+    ~I2CBusLock() { i2c_bus_release(_wire); }
+
+  private:
+    TwoWire *_wire;
+};
+
 // SERCOM3 oder SERCOM5 Serial1 UART RXTX1
 extern Uart Serial1;
 #define PIN_SERIAL1_RX (19u)